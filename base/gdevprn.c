@@ -109,51 +109,164 @@ gdev_prn_open(gx_device * pdev)
     return code;
 }
 
-/* This is called various places to wait for any pending bg print thread and */
-/* perform its cleanup                                                       */
+/* Wait for the page printing in background slot 'bg_print' (if any) and  */
+/* perform its cleanup                                                     */
 static void
-prn_finish_bg_print(gx_device_printer *ppdev)
+prn_finish_bg_print_slot(gx_device_printer *ppdev, bg_print_t *bg_print)
 {
     /* if we have a a bg printing device that was created, then wait for its	*/
     /* semaphore (it may already have been signalled, but that's OK.) then	*/
     /* close and unlink the files and free the device and its private allocator	*/
-    if (ppdev->bg_print && (ppdev->bg_print->device != NULL)) {
+    if (bg_print->device != NULL) {
         int closecode;
-        gx_device_printer *bgppdev = (gx_device_printer *)ppdev->bg_print->device;
-
-        gx_semaphore_wait(ppdev->bg_print->sema);
-        /* If numcopies > 1, then the bg_print->device will have closed and reopened
-         * the output file, so the pointer in the original device is now stale,
-         * so copy it back.
-         * If numcopies == 1, this is pointless, but benign.
-         */
-        ppdev->file = bgppdev->file;
-        closecode = gdev_prn_close_printer((gx_device *)ppdev);
-        if (ppdev->bg_print->return_code == 0)
-            ppdev->bg_print->return_code = closecode;	/* return code here iff there wasn't another error */
-        teardown_device_and_mem_for_thread(ppdev->bg_print->device,
-                                           ppdev->bg_print->thread_id, true);
-        ppdev->bg_print->device = NULL;
-        if (ppdev->bg_print->ocfile) {
-            closecode = ppdev->bg_print->oio_procs->fclose(ppdev->bg_print->ocfile, ppdev->bg_print->ocfname, true);
-            if (ppdev->bg_print->return_code == 0)
-               ppdev->bg_print->return_code = closecode;
+        gx_device_printer *bgppdev = (gx_device_printer *)bg_print->device;
+
+        gx_semaphore_wait(bg_print->sema);
+        if (bg_print->owns_file) {
+            /* The page was given its own output file (see BGPrintPages), */
+            /* which the foreground device has already let go of.         */
+            closecode = gx_device_close_output_file((gx_device *)ppdev, bgppdev->fname, bgppdev->file);
+            bgppdev->file = NULL;
+            bg_print->owns_file = false;
+        } else {
+            /* If numcopies > 1, then the bg_print->device will have closed and reopened
+             * the output file, so the pointer in the original device is now stale,
+             * so copy it back.
+             * If numcopies == 1, this is pointless, but benign.
+             */
+            ppdev->file = bgppdev->file;
+            closecode = gdev_prn_close_printer((gx_device *)ppdev);
         }
-        if (ppdev->bg_print->ocfname) {
-            gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print->ocfname, "prn_finish_bg_print(ocfname)");
+        if (bg_print->return_code == 0)
+            bg_print->return_code = closecode;	/* return code here iff there wasn't another error */
+        /* The page was rendered by the background device, so the band height */
+        /* for the pages to come is chosen there and handed back.            */
+        if (((gx_device_clist_common *)ppdev)->band_params.adaptive) {
+            gx_device_clist_common *cdev = (gx_device_clist_common *)ppdev;
+            gx_device_clist_common *bgcdev = (gx_device_clist_common *)bgppdev;
+
+            bgcdev->next_band_height = cdev->next_band_height;
+            clist_choose_next_band_height((gx_device_clist_reader *)bgppdev);
+            cdev->next_band_height = bgcdev->next_band_height;
         }
-        if (ppdev->bg_print->obfile) {
-            closecode = ppdev->bg_print->oio_procs->fclose(ppdev->bg_print->obfile, ppdev->bg_print->obfname, true);
-            if (ppdev->bg_print->return_code == 0)
-               ppdev->bg_print->return_code = closecode;
+        teardown_device_and_mem_for_thread(bg_print->device,
+                                           bg_print->thread_id, true);
+        bg_print->device = NULL;
+        if (bg_print->ocfile) {
+            closecode = bg_print->oio_procs->fclose(bg_print->ocfile, bg_print->ocfname, true);
+            if (bg_print->return_code == 0)
+               bg_print->return_code = closecode;
         }
-        if (ppdev->bg_print->obfname) {
-            gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print->obfname, "prn_finish_bg_print(obfname)");
+        if (bg_print->ocfname) {
+            gs_free_object(ppdev->memory->non_gc_memory, bg_print->ocfname, "prn_finish_bg_print(ocfname)");
         }
-        ppdev->bg_print->ocfile = ppdev->bg_print->obfile =
-          ppdev->bg_print->ocfname = ppdev->bg_print->obfname = NULL;
+        if (bg_print->obfile) {
+            closecode = bg_print->oio_procs->fclose(bg_print->obfile, bg_print->obfname, true);
+            if (bg_print->return_code == 0)
+               bg_print->return_code = closecode;
+        }
+        if (bg_print->obfname) {
+            gs_free_object(ppdev->memory->non_gc_memory, bg_print->obfname, "prn_finish_bg_print(obfname)");
+        }
+        bg_print->ocfile = bg_print->obfile =
+          bg_print->ocfname = bg_print->obfname = NULL;
     }
 }
+
+/* This is called various places to wait for any pending bg print threads */
+/* and perform their cleanup                                             */
+static void
+prn_finish_bg_print(gx_device_printer *ppdev)
+{
+    bg_print_t *bg_print;
+
+    for (bg_print = ppdev->bg_print; bg_print != NULL; bg_print = bg_print->next)
+        prn_finish_bg_print_slot(ppdev, bg_print);
+}
+
+/* Free the extra slots used when more than one page is printed in the */
+/* background. The pages must already have been finished.             */
+static void
+prn_free_bg_print_slots(gx_device_printer *ppdev)
+{
+    bg_print_t *bg_print, *next;
+
+    if (ppdev->bg_print == NULL)
+        return;
+    for (bg_print = ppdev->bg_print->next; bg_print != NULL; bg_print = next) {
+        next = bg_print->next;
+        if (bg_print->sema != NULL)
+            gx_semaphore_free(bg_print->sema);
+        gs_free_object(ppdev->memory->non_gc_memory, bg_print, "prn_free_bg_print_slots");
+    }
+    ppdev->bg_print->next = NULL;
+}
+
+/* Return the first error reported by a finished background page, or 0. */
+static int
+prn_bg_print_error(gx_device_printer *ppdev)
+{
+    bg_print_t *bg_print;
+
+    for (bg_print = ppdev->bg_print; bg_print != NULL; bg_print = bg_print->next)
+        if (bg_print->device == NULL && bg_print->return_code < 0)
+            return bg_print->return_code;
+    return 0;
+}
+
+/*
+ * Select the background printing slot for the page about to be output.
+ * Normally there is only one page printing in the background, and we wait
+ * for it here. With BGPrintPages > 1, and each page going to its own output
+ * file, up to that many pages may be rendered and written concurrently while
+ * the interpreter carries on with the following pages: we only wait for the
+ * oldest page when all of the slots are busy.
+ */
+static bool
+prn_bg_print_multi_page(gx_device_printer *ppdev)
+{
+    return ppdev->bg_print != NULL && ppdev->bg_print_requested &&
+           ppdev->bg_print_pages_requested > 1 &&
+           gx_outputfile_is_separate_pages(ppdev->fname, ppdev->memory);
+}
+
+static bg_print_t *
+prn_get_bg_print_slot(gx_device_printer *ppdev)
+{
+    bg_print_t *bg_print, *last = NULL, *oldest = NULL;
+    int count = 0;
+
+    if (!prn_bg_print_multi_page(ppdev)) {
+        prn_finish_bg_print(ppdev);
+        return ppdev->bg_print;
+    }
+    /* A page started before BGPrintPages or OutputFile changed still */
+    /* shares the foreground's output file, so it has to finish first. */
+    for (bg_print = ppdev->bg_print; bg_print != NULL; bg_print = bg_print->next)
+        if (bg_print->device != NULL && !bg_print->owns_file)
+            prn_finish_bg_print_slot(ppdev, bg_print);
+    for (bg_print = ppdev->bg_print; bg_print != NULL; bg_print = bg_print->next) {
+        if (bg_print->device == NULL)
+            return bg_print;
+        if (oldest == NULL || bg_print->page_count < oldest->page_count)
+            oldest = bg_print;
+        last = bg_print;
+        count++;
+    }
+    if (count < ppdev->bg_print_pages_requested) {
+        bg_print = (bg_print_t *)gs_alloc_bytes(ppdev->memory->non_gc_memory, sizeof(bg_print_t),
+                                                "prn_get_bg_print_slot");
+        if (bg_print != NULL) {
+            memset(bg_print, 0, sizeof(bg_print_t));
+            last->next = bg_print;
+            return bg_print;
+        }
+        /* not fatal, just wait for a page to finish */
+    }
+    prn_finish_bg_print_slot(ppdev, oldest);
+    return oldest;
+}
+
 /* Generic closing for the printer device. */
 /* Specific devices may wish to extend this. */
 int
@@ -163,6 +276,7 @@ gdev_prn_close(gx_device * pdev)
     int code = 0;
 
     prn_finish_bg_print(ppdev);
+    prn_free_bg_print_slots(ppdev);
     if (ppdev->bg_print != NULL && ppdev->bg_print->sema != NULL) {
         gx_semaphore_free(ppdev->bg_print->sema);
         ppdev->bg_print->sema = NULL;		/* prevent double free */
@@ -237,6 +351,9 @@ gdev_prn_tear_down(gx_device *pdev, byte **the_memory)
         gs_free_object(pcldev->memory->non_gc_memory, pcldev->cache_chunk, "free tile cache for clist");
         pcldev->cache_chunk = 0;
 
+        /* Any background printing threads sharing this are finished. */
+        clist_free_band_render_cache(pcldev);
+
         rc_decrement(pcldev->icc_cache_cl, "gdev_prn_tear_down");
         pcldev->icc_cache_cl = NULL;
 
@@ -246,8 +363,10 @@ gdev_prn_tear_down(gx_device *pdev, byte **the_memory)
         /* If the clist is a reader clist, free any color_usage_array
          * memory used by same.
          */
-        if (!CLIST_IS_WRITER(pclist_dev))
+        if (!CLIST_IS_WRITER(pclist_dev)) {
             gs_free_object(pcrdev->memory, pcrdev->color_usage_array, "clist_color_usage_array");
+            clist_free_band_hashes(pcrdev);
+        }
 
     } else {
         /* point at the device bitmap, no need to close mem dev */
@@ -291,6 +410,7 @@ gdev_prn_allocate(gx_device *pdev, gdev_space_params *new_space_params,
 
 
     /* bg_print allocation is not fatal, we just continue (as far as possible) without BGPrint */
+    prn_free_bg_print_slots(ppdev);
     if (ppdev->bg_print == NULL)
         ppdev->bg_print = (bg_print_t *)gs_alloc_bytes(pdev->memory->non_gc_memory, sizeof(bg_print_t), "prn bg_print");
     if (ppdev->bg_print == NULL) {
@@ -511,6 +631,7 @@ gdev_prn_allocate(gx_device *pdev, gdev_space_params *new_space_params,
         code = ecode;
     }
     if (code < 0) {
+          prn_free_bg_print_slots(ppdev);
           gs_free_object(pdev->memory->non_gc_memory, ppdev->bg_print, "prn bg_print");
           ppdev->bg_print = NULL;
     }
@@ -545,6 +666,7 @@ gdev_prn_free_memory(gx_device *pdev)
          ppdev->buffer_memory);
 
     gdev_prn_tear_down(pdev, &the_memory);
+    prn_free_bg_print_slots(ppdev);
     gs_free_object(pdev->memory->non_gc_memory, ppdev->bg_print, "gdev_prn_free_memory");
     ppdev->bg_print = NULL;
     gs_free_object(buffer_memory, the_memory, "gdev_prn_free_memory");
@@ -590,6 +712,18 @@ gdev_prn_get_param(gx_device *dev, char *Param, void *list)
     if (strcmp(Param, "BGPrint") == 0) {
         return param_write_bool(plist, "BGPrint", &ppdev->bg_print_requested);
     }
+    if (strcmp(Param, "AdaptiveBandHeight") == 0) {
+        return param_write_bool(plist, "AdaptiveBandHeight", &ppdev->space_params.band.adaptive);
+    }
+    if (strcmp(Param, "BandRenderCacheSize") == 0) {
+        return param_write_size_t(plist, "BandRenderCacheSize", &ppdev->space_params.band.render_cache_size);
+    }
+    if (strcmp(Param, "BandListStats") == 0) {
+        return param_write_bool(plist, "BandListStats", &ppdev->space_params.band.report_stats);
+    }
+    if (strcmp(Param, "BGPrintPages") == 0) {
+        return param_write_int(plist, "BGPrintPages", &ppdev->bg_print_pages_requested);
+    }
     if (strcmp(Param, "ReopenPerPage") == 0) {
         return param_write_bool(plist, "ReopenPerPage", &ppdev->ReopenPerPage);
     }
@@ -610,6 +744,15 @@ gdev_prn_get_param(gx_device *dev, char *Param, void *list)
         }
         return param_write_string(plist, "BandListStorage", &bls);
     }
+    if (strcmp(Param, "BandListCompression") == 0) {
+        gs_param_string blc;
+
+        if (ppdev->space_params.band.compression == BandListCompressAlways)
+            param_string_from_string(blc, "always");
+        else
+            param_string_from_string(blc, "auto");
+        return param_write_string(plist, "BandListCompression", &blc);
+    }
     if (strcmp(Param, "OutputFile") == 0) {
         gs_param_string ofns;
 
@@ -642,7 +785,7 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
     gx_device_printer * const ppdev = (gx_device_printer *)pdev;
     int code = gx_default_get_params(pdev, plist);
     gs_param_string ofns;
-    gs_param_string bls;
+    gs_param_string bls, blc;
     gs_param_string saved_pages;
     bool pageneutralcolor = false;
     gs_lib_ctx_core_t *core = pdev->memory->gs_lib_ctx->core;
@@ -657,7 +800,11 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
         (code = param_write_int(plist, "NumRenderingThreads", &ppdev->num_render_threads_requested)) < 0 ||
         (code = param_write_bool(plist, "OpenOutputFile", &ppdev->OpenOutputFile)) < 0 ||
         (code = param_write_bool(plist, "BGPrint", &ppdev->bg_print_requested)) < 0 ||
+        (code = param_write_int(plist, "BGPrintPages", &ppdev->bg_print_pages_requested)) < 0 ||
         (code = param_write_bool(plist, "ReopenPerPage", &ppdev->ReopenPerPage)) < 0 ||
+        (code = param_write_bool(plist, "AdaptiveBandHeight", &ppdev->space_params.band.adaptive)) < 0 ||
+        (code = param_write_size_t(plist, "BandRenderCacheSize", &ppdev->space_params.band.render_cache_size)) < 0 ||
+        (code = param_write_bool(plist, "BandListStats", &ppdev->space_params.band.report_stats)) < 0 ||
         (code = param_write_bool(plist, "pageneutralcolor", &pageneutralcolor)) < 0
         )
         return code;
@@ -677,6 +824,13 @@ gdev_prn_get_params(gx_device * pdev, gs_param_list * plist)
     if( (code = param_write_string(plist, "BandListStorage", &bls)) < 0 )
         return code;
 
+    if (ppdev->space_params.band.compression == BandListCompressAlways)
+        param_string_from_string(blc, "always");
+    else
+        param_string_from_string(blc, "auto");
+    if ((code = param_write_string(plist, "BandListCompression", &blc)) < 0)
+        return code;
+
     ofns.data = (const byte *)ppdev->fname,
         ofns.size = strlen(ppdev->fname),
         ofns.persistent = false;
@@ -713,6 +867,9 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     bool is_open = pdev->is_open;
     bool oof = ppdev->OpenOutputFile;
     bool rpp = ppdev->ReopenPerPage;
+    bool abh = ppdev->space_params.band.adaptive;
+    size_t brcs = ppdev->space_params.band.render_cache_size;
+    bool bstats = ppdev->space_params.band.report_stats;
     bool old_page_uses_transparency = ppdev->page_uses_transparency;
     bool bg_print_requested = ppdev->bg_print_requested;
     bool duplex;
@@ -720,9 +877,10 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     int width = pdev->width;
     int height = pdev->height;
     int nthreads = ppdev->num_render_threads_requested;
+    int bg_print_pages = ppdev->bg_print_pages_requested;
     gdev_space_params save_sp;
     gs_param_string ofs;
-    gs_param_string bls;
+    gs_param_string bls, blc;
     gs_param_dict mdict;
     gs_param_string saved_pages;
     bool pageneutralcolor = false;
@@ -749,6 +907,33 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
             break;
     }
 
+    switch (code = param_read_bool(plist, (param_name = "AdaptiveBandHeight"), &abh)) {
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 0:
+        case 1:
+            break;
+    }
+
+    switch (code = param_read_size_t(plist, (param_name = "BandRenderCacheSize"), &brcs)) {
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 0:
+        case 1:
+            break;
+    }
+
+    switch (code = param_read_bool(plist, (param_name = "BandListStats"), &bstats)) {
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 0:
+        case 1:
+            break;
+    }
+
     if (ppdev->Duplex_set >= 0)	/* i.e., Duplex is supported */
         switch (code = param_read_bool(plist, (param_name = "Duplex"),
                                        &duplex)) {
@@ -780,6 +965,21 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
             bls.data = 0;
             break;
     }
+    switch (code = param_read_string(plist, (param_name = "BandListCompression"), &blc)) {
+        case 0:
+            if (!bytes_compare(blc.data, blc.size, (const byte *)"auto", 4) ||
+                !bytes_compare(blc.data, blc.size, (const byte *)"always", 6))
+                break;
+            code = gs_note_error(gs_error_rangecheck);
+            /* fall through */
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+            /* fall through */
+        case 1:
+            blc.data = 0;
+            break;
+    }
 
     switch (code = param_read_string(plist, (param_name = "OutputFile"), &ofs)) {
         case 0:
@@ -838,6 +1038,19 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
         case 1:
             break;
     }
+    switch (code = param_read_int(plist, (param_name = "BGPrintPages"), &bg_print_pages)) {
+        case 0:
+            if (bg_print_pages < 0) {
+                ecode = gs_error_rangecheck;
+                param_signal_error(plist, param_name, ecode);
+            }
+            break;
+        default:
+            ecode = code;
+            param_signal_error(plist, param_name, ecode);
+        case 1:
+            ;
+    }
 
     switch (code = param_read_string(plist, (param_name = "saved-pages"),
                                                         &saved_pages)) {
@@ -872,11 +1085,14 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     ppdev->ReopenPerPage = rpp;
 
     /* If BGPrint was previously true and it is being turned off, wait for the BG thread */
-    if (ppdev->bg_print_requested && !bg_print_requested) {
+    /* Likewise if fewer pages may now be printed at once */
+    if ((ppdev->bg_print_requested && !bg_print_requested) ||
+        bg_print_pages < ppdev->bg_print_pages_requested) {
         prn_finish_bg_print(ppdev);
     }
 
     ppdev->bg_print_requested = bg_print_requested;
+    ppdev->bg_print_pages_requested = bg_print_pages;
     if (duplex_set >= 0) {
         ppdev->Duplex = duplex;
         ppdev->Duplex_set = duplex_set;
@@ -885,6 +1101,13 @@ gdev_prn_put_params(gx_device * pdev, gs_param_list * plist)
     if (bls.data != 0) {
         ppdev->BLS_force_memory = (bls.data[0] == 'm');
     }
+    if (blc.data != 0) {
+        ppdev->space_params.band.compression =
+            (blc.size == 6 ? BandListCompressAlways : BandListCompressAuto);
+    }
+    ppdev->space_params.band.adaptive = abh;
+    ppdev->space_params.band.render_cache_size = brcs;
+    ppdev->space_params.band.report_stats = bstats;
 
     /* If necessary, free and reallocate the printer memory. */
     /* Formerly, would not reallocate if device is not open: */
@@ -950,8 +1173,9 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
     gs_devn_params *pdevn_params;
     int outcode = 0, errcode = 0, endcode, closecode = 0;
     int code;
+    bg_print_t *bg_print;
 
-    prn_finish_bg_print(ppdev);		/* finish any previous background printing */
+    bg_print = prn_get_bg_print_slot(ppdev);	/* finish any previous background printing */
 
     if (pdev->width < 1 || pdev->height < 1 || pdev->HWResolution[0] <= 0 || pdev->HWResolution[1] <= 0)
         return_error(gs_error_configurationerror);
@@ -977,12 +1201,12 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
             /* If there was an error, abort on this page -- no good way to handle this */
             /* but it means that the error will be reported AFTER another page was     */
             /* interpreted and written to clist files. FIXME: ???                      */
-            if (ppdev->bg_print && (ppdev->bg_print->return_code < 0)) {
-                outcode = ppdev->bg_print->return_code;
+            if (ppdev->bg_print && (code = prn_bg_print_error(ppdev)) < 0) {
+                outcode = code;
                 threads_enabled = 0;	/* and allow current page to try foreground */
             }
             /* Use 'while' instead of 'if' to avoid nesting */
-            while (ppdev->bg_print_requested && ppdev->bg_print && threads_enabled) {
+            while (ppdev->bg_print_requested && bg_print && threads_enabled) {
                 gx_device *ndev;
                 gx_device_printer *npdev;
                 gx_device_clist_reader *crdev = (gx_device_clist_reader *)ppdev;
@@ -994,27 +1218,27 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 /* We need to hang onto references to these files, so we can ensure the main file data
                  * gets freed with the correct allocator.
                  */
-                ppdev->bg_print->ocfname =
+                bg_print->ocfname =
                      (char *)gs_alloc_bytes(ppdev->memory->non_gc_memory,
                            strnlen(crdev->page_info.cfname, gp_file_name_sizeof - 1) + 1, "gdev_prn_output_page_aux(ocfname)");
-                ppdev->bg_print->obfname =
+                bg_print->obfname =
                      (char *)gs_alloc_bytes(ppdev->memory->non_gc_memory,
                            strnlen(crdev->page_info.bfname, gp_file_name_sizeof - 1) + 1,"gdev_prn_output_page_aux(ocfname)");
 
-                if (!ppdev->bg_print->ocfname || !ppdev->bg_print->obfname)
+                if (!bg_print->ocfname || !bg_print->obfname)
                     break;
 
-                strncpy(ppdev->bg_print->ocfname, crdev->page_info.cfname, strnlen(crdev->page_info.cfname, gp_file_name_sizeof - 1) + 1);
-                strncpy(ppdev->bg_print->obfname, crdev->page_info.bfname, strnlen(crdev->page_info.bfname, gp_file_name_sizeof - 1) + 1);
-                ppdev->bg_print->obfile = crdev->page_info.bfile;
-                ppdev->bg_print->ocfile = crdev->page_info.cfile;
-                ppdev->bg_print->oio_procs = crdev->page_info.io_procs;
+                strncpy(bg_print->ocfname, crdev->page_info.cfname, strnlen(crdev->page_info.cfname, gp_file_name_sizeof - 1) + 1);
+                strncpy(bg_print->obfname, crdev->page_info.bfname, strnlen(crdev->page_info.bfname, gp_file_name_sizeof - 1) + 1);
+                bg_print->obfile = crdev->page_info.bfile;
+                bg_print->ocfile = crdev->page_info.cfile;
+                bg_print->oio_procs = crdev->page_info.io_procs;
                 crdev->page_info.cfile = crdev->page_info.bfile = NULL;
 
-                if (ppdev->bg_print->sema == NULL)
+                if (bg_print->sema == NULL)
                 {
-                    ppdev->bg_print->sema = gx_semaphore_label(gx_semaphore_alloc(ppdev->memory->non_gc_memory), "BGPrint");
-                    if (ppdev->bg_print->sema == NULL)
+                    bg_print->sema = gx_semaphore_label(gx_semaphore_alloc(ppdev->memory->non_gc_memory), "BGPrint");
+                    if (bg_print->sema == NULL)
                         break;			/* couldn't create the semaphore */
                 }
 
@@ -1022,8 +1246,8 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 if (ndev == NULL) {
                     break;
                 }
-                ppdev->bg_print->device = ndev;
-                ppdev->bg_print->num_copies = num_copies;
+                bg_print->device = ndev;
+                bg_print->num_copies = num_copies;
                 npdev = (gx_device_printer *)ndev;
                 npdev->bg_print_requested = 0;
                 npdev->num_render_threads_requested = ppdev->num_render_threads_requested;
@@ -1036,14 +1260,21 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
 
                 /* Now start the thread to print the page */
                 if ((code = gp_thread_start(prn_print_page_in_background,
-                                            (void *)(ppdev->bg_print),
-                                            &(ppdev->bg_print->thread_id))) < 0) {
+                                            (void *)bg_print,
+                                            &(bg_print->thread_id))) < 0) {
                     /* Did not start cleanly - clean up is in print_foreground block below */
                     break;
                 }
-                gp_thread_label(ppdev->bg_print->thread_id, "BG print thread");
+                gp_thread_label(bg_print->thread_id, "BG print thread");
                 /* Page was succesfully started in bg_print mode */
                 print_foreground = 0;
+                bg_print->page_count = pdev->PageCount;
+                if (prn_bg_print_multi_page(ppdev)) {
+                    /* Several pages may be in flight, each with its own output */
+                    /* file: the background page closes this one when finished. */
+                    bg_print->owns_file = true;
+                    ppdev->file = NULL;
+                }
                 /* Now we need to set up the next page so it will use new clist files */
                 if ((code = clist_open(pdev)) < 0) 	/* this should do it */
                     /* OOPS! can't proceed with the next page */
@@ -1051,18 +1282,18 @@ gdev_prn_output_page_aux(gx_device * pdev, int num_copies, int flush, bool seeka
                 break;				/* exit the while loop */
             }
             if (print_foreground) {
-                if (ppdev->bg_print) {
-                     gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print->ocfname, "gdev_prn_output_page_aux(ocfname)");
-                     gs_free_object(ppdev->memory->non_gc_memory, ppdev->bg_print->obfname, "gdev_prn_output_page_aux(obfname)");
-                     ppdev->bg_print->ocfname = ppdev->bg_print->obfname = NULL;
+                if (bg_print) {
+                     gs_free_object(ppdev->memory->non_gc_memory, bg_print->ocfname, "gdev_prn_output_page_aux(ocfname)");
+                     gs_free_object(ppdev->memory->non_gc_memory, bg_print->obfname, "gdev_prn_output_page_aux(obfname)");
+                     bg_print->ocfname = bg_print->obfname = NULL;
 
                     /* either bg_print was not requested or was not able to start */
-                    if (ppdev->bg_print->sema != NULL && ppdev->bg_print->device != NULL) {
+                    if (bg_print->sema != NULL && bg_print->device != NULL) {
                         /* There was a problem. Teardown the device and its allocator, but */
                         /* leave the semaphore for possible later use.                     */
-                        teardown_device_and_mem_for_thread(ppdev->bg_print->device,
-                                                           ppdev->bg_print->thread_id, true);
-                        ppdev->bg_print->device = NULL;
+                        teardown_device_and_mem_for_thread(bg_print->device,
+                                                           bg_print->thread_id, true);
+                        bg_print->device = NULL;
                     }
                 }
                 /* Here's where we actually let the device's print_page_copies work */
@@ -1327,6 +1558,8 @@ gx_page_info_color_usage(const gx_device *dev,
     int band_height = page_info->band_params.BandHeight;
     gx_color_usage_bits or = 0;
     bool slow_rop = false;
+    gx_band_content_t content = gx_band_content_drawn;
+    gx_color_index solid_color = gx_no_color_index;
 
     if (y < 0 || height < 0 || height > dev->height - y)
         return -1;
@@ -1336,11 +1569,22 @@ gx_page_info_color_usage(const gx_device *dev,
         return -1;
     }
     for (i = start; i < end; ++i) {
-        or |= crdev->color_usage_array[i].or;
-        slow_rop |= crdev->color_usage_array[i].slow_rop;
+        const gx_color_usage_t *band_usage = &crdev->color_usage_array[i];
+
+        or |= band_usage->or;
+        slow_rop |= band_usage->slow_rop;
+        /* The range is only solid if every band is, with the same color. */
+        if (i == start) {
+            content = band_usage->content;
+            solid_color = band_usage->solid_color;
+        } else if (band_usage->content != content ||
+                   band_usage->solid_color != solid_color)
+            content = gx_band_content_drawn;
     }
     color_usage->or = or;
     color_usage->slow_rop = slow_rop;
+    color_usage->content = content;
+    color_usage->solid_color = solid_color;
     *range_start = start * band_height;
     return min(end * band_height, dev->height) - *range_start;
 }
@@ -1356,6 +1600,7 @@ gdev_prn_color_usage(gx_device *dev, int y, int height,
     if (!PRINTER_IS_CLIST(pdev)) {
         *range_start = 0;
         color_usage->or = gx_color_usage_all(dev);
+        color_usage->content = gx_band_content_drawn;
         return dev->height;
     }
     if (y < 0 || height < 0 || height > dev->height - y)
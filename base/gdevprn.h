@@ -124,6 +124,9 @@ typedef struct bg_print_s {
     char *obfname;	                /* block file name */
     clist_file_ptr obfile;	/* block file, normally 0 */
     const clist_io_procs_t *oio_procs;
+    long page_count;			/* PageCount of the page being printed */
+    bool owns_file;			/* output file belongs to this page (BGPrintPages > 1) */
+    struct bg_print_s *next;		/* further pages in flight (BGPrintPages > 1) */
 } bg_print_t;
 
 #define gx_prn_device_common\
@@ -142,6 +145,7 @@ typedef struct bg_print_s {
         gp_file *file;  		/* output file */\
         bool bg_print_requested;	/* request background printing of page from clist */\
         bg_print_t *bg_print;           /* background printing data shared with thread */\
+        int bg_print_pages_requested;	/* max pages printed at once in the background */\
         int num_render_threads_requested;	/* for multiple band rendering threads */\
         gx_saved_pages_list *saved_pages_list;	/* list when we are saving pages instead of printing */\
         gx_device_procs save_procs_while_delaying_erasepage	/* save device procs while delaying erasepage. */
@@ -221,6 +225,7 @@ prn_dev_proc_get_space_params(gx_default_get_space_params);
         0,	        /* *file */\
         0/*false*/,	/* bg_print_requested */\
         0,              /* *bg_print */\
+        0,              /* bg_print_pages_requested */\
         0, 		/* num_render_threads_requested */\
         0,              /* saved_pages_list */\
         { 0 }           /* save_procs_while_delaying_erasepage */
@@ -380,6 +385,10 @@ bool gdev_prn_file_is_new(const gx_device_printer *pdev);
  * On return the first Y value of the actual range is stored in
  * *range_start, and the height of the range is returned.
  * If the parameters are invalid, the procedure returns -1.
+ *
+ * If the content member is not gx_band_content_drawn, nothing but a page
+ * fill with solid_color went into the range, so process_page consumers
+ * can emit it as blank (or solid) rows without examining the buffer.
  */
 int gdev_prn_color_usage(gx_device *dev, int y, int height,
                          gx_color_usage_t *color_usage,
@@ -284,6 +284,14 @@ gp_fpwrite(void *buf, size_t count, gs_offset_t offset, gp_file *f) {
     return (f->ops.pwrite)(f, count, offset, buf);
 }
 
+/* Map the first len bytes of a file into memory for reading. Returns NULL
+ * if the file or the platform doesn't support this, in which case the
+ * caller should fall back to gp_fpread. The mapping must be released with
+ * gp_funmap before the file is closed or written to. */
+void *gp_fmmap(gp_file *f, size_t len);
+
+void gp_funmap(void *addr, size_t len);
+
 static inline int
 gp_file_is_char_buffered(gp_file *f) {
     if (f->ops.is_char_buffered == NULL)
@@ -639,6 +647,12 @@ int gp_pread_impl(char *buf, size_t count, gs_offset_t offset, FILE *f);
 
 int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f);
 
+/* Map the start of a FILE read-only into memory, or return NULL if this */
+/* is not supported. */
+void *gp_mmap_impl(FILE *f, size_t len);
+
+void gp_munmap_impl(void *addr, size_t len);
+
 gs_offset_t gp_ftell_impl(FILE *f);
 
 int gp_fseek_impl(FILE *strm, gs_offset_t offset, int origin);
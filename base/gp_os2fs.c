@@ -305,6 +305,15 @@ int gp_pwrite_impl(char *buf, size_t count, gs_offset_t offset, FILE *f)
     return -1;
 }
 
+void *gp_mmap_impl(FILE *f, size_t len)
+{
+    return NULL;
+}
+
+void gp_munmap_impl(void *addr, size_t len)
+{
+}
+
 /* -------------- Helpers for gp_file_name_combine_generic ------------- */
 
 uint gp_file_name_root(const char *fname, uint len)
@@ -32,6 +32,9 @@
 #include "dirent_.h"
 #include "unistd_.h"
 #include <stdlib.h>             /* for mkstemp/mktemp */
+#if defined(HAVE_MMAP_MUNMAP) && HAVE_MMAP_MUNMAP == 1
+#include <sys/mman.h>
+#endif
 
 #if !defined(HAVE_FSEEKO)
 #define ftello ftell
@@ -245,6 +248,32 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
 #endif
 }
 
+void *gp_mmap_impl(FILE *f, size_t len)
+{
+#if !defined(GS_NO_FILESYSTEM) && defined(HAVE_MMAP_MUNMAP) && HAVE_MMAP_MUNMAP == 1
+    void *addr;
+
+    fflush(f);          /* make sure any buffered writes are in the file */
+    addr = mmap(NULL, len, PROT_READ, MAP_SHARED, fileno(f), 0);
+    if (addr == MAP_FAILED)
+        return NULL;
+#ifdef MADV_WILLNEED
+    /* Start the kernel reading ahead while we get on with other things */
+    (void)madvise(addr, len, MADV_WILLNEED);
+#endif
+    return addr;
+#else
+    return NULL;
+#endif
+}
+
+void gp_munmap_impl(void *addr, size_t len)
+{
+#if !defined(GS_NO_FILESYSTEM) && defined(HAVE_MMAP_MUNMAP) && HAVE_MMAP_MUNMAP == 1
+    munmap(addr, len);
+#endif
+}
+
 /* Set a file into binary or text mode. */
 int
 gp_setmode_binary_impl(FILE * pfile, bool mode) /* lgtm [cpp/useless-expression] */
@@ -311,6 +311,15 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
     return -1;
 }
 
+void *gp_mmap_impl(FILE *f, size_t len)
+{
+    return NULL;
+}
+
+void gp_munmap_impl(void *addr, size_t len)
+{
+}
+
 /* Set a file into binary or text mode. */
 int
 gp_setmode_binary_impl(FILE * pfile, bool binary)
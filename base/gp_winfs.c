@@ -157,6 +157,16 @@ int gp_pwrite_impl(const char *buf, size_t count, gs_offset_t offset, FILE *f)
     return ret;
 }
 
+/* Mapping files is not supported (yet); callers fall back to pread */
+void *gp_mmap_impl(FILE *f, size_t len)
+{
+    return NULL;
+}
+
+void gp_munmap_impl(void *addr, size_t len)
+{
+}
+
 /* --------- 64 bit file access ----------- */
 /* MSVC versions before 8 doen't provide big files.
    MSVC 8 doesn't distinguish big and small files,
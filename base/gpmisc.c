@@ -684,6 +684,22 @@ int gp_file_FILE_set(gp_file *file_, FILE *f, int (*close)(FILE *))
     return 0;
 }
 
+void *gp_fmmap(gp_file *f, size_t len)
+{
+    FILE *file = gp_get_file(f);
+
+    /* Only files backed by a real FILE can be mapped */
+    if (file == NULL || len == 0)
+        return NULL;
+    return gp_mmap_impl(file, len);
+}
+
+void gp_funmap(void *addr, size_t len)
+{
+    if (addr != NULL)
+        gp_munmap_impl(addr, len);
+}
+
 char *gp_fgets(char *buffer, size_t n, gp_file *f)
 {
     int c = EOF;
@@ -1445,6 +1445,14 @@ gdev_space_params_cmp(const gdev_space_params sp1,
     return(1);
   if (sp1.band.tile_cache_size != sp2.band.tile_cache_size)
     return(1);
+  if (sp1.band.adaptive != sp2.band.adaptive)
+    return(1);
+  if (sp1.band.render_cache_size != sp2.band.render_cache_size)
+    return(1);
+  if (sp1.band.compression != sp2.band.compression)
+    return(1);
+  if (sp1.band.report_stats != sp2.band.report_stats)
+    return(1);
   if (sp1.params_are_read_only != sp2.params_are_read_only)
     return(1);
   if (sp1.banding_type != sp2.banding_type)
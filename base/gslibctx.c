@@ -436,6 +436,10 @@ void gs_lib_ctx_fin(gs_memory_t *mem)
     refs = --ctx->core->refs;
     gx_monitor_leave((gx_monitor_t *)(ctx->core->monitor));
     if (refs == 0) {
+        if (ctx->core->free_stroke_cache != NULL)
+            ctx->core->free_stroke_cache(ctx->core->memory, ctx->core->stroke_cache);
+        if (ctx->core->free_fill_thread_pool != NULL)
+            ctx->core->free_fill_thread_pool(ctx->core->memory, ctx->core->fill_thread_pool);
         gscms_destroy(ctx->core->cms_context);
         gx_monitor_free((gx_monitor_t *)(ctx->core->monitor));
 #ifdef WITH_CAL
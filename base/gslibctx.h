@@ -127,6 +127,12 @@ typedef struct {
      * for the clist based devices. */
     int CPSI_mode;
     int scanconverter;
+    int fill_threads;    /* extra threads for scan converting large fills, 0 = none */
+    void *fill_thread_pool;  /* created by gxscanc.c when first needed */
+    void (*free_fill_thread_pool)(gs_memory_t *mem, void *pool);
+    int adaptive_flattening; /* flatten curves adaptively, see gxpflat.c */
+    void *stroke_cache;  /* created by gxstroke.c when first needed */
+    void (*free_stroke_cache)(gs_memory_t *mem, void *cache);
     int act_on_uel;
 
     int path_control_active;
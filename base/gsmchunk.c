@@ -161,6 +161,17 @@ typedef struct chunk_slab_s {
     struct chunk_slab_s *next;
 } chunk_slab_t;
 
+/*
+ * An allocator used by a single thread can keep the large (single object)
+ * blocks that it frees, rather than returning them to the target, which is
+ * usually shared and locked. The blocks are kept on free lists by size
+ * class: each power of 2 above CHUNK_SIZE>>1 is split into 4 classes, so
+ * no more than a quarter of a block is wasted by the rounding.
+ */
+#define CHUNK_CLASS_MIN_LOG2 15		/* CHUNK_SIZE>>1 == 1 << 15 */
+#define CHUNK_CLASS_STEPS_LOG2 2
+#define CHUNK_NUM_CLASSES (12 << CHUNK_CLASS_STEPS_LOG2)	/* up to 128MB */
+
 typedef struct gs_memory_chunk_s {
     gs_memory_common;           /* interface outside world sees */
     gs_memory_t *target;        /* base allocator */
@@ -169,6 +180,9 @@ typedef struct gs_memory_chunk_s {
     chunk_free_node_t *free_loc; /* free tree */
     chunk_obj_node_t *defer_finalize_list;
     chunk_obj_node_t *defer_free_list;
+    chunk_obj_node_t *block_cache[CHUNK_NUM_CLASSES]; /* free large blocks */
+    size_t block_cache_size;	/* bytes held in block_cache */
+    size_t block_cache_max;	/* 0 means don't keep any */
     size_t used;
     size_t max_used;
     size_t total_free;
@@ -217,6 +231,9 @@ gs_memory_chunk_wrap(gs_memory_t **wrapped,      /* chunk allocator init */
     cmem->deferring = 0;
     cmem->defer_finalize_list = NULL;
     cmem->defer_free_list = NULL;
+    memset(cmem->block_cache, 0, sizeof(cmem->block_cache));
+    cmem->block_cache_size = 0;
+    cmem->block_cache_max = 0;
 
 #ifdef DEBUG_CHUNK_PRINT
     dmlprintf1(non_gc_target, "New chunk "PRI_INTPTR"\n", (intptr_t)cmem);
@@ -252,6 +269,19 @@ gs_memory_chunk_unwrap(gs_memory_t *mem)
     return tmem;
 }
 
+/* Let the allocator keep up to max_size bytes of freed large blocks for
+ * reuse. Only safe if the allocator is used by one thread at a time, as
+ * the chunk allocator always must be. */
+void
+gs_memory_chunk_set_block_cache(gs_memory_t *mem, size_t max_size)
+{
+#if !defined(MEMENTO) && !defined(SINGLE_OBJECT_MEMORY_BLOCKS_ONLY)
+    /* If this isn't a chunk, there is nothing to set */
+    if (mem->procs.status == chunk_status)
+        ((gs_memory_chunk_t *)mem)->block_cache_max = max_size;
+#endif
+}
+
 /* ---------- Accessors ------------- */
 
 /* Retrieve this allocator's target */
@@ -274,12 +304,21 @@ static void
 chunk_mem_node_free_all_slabs(gs_memory_chunk_t *cmem)
 {
     chunk_slab_t *slab, *next;
+    chunk_obj_node_t *obj;
     gs_memory_t *const target = cmem->target;
+    int i;
 
     for (slab = cmem->slabs; slab != NULL; slab = next) {
         next = slab->next;
         gs_free_object(target, slab, "chunk_mem_node_free_all_slabs");
     }
+    for (i = 0; i < CHUNK_NUM_CLASSES; i++) {
+        while ((obj = cmem->block_cache[i]) != NULL) {
+            cmem->block_cache[i] = obj->defer_next;
+            gs_free_object(target, obj, "chunk_mem_node_free_all_slabs");
+        }
+    }
+    cmem->block_cache_size = 0;
 
     cmem->slabs = NULL;
     cmem->free_size = NULL;
@@ -769,6 +808,62 @@ static void remove_free(gs_memory_chunk_t *cmem, chunk_free_node_t *node)
 #define SINGLE_OBJECT_CHUNK(size) ((size) > (CHUNK_SIZE>>1))
 #endif
 
+/* Return the block_cache class of a block of 'size' bytes, and the size
+ * of the blocks in that class, or -1 if it is too small or too large. */
+static int
+chunk_size_class(size_t size, size_t *class_size)
+{
+    int log2 = CHUNK_CLASS_MIN_LOG2;
+    size_t step, k;
+
+    if (size <= ((size_t)1 << CHUNK_CLASS_MIN_LOG2))
+        return -1;
+    while (((size_t)2 << log2) < size)
+        if (++log2 >= CHUNK_CLASS_MIN_LOG2 + (CHUNK_NUM_CLASSES >> CHUNK_CLASS_STEPS_LOG2))
+            return -1;
+    step = (size_t)1 << (log2 - CHUNK_CLASS_STEPS_LOG2);
+    k = (size - ((size_t)1 << log2) + step - 1) / step;
+    *class_size = ((size_t)1 << log2) + k * step;
+    return ((log2 - CHUNK_CLASS_MIN_LOG2) << CHUNK_CLASS_STEPS_LOG2) + (int)k - 1;
+}
+
+/* Round *psize up to its size class and take a block of that class from
+ * the block_cache, if there is one. */
+static chunk_obj_node_t *
+chunk_block_cache_get(gs_memory_chunk_t *cmem, size_t *psize)
+{
+    chunk_obj_node_t *obj;
+    size_t class_size;
+    int index;
+
+    if (cmem->block_cache_max == 0 || (index = chunk_size_class(*psize, &class_size)) < 0)
+        return NULL;
+    *psize = class_size;
+    obj = cmem->block_cache[index];
+    if (obj != NULL) {
+        cmem->block_cache[index] = obj->defer_next;
+        cmem->block_cache_size -= class_size;
+    }
+    return obj;
+}
+
+/* Keep a large block in the block_cache, if there is room. */
+static bool
+chunk_block_cache_put(gs_memory_chunk_t *cmem, chunk_obj_node_t *obj)
+{
+    size_t class_size;
+    int index;
+
+    if (cmem->block_cache_size + obj->size > cmem->block_cache_max ||
+        (index = chunk_size_class(obj->size, &class_size)) < 0 ||
+        class_size != obj->size)
+        return false;
+    obj->defer_next = cmem->block_cache[index];
+    cmem->block_cache[index] = obj;
+    cmem->block_cache_size += obj->size;
+    return true;
+}
+
 /* All of the allocation routines reduce to this function */
 static byte *
 chunk_obj_alloc(gs_memory_t *mem, size_t size, gs_memory_type_ptr_t type, client_name_t cname)
@@ -804,7 +899,9 @@ chunk_obj_alloc(gs_memory_t *mem, size_t size, gs_memory_type_ptr_t type, client
 
     /* Large blocks are allocated directly */
     if (SINGLE_OBJECT_CHUNK(size)) {
-        obj = (chunk_obj_node_t *)gs_alloc_bytes_immovable(cmem->target, newsize, cname);
+        obj = chunk_block_cache_get(cmem, &newsize);
+        if (obj == NULL)
+            obj = (chunk_obj_node_t *)gs_alloc_bytes_immovable(cmem->target, newsize, cname);
         if (obj == NULL)
             return NULL;
     } else {
@@ -1119,7 +1216,8 @@ chunk_free_object(gs_memory_t *mem, void *ptr, client_name_t cname)
     cmem->used -= obj->size;
 
     if (SINGLE_OBJECT_CHUNK(obj->size - obj->padding)) {
-        gs_free_object(cmem->target, obj, "chunk_free_object(single object)");
+        if (!chunk_block_cache_put(cmem, obj))
+            gs_free_object(cmem->target, obj, "chunk_free_object(single object)");
 #ifdef DEBUG_CHUNK
         gs_memory_chunk_dump_memory(cmem);
 #endif
@@ -40,6 +40,11 @@ void gs_memory_chunk_release(gs_memory_t *cmem);
 gs_memory_t * /* Always succeeds */
 gs_memory_chunk_unwrap(gs_memory_t *mem);
 
+/* Keep up to max_size bytes of freed large blocks for reuse rather than
+ * returning them to the target. For allocators private to one thread,
+ * this avoids the (locked) target for repeated large allocations. */
+void gs_memory_chunk_set_block_cache(gs_memory_t *cmem, size_t max_size);
+
 /* ---------- Accessors ------------- */
 
 /* Retrieve this allocator's target */
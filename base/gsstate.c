@@ -798,6 +798,42 @@ gs_getscanconverter(const gs_memory_t * mem)
     return libctx->core->scanconverter;
 }
 
+/* setfillthreads */
+void
+gs_setfillthreads(gs_memory_t * mem, int threads)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(mem);
+
+    libctx->core->fill_threads = threads < 0 ? 0 : threads;
+}
+
+/* getfillthreads */
+int
+gs_getfillthreads(const gs_memory_t * mem)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return libctx->core->fill_threads;
+}
+
+/* setadaptiveflattening */
+void
+gs_setadaptiveflattening(gs_memory_t * mem, bool adaptive)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(mem);
+
+    libctx->core->adaptive_flattening = adaptive;
+}
+
+/* getadaptiveflattening */
+bool
+gs_getadaptiveflattening(const gs_memory_t * mem)
+{
+    gs_lib_ctx_t *libctx = gs_lib_ctx_get_interp_instance(mem);
+
+    return libctx->core->adaptive_flattening;
+}
+
 /* setrenderingintent
  *
  *  Use ICC numbers from Table 18 (section 6.1.11) rather than the PDF order
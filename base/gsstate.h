@@ -65,6 +65,10 @@ void gs_setcpsimode(gs_memory_t *, bool);
 
 int gs_getscanconverter(const gs_memory_t *);
 void gs_setscanconverter(gs_gstate *, int);
+int gs_getfillthreads(const gs_memory_t *);
+void gs_setfillthreads(gs_memory_t *, int);
+bool gs_getadaptiveflattening(const gs_memory_t *);
+void gs_setadaptiveflattening(gs_memory_t *, bool);
 
 /* Device control */
 #include "gsdevice.h"
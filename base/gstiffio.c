@@ -33,14 +33,6 @@
 #define TIFF_PRINT_BUF_LENGTH 1024
 static const char tifs_msg_truncated[] = "\n*** Previous line has been truncated.\n";
 
-/* place to hold the data for our libtiff i/o hooks
- */
-typedef struct tifs_io_private_t
-{
-    gp_file *f;
-    gs_memory_t *memory;
-} tifs_io_private;
-
 /* libtiff i/o hooks */
 static int
 gs_tifsDummyMapProc(thandle_t fd, void** pbase, toff_t* psize)
@@ -170,6 +162,112 @@ tiff_from_filep(gx_device_printer *dev,  const char *name, gp_file *filep, int b
     return t;
 }
 
+/* libtiff i/o hooks for an in-memory TIFF */
+static tmsize_t
+gs_tifsMemReadProc(thandle_t fd, void *buf, tmsize_t size)
+{
+    tiff_mem_file_t *f = (tiff_mem_file_t *)fd;
+
+    if (f->pos >= f->size)
+        return 0;
+    if (size > f->size - f->pos)
+        size = f->size - f->pos;
+    memcpy(buf, f->data + f->pos, size);
+    f->pos += size;
+    return size;
+}
+
+static tmsize_t
+gs_tifsMemWriteProc(thandle_t fd, void *buf, tmsize_t size)
+{
+    tiff_mem_file_t *f = (tiff_mem_file_t *)fd;
+    gs_memory_t *mem = f->io.memory;
+
+    if (f->pos + size > f->alloc) {
+        size_t alloc = max(f->alloc * 2, 65536);
+        byte *data;
+
+        if (alloc < f->pos + size)
+            alloc = f->pos + size;
+        data = gs_alloc_bytes(mem, alloc, "gs_tifsMemWriteProc");
+        if (data == NULL)
+            return -1;
+        if (f->size)
+            memcpy(data, f->data, f->size);
+        gs_free_object(mem, f->data, "gs_tifsMemWriteProc");
+        f->data = data;
+        f->alloc = alloc;
+    }
+    if (f->pos > f->size)
+        memset(f->data + f->size, 0, f->pos - f->size);
+    memcpy(f->data + f->pos, buf, size);
+    f->pos += size;
+    if (f->pos > f->size)
+        f->size = f->pos;
+    return size;
+}
+
+static toff_t
+gs_tifsMemSeekProc(thandle_t fd, toff_t off, int whence)
+{
+    tiff_mem_file_t *f = (tiff_mem_file_t *)fd;
+
+    switch (whence) {
+        case SEEK_SET:
+            f->pos = off;
+            break;
+        case SEEK_CUR:
+            f->pos += off;
+            break;
+        case SEEK_END:
+            f->pos = f->size + off;
+            break;
+    }
+    return f->pos;
+}
+
+static int
+gs_tifsMemCloseProc(thandle_t fd)
+{
+    /* The data is kept until tiff_mem_file_free. */
+    (void) fd;
+    return 0;
+}
+
+static toff_t
+gs_tifsMemSizeProc(thandle_t fd)
+{
+    return ((tiff_mem_file_t *)fd)->size;
+}
+
+/* Open a TIFF for writing into *file, emptying it first. The file must
+ * have been set up with tiff_mem_file_init. */
+TIFF *
+tiff_from_mem_file(tiff_mem_file_t *file, const char *name, int big_endian)
+{
+    file->pos = file->size = 0;
+    return TIFFClientOpen(name, big_endian ? "wb" : "wl",
+        (thandle_t) file, gs_tifsMemReadProc,
+        gs_tifsMemWriteProc, gs_tifsMemSeekProc,
+        gs_tifsMemCloseProc, gs_tifsMemSizeProc, gs_tifsDummyMapProc,
+        gs_tifsDummyUnmapProc);
+}
+
+void
+tiff_mem_file_init(tiff_mem_file_t *file, gs_memory_t *memory)
+{
+    memset(file, 0, sizeof(*file));
+    file->io.memory = memory;
+}
+
+void
+tiff_mem_file_free(tiff_mem_file_t *file)
+{
+    gs_free_object(file->io.memory, file->data, "gs_tifsMemWriteProc");
+    file->data = NULL;
+    file->size = file->alloc = file->pos = 0;
+}
+
 int tiff_filename_from_tiff(TIFF *t, char **name)
 {
     *name = (char *)TIFFFileName(t);
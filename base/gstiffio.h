@@ -20,9 +20,32 @@
 #include <tiffvers.h>
 #include "gdevprn.h"
 
+/* place to hold the data for our libtiff i/o hooks. This is also what
+ * the error and warning handlers expect as the client data of any TIFF
+ * we open.
+ */
+typedef struct tifs_io_private_t
+{
+    gp_file *f;
+    gs_memory_t *memory;
+} tifs_io_private;
+
+/* An in-memory TIFF. io.f is not used. */
+typedef struct tiff_mem_file_s
+{
+    tifs_io_private io;     /* Must be first */
+    byte *data;
+    size_t size;
+    size_t alloc;
+    size_t pos;
+} tiff_mem_file_t;
+
 TIFF *
 tiff_from_filep(gx_device_printer *dev,  const char *name, gp_file *filep, int big_endian, bool usebigtiff);
 void tiff_set_handlers (void);
 int tiff_filename_from_tiff(TIFF *t, char **name);
+void tiff_mem_file_init(tiff_mem_file_t *file, gs_memory_t *memory);
+TIFF *tiff_from_mem_file(tiff_mem_file_t *file, const char *name, int big_endian);
+void tiff_mem_file_free(tiff_mem_file_t *file);
 
 #endif /* gstiffio_INCLUDED */
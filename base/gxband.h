@@ -32,6 +32,19 @@ typedef gx_color_index gx_color_usage_bits;
 
 gx_color_usage_bits gx_color_index2usage(gx_device *dev, gx_color_index);
 
+/*
+ * Define what the clist writer knows about the contents of a band.
+ * Anything other than gx_band_content_drawn means that nothing has been
+ * drawn into the band since the last fillpage, which used a pure color,
+ * so the band can be produced by filling it with that color instead of
+ * running its commands through the rasterizer.
+ */
+typedef enum {
+    gx_band_content_drawn = 0,	/* band must be rendered */
+    gx_band_content_solid,	/* only a fillpage with solid_color */
+    gx_band_content_blank	/* as above, and solid_color is white */
+} gx_band_content_t;
+
 /*
  * Define information about the colors used on a page.
  */
@@ -41,6 +54,8 @@ typedef struct gx_colors_usage_s {
                                 /* executed plane-by-plane on CMYK devices */
     gs_int_rect trans_bbox;	/* transparency bbox allows skipping the pdf14 compositor for some bands */
                                 /* coordinates are band relative, 0 <= p.y < page_info.band_params.BandHeight */
+    gx_band_content_t content;	/* see above */
+    gx_color_index solid_color;	/* only meaningful if content != drawn */
 } gx_color_usage_t;
 
 /*
@@ -410,7 +410,9 @@ struct gx_clist_state_s {
         { 0, 0 }, /* cmd_list */\
         { 0, /* or */\
           0, /* slow rop */\
-          { { max_int, max_int }, /* p */ { min_int, min_int } /* q */ } /* trans_bbox */\
+          { { max_int, max_int }, /* p */ { min_int, min_int } /* q */ }, /* trans_bbox */\
+          gx_band_content_drawn, /* content */\
+          gx_no_color_index /* solid_color */\
         } /* color_usage */
 
 /* Define the size of the command buffer used for reading. */
@@ -886,6 +888,7 @@ int clist_read_icctable(gx_device_clist_reader *crdev);
 int clist_read_color_usage_array(gx_device_clist_reader *crdev);
 int clist_read_op_equiv_cmyk_colors(gx_device_clist_reader *crdev,
     equivalent_cmyk_color_params *op_equiv);
+int clist_read_band_costs(gx_device_clist_reader *crdev, int64_t *costs);
 
 /* Special write out for the serialized icc profile table */
 
@@ -30,10 +30,16 @@
 /* This is an implementation of the command list I/O interface */
 /* that uses the file system for storage. */
 
+/* Where the platform supports it, a file is mapped into memory the first */
+/* time it is read, so that band playback doesn't have to go through the */
+/* read cache below. Writing to the file drops the mapping. Files that fit */
+/* in a single cache slot aren't worth mapping. */
+
 /* clist cache code so that wrapped files don't incur a performance penalty */
 #define CL_CACHE_NSLOTS (3)
 #define CL_CACHE_SLOT_SIZE_LOG2 (15)
 #define CL_CACHE_SLOT_EMPTY (-1)
+#define CL_MAP_MIN_SIZE (1 << CL_CACHE_SLOT_SIZE_LOG2)
 
 static clist_io_procs_t clist_io_procs_file;
 
@@ -229,6 +235,9 @@ typedef struct
     int64_t pos;
     int64_t filesize;		/* filesize maintained by clist_fwrite */
     CL_CACHE *cache;
+    byte *map;			/* read-only mapping of the file, or NULL */
+    int64_t map_size;
+    bool map_failed;		/* don't retry until the file is written */
 } IFILE;
 
 static void
@@ -262,13 +271,42 @@ static IFILE *wrap_file(gs_memory_t *mem, gp_file *f, const char *fmode)
     ifile->pos = 0;
     ifile->filesize = 0;
     ifile->cache = cl_cache_alloc(ifile->mem);
+    ifile->map = NULL;
+    ifile->map_size = 0;
+    ifile->map_failed = false;
     return ifile;
 }
 
+/* Map the whole file for reading, if possible. */
+static void
+clist_map_file(IFILE *ifile)
+{
+    if (ifile->filesize < CL_MAP_MIN_SIZE || ifile->filesize > max_size_t)
+        ifile->map = NULL;
+    else
+        ifile->map = gp_fmmap(ifile->f, (size_t)ifile->filesize);
+    if (ifile->map != NULL)
+        ifile->map_size = ifile->filesize;
+    else
+        ifile->map_failed = true;
+}
+
+static void
+clist_unmap_file(IFILE *ifile)
+{
+    if (ifile->map != NULL) {
+        gp_funmap(ifile->map, (size_t)ifile->map_size);
+        ifile->map = NULL;
+        ifile->map_size = 0;
+    }
+    ifile->map_failed = false;
+}
+
 static int clist_close_file(IFILE *ifile)
 {
     int res = 0;
     if (ifile) {
+        clist_unmap_file(ifile);
         if (ifile->f != NULL)
             res = gp_fclose(ifile->f);
         if (ifile->cache != NULL)
@@ -283,7 +321,7 @@ static int clist_close_file(IFILE *ifile)
 static int
 clist_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             clist_file_ptr * pcf, gs_memory_t * mem, gs_memory_t *data_mem,
-            bool ok_to_compress)
+            int compress)
 {
     if (*fname == 0) {
         if (fmode[0] == 'r')
@@ -368,6 +406,7 @@ clist_fwrite_chars(const void *data, uint len, clist_file_ptr cf)
     if (res >= 0)
         icf->pos += len;
     icf->filesize = icf->pos;	/* write truncates file */
+    clist_unmap_file(icf);
     if (!CL_CACHE_NEEDS_INIT(icf->cache)) {
         /* writing invalidates the read cache */
         cl_cache_destroy(icf->cache);
@@ -387,12 +426,20 @@ clist_fread_chars(void *data, uint len, clist_file_ptr cf)
         IFILE *icf = (IFILE *)cf;
         byte *dp = data;
 
+        if (icf->map == NULL && !icf->map_failed)
+            clist_map_file(icf);
         /* if we have a cache, check if it needs init, and do it */
-        if (CL_CACHE_NEEDS_INIT(icf->cache)) {
+        if (icf->map == NULL && CL_CACHE_NEEDS_INIT(icf->cache)) {
             icf->cache = cl_cache_read_init(icf->cache, CL_CACHE_NSLOTS, 1<<CL_CACHE_SLOT_SIZE_LOG2, icf->filesize);
         }
-        /* cl_cache_read_init may have failed, and set cache to NULL, check before using it */
-        if (icf->cache != NULL) {
+        if (icf->map != NULL) {
+            /* The file is mapped, just copy the data */
+            if (icf->pos < icf->map_size) {
+                nread = min(len, icf->map_size - icf->pos);
+                memcpy(data, icf->map + icf->pos, nread);
+            }
+        } else if (icf->cache != NULL) {
+            /* cl_cache_read_init may have failed, and set cache to NULL, so we checked */
             do {
                 int n;
 
@@ -484,6 +531,8 @@ clist_rewind(clist_file_ptr cf, bool discard_data, const char *fname)
              * new scratch file. */
             char tfname[gp_file_name_sizeof] = {0};
             const gs_memory_t *mem = ocf->f->memory;
+            clist_unmap_file(ocf);
+            clist_unmap_file((IFILE *)cf);
             gp_fclose(ocf->f);
             ocf->f = gp_open_scratch_file_rm(mem, gp_scratch_file_name_prefix, tfname, fmode);
             if (ocf->f == NULL)
@@ -509,6 +558,7 @@ clist_rewind(clist_file_ptr cf, bool discard_data, const char *fname)
              */
 
             /* Opening with "w" mode deletes the contents when closing. */
+            clist_unmap_file((IFILE *)cf);
             f = gp_freopen(fname, gp_fmode_wb, f);
             if (f == NULL) return_error(gs_error_ioerror);
             ((IFILE *)cf)->f = gp_freopen(fname, fmode, f);
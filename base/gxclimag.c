@@ -1428,6 +1428,15 @@ clist_composite(gx_device * dev,
         /* insert the compositor identifier */
         dp[2] = pcte->type->comp_id;
 
+        /* Apart from overprint, a compositor may change the band contents */
+        /* even where nothing else is drawn. */
+        if (pcte->type->comp_id != GX_COMPOSITOR_OVERPRINT) {
+            gx_clist_state *pcls;
+
+            for (pcls = cdev->states; pcls < cdev->states + cdev->nbands; pcls++)
+                pcls->color_usage.content = gx_band_content_drawn;
+        }
+
         /* serialize the remainder of the compositor */
         if ((code = pcte->type->procs.write(pcte, dp + 3, &size_dummy, cdev)) < 0)
             ((gx_device_clist_writer *)dev)->cnext = dp;
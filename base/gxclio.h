@@ -31,6 +31,19 @@
 
 typedef void *clist_file_ptr;	/* We can't do any better than this. */
 
+/*
+ * Values for the 'compress' argument of fopen.  The first two are the
+ * historical 'false' and 'true'.
+ */
+#define CLIST_COMPRESS_NEVER 0		/* don't compress this file */
+#define CLIST_COMPRESS_WHEN_LARGE 1	/* compress once the file gets large */
+#define CLIST_COMPRESS_ALWAYS 2		/* compress every block, favoring speed */
+/*
+ * May be or'ed into any of the above to ask for the compression ratio and
+ * codec time to be reported (on stderr) when the data is freed.
+ */
+#define CLIST_COMPRESS_REPORT_STATS 0x100
+
 struct clist_io_procs_s {
 
     /* ---------------- Open/close/unlink ---------------- */
@@ -39,12 +52,14 @@ struct clist_io_procs_s {
      * If *fname = 0, generate and store a new scratch file name; otherwise,
      * open an existing file.  Only modes "r" and "w+" are supported,
      * and only binary data (but the caller must append the "b" if needed).
-     * Mode "r" with *fname = 0 is an error.
+     * Mode "r" with *fname = 0 is an error.  'compress' is one of the
+     * CLIST_COMPRESS_ values below; it is only a hint, and implementations
+     * that cannot compress ignore it.
      */
     int (*fopen)(char fname[gp_file_name_sizeof], const char *fmode,
                     clist_file_ptr * pcf,
                     gs_memory_t * mem, gs_memory_t *data_mem,
-                    bool ok_to_compress);
+                    int compress);
 
     /*
      * Close a file, optionally deleting it.
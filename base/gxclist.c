@@ -354,6 +354,36 @@ clist_init_states(gx_device * dev, byte * init_data, size_t data_size)
     return 0;
 }
 
+/*
+ * In the adaptive band height mode (band_params.adaptive), keep each band
+ * buffer within ADAPTIVE_BAND_BUFFER_BYTES, which a core can expect to
+ * hold in its share of the L2/L3 cache, but never go below
+ * ADAPTIVE_MIN_BAND_HEIGHT lines or let the band states take more than a
+ * quarter of the command buffer.  Within those limits the height chosen
+ * from the previous page's costs (next_band_height) is used for all the
+ * bands of the page.
+ */
+#define ADAPTIVE_BAND_BUFFER_BYTES (2 * 1024 * 1024)
+#define ADAPTIVE_MIN_BAND_HEIGHT 16
+static int
+clist_adaptive_band_height(gx_device_clist_writer *cdev,
+                           const gx_device_memory *bdev, int band_width,
+                           int max_height, size_t states_space,
+                           bool page_uses_transparency)
+{
+    int band_height = gdev_mem_max_height(bdev, band_width,
+                                          ADAPTIVE_BAND_BUFFER_BYTES,
+                                          page_uses_transparency);
+    int min_height = (int)(((int64_t)cdev->height * sizeof(gx_clist_state) * 4 +
+                            states_space - 1) / states_space);
+
+    if (cdev->next_band_height > 0 && cdev->next_band_height < band_height)
+        band_height = cdev->next_band_height;
+    if (band_height < max(min_height, ADAPTIVE_MIN_BAND_HEIGHT))
+        band_height = max(min_height, ADAPTIVE_MIN_BAND_HEIGHT);
+    return min(band_height, max_height);
+}
+
 /*
  * Initialize all the data allocations.  Requires: target.  Sets:
  * page_info.tile_cache_size, page_info.band_params.BandWidth,
@@ -460,6 +490,10 @@ clist_init_data(gx_device * dev, byte * init_data, size_t data_size)
                     pbdev->finalize(pbdev);
                 return_error(gs_error_rangecheck);
             }
+            if (cdev->band_params.adaptive)
+                band_height = clist_adaptive_band_height(cdev, &bdev, band_width,
+                                  band_height, data_size - bits_size,
+                                  page_uses_transparency);
             adjusted = (dev_proc(dev, dev_spec_op)(dev, gxdso_adjust_bandheight, NULL, band_height));
             if (adjusted > 0)
                 band_height = adjusted;
@@ -634,7 +668,10 @@ clist_open_output_file(gx_device *dev)
     clist_reset_page(cdev);
     if ((code = cdev->page_info.io_procs->fopen(cdev->page_info.cfname, fmode, &cdev->page_info.cfile,
                             cdev->bandlist_memory, cdev->bandlist_memory,
-                            true)) < 0 ||
+                            (cdev->band_params.compression == BandListCompressAlways ?
+                             CLIST_COMPRESS_ALWAYS : CLIST_COMPRESS_WHEN_LARGE) |
+                            (cdev->band_params.report_stats ?
+                             CLIST_COMPRESS_REPORT_STATS : 0))) < 0 ||
         (code = cdev->page_info.io_procs->fopen(cdev->page_info.bfname, fmode, &cdev->page_info.bfile,
                             cdev->bandlist_memory, cdev->bandlist_memory,
                             false)) < 0
@@ -686,6 +723,9 @@ clist_open(gx_device *dev)
 
     cdev->permanent_error = 0;
     cdev->is_open = false;
+    /* next_band_height and the band_render_cache are left alone, so that
+       they carry over to the next page (BGPrint reopens the device for
+       every page); the cache is freed by gdev_prn_tear_down. */
 
     cdev->cache_chunk = (gx_bits_cache_chunk *)gs_alloc_bytes(cdev->memory->non_gc_memory, sizeof(gx_bits_cache_chunk), "alloc tile cache for clist");
     if (!cdev->cache_chunk)
@@ -760,6 +800,66 @@ clist_output_page(gx_device * dev, int num_copies, int flush)
     return_error(gs_error_Fatal);
 }
 
+/* In the adaptive band height mode, aim to give each rendering thread */
+/* this many bands of the page. */
+#define ADAPTIVE_BANDS_PER_THREAD 4
+
+/*
+ * Choose the band height for the next page in the adaptive mode, from the
+ * command list sizes of the page that has just been rendered (see
+ * clist_read_band_costs).  The height is scaled so that the most expensive
+ * band carries 1/ADAPTIVE_BANDS_PER_THREAD of a thread's share of the page.
+ * Every band of a page has the same height, so a page where one band holds
+ * much of the work gets shorter bands throughout, spreading that work over
+ * more threads, and a page where all the bands are light gets taller ones,
+ * so that there are fewer bands to set up.
+ * clist_adaptive_band_height clamps the result.  Pages rendered without
+ * threads (including the empty band list flushed by fillpage) have nothing
+ * to balance, so they leave the previous choice alone.  With BGPrint this
+ * is called on the background device by prn_finish_bg_print, which hands
+ * the height back to the foreground device.
+ */
+void
+clist_choose_next_band_height(gx_device_clist_reader *crdev)
+{
+    int nbands = crdev->nbands;
+    int band_height = crdev->page_info.band_params.BandHeight;
+    int threads = crdev->num_render_threads;	/* 0 if no threads were used */
+    int64_t *costs;
+    int64_t total = 0, max_cost = 0, target;
+    int band;
+
+    if (threads <= 1 || nbands <= 0)
+        return;
+    costs = (int64_t *)gs_alloc_byte_array(crdev->memory, nbands, sizeof(int64_t),
+                                           "clist_choose_next_band_height");
+    if (costs == NULL)
+        return;		/* not fatal, the next page just isn't adapted */
+    if (clist_read_band_costs(crdev, costs) >= 0) {
+        for (band = 0; band < nbands; band++) {
+            total += costs[band];
+            if (costs[band] > max_cost)
+                max_cost = costs[band];
+        }
+        target = total / (threads * ADAPTIVE_BANDS_PER_THREAD);
+        if (max_cost > 0 && target > 0) {
+            /* Commands that span bands don't shrink with them, so move at */
+            /* most a factor of 2 per page, and stop at twice the number */
+            /* of bands aimed for. */
+            int64_t height = (int64_t)band_height * target / max_cost;
+            int min_height = crdev->height / (threads * ADAPTIVE_BANDS_PER_THREAD * 2);
+
+            height = max(height, band_height / 2);
+            height = min(height, (int64_t)band_height * 2);
+            crdev->next_band_height = (int)max(height, max(min_height, 1));
+        }
+        if_debug4m(':', crdev->memory,
+                   "[:]adaptive band height %d -> %d (max cost %"PRId64", total %"PRId64")\n",
+                   band_height, crdev->next_band_height, max_cost, total);
+    }
+    gs_free_object(crdev->memory, costs, "clist_choose_next_band_height");
+}
+
 /* Reset (or prepare to append to) the command list after printing a page. */
 int
 clist_finish_page(gx_device *dev, bool flush)
@@ -775,9 +875,13 @@ clist_finish_page(gx_device *dev, bool flush)
     if (!CLIST_IS_WRITER((gx_device_clist *)dev)) {
         gx_device_clist_reader * const crdev =  &((gx_device_clist *)dev)->reader;
 
+        /* The band list is only rewritten from scratch when flushing. */
+        if (flush && crdev->band_params.adaptive)
+            clist_choose_next_band_height(crdev);
         clist_teardown_render_threads(dev);
         gs_free_object(cdev->memory, crdev->color_usage_array, "clist_color_usage_array");
         crdev->color_usage_array = NULL;
+        clist_free_band_hashes(crdev);
 
        /* Free the icc table associated with this device.
            The threads that may have pointed to this were destroyed in
@@ -1210,6 +1314,7 @@ clist_writer_color_usage(gx_device_clist_writer *cldev, int y, int height,
         }
         color_usage->or = or;
         color_usage->slow_rop = slow_rop;
+        color_usage->content = gx_band_content_drawn;
         *range_start = start * band_height;
         return min(end * band_height, cldev->height) - *range_start;
 }
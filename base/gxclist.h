@@ -172,6 +172,9 @@ typedef struct cmd_list_s {
  */
 typedef struct gx_clist_state_s gx_clist_state;
 
+/* Rendered bands kept across pages, see BandRenderCacheSize. */
+typedef struct gx_band_render_cache_s gx_band_render_cache;
+
 #define gx_device_clist_common_members\
         gx_device_forward_common;	/* (see gxdevice.h) */\
                 /* Following must be set before writing or reading. */\
@@ -183,6 +186,12 @@ typedef struct gx_clist_state_s gx_clist_state;
         byte *data;			/* buffer area */\
         size_t data_size;		/* size of buffer */\
         gx_band_params_t band_params;	/* band buffering parameters */\
+        int next_band_height;		/* BandHeight chosen for the next page when */\
+                                        /* band_params.adaptive, 0 if none */\
+        gx_band_render_cache *band_render_cache; /* kept by the printer device */\
+                                        /* until gdev_prn_tear_down, borrowed */\
+                                        /* by the rendering threads, NULL if */\
+                                        /* not enabled */\
         bool do_not_open_or_close_bandfiles;	/* if true, do not open/close bandfiles */\
         dev_proc_dev_spec_op((*orig_spec_op)); /* Original dev spec op handler */\
                 /* Following are used for both writing and reading. */\
@@ -392,6 +401,8 @@ typedef struct gx_device_clist_reader_s {
                                         /* means all planes */
     const gx_placed_page *pages;
     gx_color_usage_t *color_usage_array; /* per band color_usage */
+    byte *band_hashes;			/* per band keys for band_render_cache, */
+                                        /* SHA256_DIGEST_LENGTH bytes each, or NULL */
     int num_pages;
     void *offset_map; /* Just against collecting the map as garbage. */
     int num_render_threads;		/* number of threads being used */
@@ -400,6 +411,11 @@ typedef struct gx_device_clist_reader_s {
     int curr_render_thread;		/* index into array */
     int thread_lookahead_direction;	/* +1 or -1 */
     int next_band;			/* may be < 0 or >= num bands when no more remain to render */
+    int *band_schedule;			/* bands in decreasing order of estimated cost, or NULL */
+    int band_schedule_next;		/* index of the next band_schedule entry to hand out */
+    struct gx_monitor_s *band_schedule_monitor;	/* protects band_schedule_next */
+    int64_t *band_costs;		/* estimated cost of each band for in order output, */
+                                        /* < 0 once handed out, or NULL */
     struct gx_device_clist_reader_s *orig_clist_device;
                                         /* This is NULL, unless we're in a worker thread for clist
                                          * rendering, in which case it's a pointer back to the
@@ -445,6 +461,10 @@ void clist_init_io_procs(gx_device_clist *pclist_dev, bool in_memory);
 /* Reset (or prepare to append to) the command list after printing a page. */
 int clist_finish_page(gx_device * dev, bool flush);
 
+/* Choose next_band_height from the costs of the page just rendered */
+/* (band_params.adaptive). */
+void clist_choose_next_band_height(gx_device_clist_reader *crdev);
+
 /* Close the band files and delete their contents. */
 int clist_close_output_file(gx_device *dev);
 
@@ -544,6 +564,19 @@ void
 clist_select_render_plane(gx_device *dev, int y, int height,
                           gx_render_plane_t *render_plane, int index);
 
+/* Set up the band_render_cache and its keys for the page being read, and
+   free the cache when the device is torn down. */
+int clist_alloc_band_render_cache(gx_device_clist_common *cdev);
+int clist_read_band_hashes(gx_device_clist_reader *crdev);
+void clist_free_band_hashes(gx_device_clist_reader *crdev);
+void clist_free_band_render_cache(gx_device_clist_common *cdev);
+
+/* Select the next band for a rendering thread working in the
+   GX_PROCPAGE_COST_SCHEDULE mode of process_page. Called by the
+   process_fn with the thread's own device; sets that device's next_band. */
+int
+clist_claim_next_band(gx_device *dev);
+
 int clist_rasterize_lines(gx_device *dev, int y, int lineCount,
                                   gx_device *bdev,
                                   const gx_render_plane_t *render_plane,
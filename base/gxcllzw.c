@@ -24,16 +24,17 @@
 /* Return the prototypes for compressing/decompressing the band list. */
 const stream_template *clist_compressor_template(void)
 {
-    return &cl_LZWE_template;
+    return &s_LZWE_template;
 }
 const stream_template *
-clist_decompressor_state(void)
+clist_decompressor_template(void)
 {
-    return &cl_LZWD_state;
+    return &s_LZWD_template;
 }
 void
-clist_compressor_init(stream_state *state)
+clist_compressor_init(stream_state *state, bool favor_speed)
 {
+    /* LZW has no effort setting, so favor_speed makes no difference. */
     s_LZW_set_defaults(state);
     state->templat = &s_LZWE_template;
 }
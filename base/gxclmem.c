@@ -139,6 +139,10 @@ LIMITATIONS.
    As a testing measure we have a a define TEST_BAND_LIST_COMPRESSION
    which, if set, will set the threshold to a low value so as to cause
    compression to trigger.
+
+   A file opened with CLIST_COMPRESS_ALWAYS ignores the threshold and
+   compresses every block as it is completed, trading some speed for a
+   much smaller band list.
  */
 static const int64_t COMPRESSION_THRESHOLD =
 #ifdef TEST_BAND_LIST_COMPRESSION
@@ -148,7 +152,8 @@ static const int64_t COMPRESSION_THRESHOLD =
 #endif
 
 #define NEED_TO_COMPRESS(f)\
-  ((f)->ok_to_compress && (f)->total_space > COMPRESSION_THRESHOLD)
+  ((f)->ok_to_compress &&\
+   ((f)->compress_always || (f)->total_space > COMPRESSION_THRESHOLD))
 
    /* FOR NOW ALLOCATE 1 raw buffer for every 32 blocks (at least 8, no more than 64)    */
 #define GET_NUM_RAW_BUFFERS( f ) \
@@ -169,14 +174,13 @@ static int memfile_init_empty(MEMFILE * f);
 static int memfile_set_memory_warning(clist_file_ptr cf, int bytes_left);
 static int memfile_fclose(clist_file_ptr cf, const char *fname, bool delete);
 static int memfile_get_pdata(MEMFILE * f);
+static void memfile_report_stats(MEMFILE * f);
 
 /************************************************/
 /*   #define DEBUG      /- force statistics -/  */
 /************************************************/
 
 #ifdef DEBUG
-int64_t tot_compressed;
-int64_t tot_raw;
 int64_t tot_cache_miss;
 int64_t tot_cache_hits;
 int64_t tot_swap_out;
@@ -189,9 +193,18 @@ byte *decomp_wt_ptr0, *decomp_wt_limit0;
 const byte *decomp_rd_ptr0, *decomp_rd_limit0;
 byte *decomp_wt_ptr1, *decomp_wt_limit1;
 const byte *decomp_rd_ptr1, *decomp_rd_limit1;
-
 #endif
 
+/* Microsecond clock for the codec timing statistics. */
+static int64_t
+memfile_clock_us(void)
+{
+    long t[2];
+
+    gp_get_realtime(t);
+    return (int64_t)t[0] * 1000000 + t[1] / 1000;
+}
+
 /* ----------------------------- Memory Allocation --------------------- */
 static void *   /* allocated memory's address, 0 if failure */
 allocateWithReserve(
@@ -238,7 +251,7 @@ allocateWithReserve(
 static int
 memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
               clist_file_ptr /*MEMFILE * */  * pf,
-              gs_memory_t *mem, gs_memory_t *data_mem, bool ok_to_compress)
+              gs_memory_t *mem, gs_memory_t *data_mem, int compress)
 {
     MEMFILE *f = NULL;
     int code = 0;
@@ -289,6 +302,12 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             f->log_curr_pos = 0;
             f->raw_head = NULL;
             f->error_code = 0;
+            f->stat_raw = 0;            /* the writer reports these */
+            f->stat_blocks_compressed = 0;
+            f->stat_compressed = 0;
+            f->stat_compress_us = 0;
+            f->stat_blocks_decompressed = 0;
+            f->stat_decompress_us = 0;
 
             if (f->log_head->phys_blk->data_limit != NULL) {
                 /* The file is compressed, so we need to copy the logical block */
@@ -325,10 +344,10 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
                     code = gs_note_error(gs_error_VMerror);
                     goto finish;
                 }
-                clist_decompressor_init(f->decompress_state);
-                f->decompress_state->memory = mem;
                 if (decompress_template->set_defaults)
                     (*decompress_template->set_defaults) (f->decompress_state);
+                clist_decompressor_init(f->decompress_state);
+                f->decompress_state->memory = mem;
             }
             f->log_curr_blk = f->log_head;
             memfile_get_pdata(f);               /* set up the initial block */
@@ -358,16 +377,26 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
     f->reservePhysBlockCount = 0;
     f->reserveLogBlockChain = NULL;
     f->reserveLogBlockCount = 0;
+    f->stat_raw = 0;
+    f->stat_blocks_compressed = 0;
+    f->stat_compressed = 0;
+    f->stat_compress_us = 0;
+    f->stat_blocks_decompressed = 0;
+    f->stat_decompress_us = 0;
+    f->report_stats = (compress & CLIST_COMPRESS_REPORT_STATS) != 0;
+    compress &= ~CLIST_COMPRESS_REPORT_STATS;
     /* init an empty file           */
     if ((code = memfile_init_empty(f)) < 0)
         goto finish;
     if ((code = memfile_set_memory_warning(f, 0)) < 0)
         goto finish;
     /*
-     * Disregard the ok_to_compress flag, since the size threshold gives us
-     * a much better criterion for deciding when compression is appropriate.
+     * Disregard a request not to compress, since the size threshold gives
+     * us a much better criterion for deciding when compression is
+     * appropriate. Only a request to compress everything is honored.
      */
-    f->ok_to_compress = /*ok_to_compress */ true;
+    f->ok_to_compress = true;
+    f->compress_always = (compress == CLIST_COMPRESS_ALWAYS);
     f->compress_state = 0;      /* make clean for GC */
     f->decompress_state = 0;
     if (f->ok_to_compress) {
@@ -387,14 +416,16 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
             code = gs_note_error(gs_error_VMerror);
             goto finish;
         }
-        clist_compressor_init(f->compress_state);
-        clist_decompressor_init(f->decompress_state);
-        f->compress_state->memory = mem;
-        f->decompress_state->memory = mem;
+        /* Apply the template defaults first so that they don't */
+        /* override the band list specific settings. */
         if (compress_template->set_defaults)
             (*compress_template->set_defaults) (f->compress_state);
         if (decompress_template->set_defaults)
             (*decompress_template->set_defaults) (f->decompress_state);
+        clist_compressor_init(f->compress_state, f->compress_always);
+        clist_decompressor_init(f->decompress_state);
+        f->compress_state->memory = mem;
+        f->decompress_state->memory = mem;
     }
     f->total_space = 0;
 
@@ -403,8 +434,6 @@ memfile_fopen(char fname[gp_file_name_sizeof], const char *fmode,
     gs_snprintf(fname+1, gp_file_name_sizeof-1, "%p", f);
 
 #ifdef DEBUG
-        tot_compressed = 0;
-        tot_raw = 0;
         tot_cache_miss = 0;
         tot_cache_hits = 0;
         tot_swap_out = 0;
@@ -449,28 +478,26 @@ memfile_fclose(clist_file_ptr cf, const char *fname, bool delete)
                 return_error(gs_error_invalidfileaccess);
             }
             prev_f->openlist = f->openlist;     /* link around the one being fclosed */
+            memfile_report_stats(f);
             /* Now delete this MEMFILE reader instance */
             /* NB: we don't delete 'base' instances until we delete */
             /* If the file is compressed, free the logical blocks, but not */
             /* the phys_blk info (that is still used by the base memfile   */
             if (f->log_head->phys_blk->data_limit != NULL) {
-                LOG_MEMFILE_BLK *tmpbp, *bp = f->log_head;
-
-                while (bp != NULL) {
-                    tmpbp = bp->link;
-                    FREE(f, bp, "memfile_free_mem(log_blk)");
-                    bp = tmpbp;
-                }
+                /* memfile_fopen copied the logical blocks into one array */
+                FREE(f, f->log_head, "memfile_free_mem(log_blk)");
                 f->log_head = NULL;
 
-                /* Free any internal compressor state. */
-                if (f->compressor_initialized) {
+                /* Free the decompressor state (reader instances don't */
+                /* have a compressor). */
+                if (f->decompress_state != NULL) {
                     if (f->decompress_state->templat->release != 0)
                         (*f->decompress_state->templat->release) (f->decompress_state);
-                    if (f->compress_state->templat->release != 0)
-                        (*f->compress_state->templat->release) (f->compress_state);
-                    f->compressor_initialized = false;
+                    gs_free_object(f->memory, f->decompress_state,
+                                   "memfile_fclose(decompress_state)");
+                    f->decompress_state = NULL;
                 }
+                f->compressor_initialized = false;
                 /* free the raw buffers                                           */
                 while (f->raw_head != NULL) {
                     RAW_BUFFER *tmpraw = f->raw_head->fwd;
@@ -614,6 +641,7 @@ compress_log_blk(MEMFILE * f, LOG_MEMFILE_BLK * bp)
     long compressed_size;
     byte *start_ptr;
     PHYS_MEMFILE_BLK *newphys;
+    int64_t start_time = memfile_clock_us();
 
     /* compress this block */
     f->rd.ptr = (const byte *)(bp->phys_blk->data) - 1;
@@ -668,9 +696,9 @@ compress_log_blk(MEMFILE * f, LOG_MEMFILE_BLK * bp)
                   MEMFILE_DATA_SIZE,
                   compressed_size);
     }
-#ifdef DEBUG
-    tot_compressed += compressed_size;
-#endif
+    f->stat_blocks_compressed++;
+    f->stat_compressed += compressed_size;
+    f->stat_compress_us += memfile_clock_us() - start_time;
     return (status < 0 ? gs_note_error(gs_error_ioerror) : ecode);
 }                               /* end "compress_log_blk()"                                     */
 
@@ -823,9 +851,7 @@ memfile_fwrite_chars(const void *data, uint len, clist_file_ptr cf)
     }
     f->log_curr_pos += len;
     f->log_length = f->log_curr_pos;    /* truncate length to here      */
-#ifdef DEBUG
-    tot_raw += len;
-#endif
+    f->stat_raw += len;
     return (len);
 }
 
@@ -842,6 +868,7 @@ memfile_get_pdata(MEMFILE * f)
 {
     int code, i, num_raw_buffers, status;
     LOG_MEMFILE_BLK *bp = f->log_curr_blk;
+    int64_t start_time;
 
     if (bp->phys_blk->data_limit == NULL) {
         /* Not compressed, return this data pointer                       */
@@ -905,6 +932,7 @@ memfile_get_pdata(MEMFILE * f)
 #ifdef DEBUG
             tot_cache_miss++;   /* count every decompress       */
 #endif
+            start_time = memfile_clock_us();
             /* find a raw buffer and decompress                            */
             if (f->raw_tail->log_blk != NULL) {
                 /* This block was in use, grab it                           */
@@ -967,6 +995,8 @@ memfile_get_pdata(MEMFILE * f)
                 }
             }
             bp->raw_block = f->raw_head;        /* point to raw block           */
+            f->stat_blocks_decompressed++;
+            f->stat_decompress_us += memfile_clock_us() - start_time;
         }
         /* end if( raw_block == NULL ) meaning need to decompress data    */
         else {
@@ -1120,30 +1150,62 @@ memfile_fseek(clist_file_ptr cf, int64_t offset, int mode, const char *ignore_fn
 
 /* ---------------- Internal routines ---------------- */
 
+/*
+ * Report, then reset, the codec statistics for a file or reader instance:
+ * on stderr if the file was opened with CLIST_COMPRESS_REPORT_STATS,
+ * otherwise only with -Z: in DEBUG builds.
+ */
+static void
+memfile_report_stats(MEMFILE * f)
+{
+    if (f->stat_blocks_compressed != 0) {
+        int ratio = (int)(f->stat_compressed * 100 /
+                          (f->stat_blocks_compressed * MEMFILE_DATA_SIZE));
+
+        if (f->report_stats)
+            errprintf(f->memory,
+                      "Band list: %"PRId64" bytes, %"PRId64" blocks compressed to %"PRId64" bytes (%d%%) in %"PRId64"us\n",
+                      f->stat_raw, f->stat_blocks_compressed,
+                      f->stat_compressed, ratio, f->stat_compress_us);
+        else
+            if_debug6m(':', f->memory,
+                       "[:]memfile "PRI_INTPTR": raw=%"PRId64", %"PRId64" blocks compressed to %"PRId64" bytes (%d%%) in %"PRId64"us\n",
+                       (intptr_t)f, f->stat_raw, f->stat_blocks_compressed,
+                       f->stat_compressed, ratio, f->stat_compress_us);
+    }
+    if (f->stat_blocks_decompressed != 0) {
+        if (f->report_stats)
+            errprintf(f->memory,
+                      "Band list: %"PRId64" blocks decompressed in %"PRId64"us\n",
+                      f->stat_blocks_decompressed, f->stat_decompress_us);
+        else
+            if_debug3m(':', f->memory,
+                       "[:]memfile "PRI_INTPTR": %"PRId64" blocks decompressed in %"PRId64"us\n",
+                       (intptr_t)f, f->stat_blocks_decompressed,
+                       f->stat_decompress_us);
+    }
+    f->stat_raw = 0;
+    f->stat_blocks_compressed = 0;
+    f->stat_compressed = 0;
+    f->stat_compress_us = 0;
+    f->stat_blocks_decompressed = 0;
+    f->stat_decompress_us = 0;
+}
+
 static void
 memfile_free_mem(MEMFILE * f)
 {
     LOG_MEMFILE_BLK *bp, *tmpbp;
 
-#ifdef DEBUG
     /* output some diagnostics about the effectiveness                   */
-    if (tot_raw > 100) {
-        if (tot_raw > 0xFFFFFFFF)
-            if_debug4m(':', f->memory, "[:]tot_raw=%lu%0lu, tot_compressed=%lu%0lu\n",
-                       tot_raw >> 32, tot_raw & 0xFFFFFFFF,
-                       tot_compressed >> 32, tot_compressed & 0xFFFFFFFF);
-         else
-            if_debug2m(':', f->memory, "[:]tot_raw=%lu, tot_compressed=%lu\n",
-                       tot_raw, tot_compressed);
-    }
+    memfile_report_stats(f);
+#ifdef DEBUG
     if (tot_cache_hits != 0) {
         if_debug3m(':', f->memory, "[:]Cache hits=%lu, cache misses=%lu, swapouts=%lu\n",
                    tot_cache_hits,
                    (long)(tot_cache_miss - (f->log_length / MEMFILE_DATA_SIZE)),
                    tot_swap_out);
     }
-    tot_raw = 0;
-    tot_compressed = 0;
     tot_cache_hits = 0;
     tot_cache_miss = 0;
     tot_swap_out = 0;
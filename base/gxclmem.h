@@ -67,6 +67,7 @@ struct MEMFILE_s {
     gs_memory_t *memory;	/* storage allocator */
     gs_memory_t *data_memory;	/* storage allocator for data */
     bool ok_to_compress;	/* if true, OK to compress this file */
+    bool compress_always;	/* compress from the first block, not just when large */
     bool is_open;		/* track open/closed for each access struct */
         /*
          * We need to maintain a linked list of other structs that
@@ -120,6 +121,18 @@ struct MEMFILE_s {
     bool compressor_initialized;
     stream_state *compress_state;
     stream_state *decompress_state;					/******* READER INSTANCE *******/
+        /*
+         * Codec statistics, reported when the data is freed (normally at
+         * the end of each page) if report_stats is set, or with -Z: in
+         * DEBUG builds.
+         */
+    bool report_stats;
+    int64_t stat_raw;		/* bytes written */
+    int64_t stat_blocks_compressed;
+    int64_t stat_compressed;	/* size of those blocks after compression */
+    int64_t stat_compress_us;
+    int64_t stat_blocks_decompressed;					/******* READER INSTANCE *******/
+    int64_t stat_decompress_us;						/******* READER INSTANCE *******/
 };
 typedef struct MEMFILE_s MEMFILE;
 
@@ -133,10 +146,11 @@ typedef struct MEMFILE_s MEMFILE;
     MEMFILE_enum_ptrs, MEMFILE_reloc_ptrs, compress_state, decompress_state)
 
 /* Declare the procedures for returning the prototype filter states */
-/* for compressing and decompressing the band list. */
+/* for compressing and decompressing the band list. If favor_speed is */
+/* true the compressor should trade compression ratio for speed. */
 const stream_template *clist_compressor_template(void);
 const stream_template *clist_decompressor_template(void);
-void clist_compressor_init(stream_state *state);
+void clist_compressor_init(stream_state *state, bool favor_speed);
 void clist_decompressor_init(stream_state *state);
 
 #endif /* gxclmem_INCLUDED */
@@ -31,6 +31,9 @@
 #include "gdevp14.h"
 #include "gsmemory.h"
 #include "gsicc_cache.h"
+#include "gxsync.h"
+#include "gdevdevn.h"
+#include "sha2.h"
 /*
  * We really don't like the fact that gdevprn.h is included here, since
  * command lists are supposed to be usable for purposes other than printer
@@ -479,6 +482,12 @@ clist_close_writer_and_init_reader(gx_device_clist *cldev)
             return code;
         /* Check for and get ICC profile table */
         code = clist_read_icctable(crdev);
+        if (code < 0)
+            return code;
+        /* Key the bands for the band render cache */
+        code = clist_alloc_band_render_cache((gx_device_clist_common *)crdev);
+        if (code >= 0)
+            code = clist_read_band_hashes(crdev);
         if (code < 0)
             return code;
         /* Allocate the icc cache for the clist reader */
@@ -612,6 +621,312 @@ clist_read_op_equiv_cmyk_colors(gx_device_clist_reader *crdev,
     return code;
 }
 
+/* Estimate the rendering cost of each band as the number of bytes of
+   command data recorded for it in the cfile. Each cmd_block in the bfile
+   gives the start of its data, so the length of a block is the distance
+   to the next entry. Commands written for a band range are charged to
+   every band in the range. 'costs' must have room for nbands entries. */
+int
+clist_read_band_costs(gx_device_clist_reader *crdev, int64_t *costs)
+{
+    gx_band_page_info_t *page_info = &(crdev->page_info);
+    clist_file_ptr bfile = page_info->bfile;
+    int nbands = crdev->nbands;
+    int64_t save_pos, pos;
+    cmd_block cb, next;
+    int band;
+
+    memset(costs, 0, nbands * sizeof(*costs));
+    if (bfile == NULL)
+        return_error(gs_error_ioerror);
+
+    save_pos = page_info->io_procs->ftell(bfile);
+    page_info->io_procs->fseek(bfile, 0, SEEK_SET, page_info->bfname);
+    if (page_info->io_procs->fread_chars(&cb, sizeof(cb), bfile) < sizeof(cb)) {
+        page_info->io_procs->fseek(bfile, save_pos, SEEK_SET, page_info->bfname);
+        return 0;
+    }
+    /* Band ranges can span every band, so accumulate the block lengths as
+       differences at the ends of each range and sum them afterwards. */
+    for (pos = sizeof(cb); pos < page_info->bfile_end_pos; pos += sizeof(next)) {
+        if (page_info->io_procs->fread_chars(&next, sizeof(next), bfile) < sizeof(next))
+            break;
+        if (cb.band_min != cmd_band_end && cb.band_min < nbands &&
+            cb.band_max >= 0 && next.pos > cb.pos) {
+            int band_min = max(cb.band_min, 0);
+            int band_max = min(cb.band_max, nbands - 1);
+
+            costs[band_min] += next.pos - cb.pos;
+            if (band_max + 1 < nbands)
+                costs[band_max + 1] -= next.pos - cb.pos;
+        }
+        cb = next;
+    }
+    for (band = 1; band < nbands; band++)
+        costs[band] += costs[band - 1];
+    page_info->io_procs->fseek(bfile, save_pos, SEEK_SET, page_info->bfname);
+    return 0;
+}
+
+/* ------ Band render cache ------ */
+
+/*
+ * With BandRenderCacheSize > 0, the bits of bands rendered singly are kept
+ * across pages so that a band whose commands are the same as one already
+ * rendered (as on repeated forms or pages) is copied rather than played
+ * back. Each band's key is a SHA-256 digest of the command blocks it reads
+ * back, in order, of the page level data (ICC table, spot equivalents) and
+ * of the colour state of the target (colour model, ICC profiles, rendering
+ * conditions, spot colorants) that can affect how the commands are
+ * rendered. Since a hit copies the bits without looking at the commands,
+ * the digest has to be one that can't collide by accident.
+ */
+#define BAND_KEY_SIZE SHA256_DIGEST_LENGTH
+
+typedef struct gx_band_render_cache_entry_s gx_band_render_cache_entry;
+struct gx_band_render_cache_entry_s {
+    gx_band_render_cache_entry *next;
+    byte key[BAND_KEY_SIZE];
+    int band;
+    gs_int_rect rect;		/* rectangle that was rendered */
+    int width, depth;		/* of the buffer device */
+    uint raster;		/* bytes per line of the bits below */
+    size_t size;		/* of the entry, including the bits */
+    /* the bits follow */
+};
+
+struct gx_band_render_cache_s {
+    gs_memory_t *memory;
+    gx_monitor_t *monitor;
+    size_t max_size;
+    size_t size;
+    gx_band_render_cache_entry *head;	/* most recently used first */
+    long hits, misses;
+};
+
+#define band_key_update(ctx, value)\
+  pSHA256_Update(ctx, (const uint8_t *)&(value), sizeof(value))
+
+/* Digest size bytes of the cfile starting at pos. */
+static void
+clist_digest_cfile(gx_device_clist_reader *crdev, int64_t pos, int64_t size,
+                   byte digest[BAND_KEY_SIZE])
+{
+    byte buf[cbuf_size];
+    SHA256_CTX ctx;
+
+    pSHA256_Init(&ctx);
+    while (size > 0) {
+        int count = (int)min(size, sizeof(buf));
+
+        clist_read_chunk(crdev, pos, count, buf);
+        pSHA256_Update(&ctx, buf, count);
+        pos += count;
+        size -= count;
+    }
+    pSHA256_Final(digest, &ctx);
+}
+
+static void
+band_key_profile(SHA256_CTX *ctx, cmm_profile_t *profile)
+{
+    int64_t hash = (profile == NULL ? 0 : gsicc_get_hash(profile));
+
+    band_key_update(ctx, hash);
+}
+
+/* Add the colour state of the target, which the commands don't record
+   but which affects how they are rendered: the colour model, the ICC
+   profiles and rendering conditions, and the spot colorants. */
+static void
+band_key_color_state(SHA256_CTX *ctx, gx_device_clist_reader *crdev)
+{
+    const gx_device_color_info *ci = &crdev->color_info;
+    cmm_dev_profile_t *icc = crdev->icc_struct;
+    gs_devn_params *devn_params;
+    int k;
+
+    band_key_update(ctx, ci->max_components);
+    band_key_update(ctx, ci->num_components);
+    band_key_update(ctx, ci->polarity);
+    band_key_update(ctx, ci->depth);
+    band_key_update(ctx, ci->gray_index);
+    band_key_update(ctx, ci->max_gray);
+    band_key_update(ctx, ci->max_color);
+    band_key_update(ctx, ci->dither_grays);
+    band_key_update(ctx, ci->dither_colors);
+    band_key_update(ctx, ci->anti_alias.text_bits);
+    band_key_update(ctx, ci->anti_alias.graphics_bits);
+    band_key_update(ctx, ci->separable_and_linear);
+    if (ci->cm_name != NULL)
+        pSHA256_Update(ctx, (const uint8_t *)ci->cm_name, strlen(ci->cm_name) + 1);
+    band_key_update(ctx, crdev->trans_dev_icc_hash);
+
+    if (icc != NULL) {
+        for (k = 0; k < NUM_DEVICE_PROFILES; k++) {
+            const gsicc_rendering_param_t *rc = &icc->rendercond[k];
+
+            band_key_profile(ctx, icc->device_profile[k]);
+            band_key_update(ctx, rc->rendering_intent);
+            band_key_update(ctx, rc->black_point_comp);
+            band_key_update(ctx, rc->preserve_black);
+            band_key_update(ctx, rc->graphics_type_tag);
+            band_key_update(ctx, rc->cmm);
+            band_key_update(ctx, rc->override_icc);
+        }
+        band_key_profile(ctx, icc->proof_profile);
+        band_key_profile(ctx, icc->link_profile);
+        band_key_profile(ctx, icc->oi_profile);
+        band_key_profile(ctx, icc->blend_profile);
+        band_key_profile(ctx, icc->postren_profile);
+        band_key_update(ctx, icc->devicegraytok);
+        band_key_update(ctx, icc->graydetection);
+        band_key_update(ctx, icc->usefastcolor);
+        band_key_update(ctx, icc->blacktext);
+        band_key_update(ctx, icc->blackvector);
+        band_key_update(ctx, icc->blackthresholdL);
+        band_key_update(ctx, icc->blackthresholdC);
+        band_key_update(ctx, icc->supports_devn);
+        band_key_update(ctx, icc->overprint_control);
+    }
+
+    devn_params = dev_proc(crdev, ret_devn_params)((gx_device *)crdev);
+    if (devn_params != NULL) {
+        const gs_separations *seps = &devn_params->separations;
+
+        band_key_update(ctx, seps->num_separations);
+        for (k = 0; k < seps->num_separations; k++) {
+            band_key_update(ctx, seps->names[k].size);
+            pSHA256_Update(ctx, seps->names[k].data, seps->names[k].size);
+        }
+        band_key_update(ctx, devn_params->num_separation_order_names);
+        for (k = 0; k < devn_params->num_separation_order_names; k++)
+            band_key_update(ctx, devn_params->separation_order_map[k]);
+    }
+}
+
+/* Create the band_render_cache if BandRenderCacheSize is set and this
+   is the first page that needs it. */
+int
+clist_alloc_band_render_cache(gx_device_clist_common *cdev)
+{
+    gs_memory_t *mem = cdev->memory->thread_safe_memory;
+    gx_band_render_cache *cache;
+
+    if (cdev->band_render_cache != NULL || cdev->band_params.render_cache_size == 0)
+        return 0;
+    cache = (gx_band_render_cache *)gs_alloc_bytes(mem, sizeof(*cache),
+                                                   "clist_alloc_band_render_cache");
+    if (cache == NULL)
+        return_error(gs_error_VMerror);
+    memset(cache, 0, sizeof(*cache));
+    cache->memory = mem;
+    cache->max_size = cdev->band_params.render_cache_size;
+    cache->monitor = gx_monitor_label(gx_monitor_alloc(mem), "BandRenderCache");
+    if (cache->monitor == NULL) {
+        gs_free_object(mem, cache, "clist_alloc_band_render_cache");
+        return_error(gs_error_VMerror);
+    }
+    cdev->band_render_cache = cache;
+    return 0;
+}
+
+/* Compute the band_render_cache key of every band of the page. Does
+   nothing if the device has no cache. */
+int
+clist_read_band_hashes(gx_device_clist_reader *crdev)
+{
+    gx_band_page_info_t *page_info = &(crdev->page_info);
+    clist_file_ptr bfile = page_info->bfile;
+    int nbands = crdev->nbands;
+    gs_memory_t *mem = crdev->memory->non_gc_memory;
+    SHA256_CTX *band_ctx, extra_ctx;
+    byte digest[BAND_KEY_SIZE];
+    int64_t save_pos, pos;
+    cmd_block cb, next;
+    int band;
+
+    clist_free_band_hashes(crdev);
+    if (crdev->band_render_cache == NULL || bfile == NULL)
+        return 0;
+    band_ctx = (SHA256_CTX *)gs_alloc_byte_array(mem, nbands, sizeof(SHA256_CTX),
+                                                 "clist_read_band_hashes");
+    crdev->band_hashes = gs_alloc_byte_array(mem, nbands, BAND_KEY_SIZE,
+                                             "clist_read_band_hashes");
+    if (band_ctx == NULL || crdev->band_hashes == NULL) {
+        gs_free_object(mem, band_ctx, "clist_read_band_hashes");
+        clist_free_band_hashes(crdev);
+        return_error(gs_error_VMerror);
+    }
+    for (band = 0; band < nbands; band++)
+        pSHA256_Init(&band_ctx[band]);
+    pSHA256_Init(&extra_ctx);
+
+    save_pos = page_info->io_procs->ftell(bfile);
+    page_info->io_procs->fseek(bfile, 0, SEEK_SET, page_info->bfname);
+    pos = sizeof(cb);
+    if (page_info->io_procs->fread_chars(&cb, sizeof(cb), bfile) < sizeof(cb))
+        pos = page_info->bfile_end_pos;	/* no blocks */
+    for (; pos < page_info->bfile_end_pos; pos += sizeof(next)) {
+        if (page_info->io_procs->fread_chars(&next, sizeof(next), bfile) < sizeof(next))
+            break;
+        if (cb.band_min != cmd_band_end && cb.band_max >= 0 && next.pos > cb.pos) {
+            if (cb.band_min >= nbands) {
+                /* The color usage is derived from the band commands, so
+                   it needn't change the keys of bands that didn't. */
+                if (cb.band_min != nbands + COLOR_USAGE_OFFSET - 1) {
+                    clist_digest_cfile(crdev, cb.pos, next.pos - cb.pos, digest);
+                    pSHA256_Update(&extra_ctx, digest, BAND_KEY_SIZE);
+                }
+            } else {
+                int band_max = min(cb.band_max, nbands - 1);
+
+                clist_digest_cfile(crdev, cb.pos, next.pos - cb.pos, digest);
+                for (band = max(cb.band_min, 0); band <= band_max; band++)
+                    pSHA256_Update(&band_ctx[band], digest, BAND_KEY_SIZE);
+            }
+        }
+        cb = next;
+    }
+    page_info->io_procs->fseek(bfile, save_pos, SEEK_SET, page_info->bfname);
+
+    band_key_color_state(&extra_ctx, crdev);
+    pSHA256_Final(digest, &extra_ctx);
+    for (band = 0; band < nbands; band++) {
+        pSHA256_Update(&band_ctx[band], digest, BAND_KEY_SIZE);
+        pSHA256_Final(crdev->band_hashes + (size_t)band * BAND_KEY_SIZE, &band_ctx[band]);
+    }
+    gs_free_object(mem, band_ctx, "clist_read_band_hashes");
+    return 0;
+}
+
+void
+clist_free_band_hashes(gx_device_clist_reader *crdev)
+{
+    gs_free_object(crdev->memory->non_gc_memory, crdev->band_hashes,
+                   "clist_free_band_hashes");
+    crdev->band_hashes = NULL;
+}
+
+void
+clist_free_band_render_cache(gx_device_clist_common *cdev)
+{
+    gx_band_render_cache *cache = cdev->band_render_cache;
+    gx_band_render_cache_entry *entry, *next;
+
+    if (cache == NULL)
+        return;
+    if_debug3m(':', cdev->memory, "[:]band render cache: %ld hits, %ld misses, %"PRIdSIZE" bytes\n",
+               cache->hits, cache->misses, cache->size);
+    for (entry = cache->head; entry != NULL; entry = next) {
+        next = entry->next;
+        gs_free_object(cache->memory, entry, "clist_free_band_render_cache");
+    }
+    gx_monitor_free(cache->monitor);
+    gs_free_object(cache->memory, cache, "clist_free_band_render_cache");
+    cdev->band_render_cache = NULL;
+}
+
 /* Unserialize the icc table information stored in the cfile and
    place it in the reader device */
 static int
@@ -710,6 +1025,11 @@ clist_render_init(gx_device_clist *dev)
     crdev->icc_table = NULL;
     crdev->color_usage_array = NULL;
     crdev->render_threads = NULL;
+    crdev->num_render_threads = 0;
+    crdev->band_schedule = NULL;
+    crdev->band_schedule_monitor = NULL;
+    crdev->band_costs = NULL;
+    crdev->band_hashes = NULL;
 
     return 0;
 }
@@ -907,6 +1227,147 @@ clist_rasterize_lines(gx_device *dev, int y, int line_count,
     return line_count;
 }
 
+/*
+ * If every band in the range holds nothing but a fillpage with the same
+ * pure color, fill the buffer device with that color rather than playing
+ * the band list back.  Returns 1 if the bands were produced this way, 0 if
+ * they must be rendered, or a negative error code.
+ */
+static int
+clist_render_solid_bands(gx_device_clist_reader *crdev, gx_device *bdev,
+                         int band_first, int band_last)
+{
+    const gx_color_usage_t *usage = crdev->color_usage_array;
+    int band, code;
+
+    /* Plane extraction and tag planes need the full playback. */
+    if (usage == NULL || crdev->yplane.index >= 0 ||
+        (bdev->graphics_type_tag & GS_DEVICE_ENCODES_TAGS))
+        return 0;
+    for (band = band_first; band <= band_last; band++)
+        if (usage[band].content == gx_band_content_drawn ||
+            usage[band].solid_color != usage[band_first].solid_color)
+            return 0;
+    if_debug3m('l', bdev->memory, "[l]bands (%d,%d) are solid 0x%"PRIx64"\n",
+               band_first, band_last, (uint64_t)usage[band_first].solid_color);
+    /* This is what playing back the fillpage would do. */
+    code = (*dev_proc(bdev, fill_rectangle))(bdev, 0, 0, bdev->width,
+                                             bdev->height,
+                                             usage[band_first].solid_color);
+    return code < 0 ? code : 1;
+}
+
+/* The band_render_cache only holds single bands of the current page */
+/* rendered across the full width of a chunky memory device. */
+static bool
+clist_band_render_cacheable(gx_device_clist_reader *crdev, gx_device *bdev,
+                            const gs_int_rect *prect, int band_first, int band_last)
+{
+    return crdev->band_render_cache != NULL && crdev->band_hashes != NULL &&
+        band_first == band_last && crdev->yplane.index < 0 &&
+        gs_device_is_memory(bdev) && bdev->num_planar_planes == 0 &&
+        prect->p.x <= 0 && prect->q.x >= bdev->width &&
+        prect->q.y - prect->p.y <= bdev->height;
+}
+
+static bool
+band_render_cache_match(const gx_band_render_cache_entry *entry, const byte *key,
+                        int band, const gs_int_rect *prect, const gx_device *bdev)
+{
+    return entry->band == band && !memcmp(entry->key, key, BAND_KEY_SIZE) &&
+        entry->rect.p.x == prect->p.x && entry->rect.p.y == prect->p.y &&
+        entry->rect.q.x == prect->q.x && entry->rect.q.y == prect->q.y &&
+        entry->width == bdev->width && entry->depth == bdev->color_info.depth &&
+        entry->raster == ((const gx_device_memory *)bdev)->raster;
+}
+
+/*
+ * Look a band up in the band_render_cache. Returns 1 and copies the bits
+ * into bdev if an earlier page rendered the same band, 0 if it must be
+ * rendered.
+ */
+static int
+clist_band_render_cache_lookup(gx_device_clist_reader *crdev, gx_device *bdev,
+                               const gs_int_rect *prect, int band)
+{
+    gx_band_render_cache *cache = crdev->band_render_cache;
+    gx_device_memory *mdev = (gx_device_memory *)bdev;
+    const byte *key = crdev->band_hashes + (size_t)band * BAND_KEY_SIZE;
+    gx_band_render_cache_entry *entry, *prev = NULL;
+    int y, lines = prect->q.y - prect->p.y;
+
+    gx_monitor_enter(cache->monitor);
+    for (entry = cache->head; entry != NULL; prev = entry, entry = entry->next)
+        if (band_render_cache_match(entry, key, band, prect, bdev))
+            break;
+    if (entry == NULL) {
+        cache->misses++;
+        gx_monitor_leave(cache->monitor);
+        return 0;
+    }
+    if (prev != NULL) {
+        prev->next = entry->next;
+        entry->next = cache->head;
+        cache->head = entry;
+    }
+    cache->hits++;
+    for (y = 0; y < lines; y++)
+        memcpy(scan_line_base(mdev, y), (byte *)(entry + 1) + (size_t)y * entry->raster,
+               entry->raster);
+    gx_monitor_leave(cache->monitor);
+    if_debug1m('l', bdev->memory, "[l]band %d copied from the render cache\n", band);
+    return 1;
+}
+
+/* Keep a band that has just been rendered. Failing to do so isn't an error. */
+static void
+clist_band_render_cache_store(gx_device_clist_reader *crdev, gx_device *bdev,
+                              const gs_int_rect *prect, int band)
+{
+    gx_band_render_cache *cache = crdev->band_render_cache;
+    gx_device_memory *mdev = (gx_device_memory *)bdev;
+    const byte *key = crdev->band_hashes + (size_t)band * BAND_KEY_SIZE;
+    gx_band_render_cache_entry *entry, **pprev;
+    int y, lines = prect->q.y - prect->p.y;
+    size_t size = sizeof(*entry) + (size_t)lines * mdev->raster;
+
+    if (size > cache->max_size)
+        return;
+    gx_monitor_enter(cache->monitor);
+    /* Another thread may have rendered the same band. */
+    for (entry = cache->head; entry != NULL; entry = entry->next)
+        if (band_render_cache_match(entry, key, band, prect, bdev)) {
+            gx_monitor_leave(cache->monitor);
+            return;
+        }
+    /* Evict the least recently used entries to make room. */
+    while (cache->size + size > cache->max_size) {
+        for (pprev = &cache->head; (*pprev)->next != NULL; pprev = &(*pprev)->next)
+            ;
+        cache->size -= (*pprev)->size;
+        gs_free_object(cache->memory, *pprev, "clist_band_render_cache_store");
+        *pprev = NULL;
+    }
+    entry = (gx_band_render_cache_entry *)gs_alloc_bytes(cache->memory, size,
+                                                "clist_band_render_cache_store");
+    if (entry != NULL) {
+        memcpy(entry->key, key, BAND_KEY_SIZE);
+        entry->band = band;
+        entry->rect = *prect;
+        entry->width = bdev->width;
+        entry->depth = bdev->color_info.depth;
+        entry->raster = mdev->raster;
+        entry->size = size;
+        for (y = 0; y < lines; y++)
+            memcpy((byte *)(entry + 1) + (size_t)y * entry->raster,
+                   scan_line_base(mdev, y), entry->raster);
+        entry->next = cache->head;
+        cache->head = entry;
+        cache->size += size;
+    }
+    gx_monitor_leave(cache->monitor);
+}
+
 /*
  * Render a rectangle to a client-supplied device.  There is no necessary
  * relationship between band boundaries and the region being rendered.
@@ -927,6 +1388,7 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
     int code = 0;
     int i;
     bool save_pageneutralcolor;
+    bool use_cache;
 
     if (render_plane)
         crdev->yplane = *render_plane;
@@ -935,6 +1397,7 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
     if_debug2m('l', bdev->memory, "[l]rendering bands (%d,%d)\n", band_first, band_last);
 
     ppages = crdev->pages;
+    use_cache = clist_band_render_cacheable(crdev, bdev, prect, band_first, band_last);
 
     /* Before playing back the clist, make sure that the gray detection is disabled */
     /* so we don't slow down the rendering (primarily high level images).           */
@@ -954,6 +1417,14 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
                 bdev->band_offset_x = 0;
                 bdev->band_offset_y = band_first * (long)band_height;
                 pinfo = &(crdev->page_info);
+                code = clist_render_solid_bands(crdev, bdev, band_first, band_last);
+                if (code == 0 && use_cache)
+                    code = clist_band_render_cache_lookup(crdev, bdev, prect, band_first);
+                if (code != 0) {
+                    if (code > 0)
+                        code = 0;
+                    break;
+                }
         } else {
             const gx_placed_page *ppage = &ppages[i];
 
@@ -1002,6 +1473,8 @@ clist_render_rectangle(gx_device_clist *cldev, const gs_int_rect *prect,
                                          bdev, band_first, band_last,
                                          prect->p.x - bdev->band_offset_x,
                                          prect->p.y);
+        if (code >= 0 && ppages == NULL && use_cache)
+            clist_band_render_cache_store(crdev, bdev, prect, band_first);
     }
     crdev->icc_struct->pageneutralcolor = save_pageneutralcolor;	/* restore it */
     return code;
@@ -321,6 +321,18 @@ clist_fillpage(gx_device * dev, gs_gstate *pgs, gx_drawing_color *pdcolor)
     code = cmd_put_drawing_color(cdev, pcls, pdcolor, NULL, devn_not_tile_fill);
     if (code >= 0)
         code = cmd_write_page_rect_cmd(cdev, cmd_op_fill_rect);
+    if (code >= 0 && gx_dc_is_pure(pdcolor)) {
+        /* Until something else is drawn, every band is just this color. */
+        gx_color_index color = gx_dc_pure_color(pdcolor);
+        gx_band_content_t content = (color == gx_device_white(dev) ?
+                                     gx_band_content_blank :
+                                     gx_band_content_solid);
+
+        for (pcls = cdev->states; pcls < cdev->states + cdev->nbands; pcls++) {
+            pcls->color_usage.content = content;
+            pcls->color_usage.solid_color = color;
+        }
+    }
     return code;
 }
 
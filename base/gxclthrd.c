@@ -38,10 +38,18 @@
 #include "gstrans.h"
 #include "gzht.h"		/* for gx_ht_cache_default_bits_size */
 
+/* Bytes of freed large blocks (band sized buffers for images and
+ * transparency) that each thread's allocator keeps for reuse, rather than
+ * returning them to the shared, locked, allocator. 0 disables this. */
+#ifndef CLIST_THREAD_BLOCK_CACHE_SIZE
+#  define CLIST_THREAD_BLOCK_CACHE_SIZE (16 * 1024 * 1024)
+#endif
+
 /* Forward reference prototypes */
 static int clist_start_render_thread(gx_device *dev, int thread_index, int band);
 static void clist_render_thread(void* param);
 static void clist_render_thread_no_output_fn(void* param);
+static void clist_free_band_schedule(gx_device_clist_reader *crdev, gs_memory_t *mem);
 
 /*
         Notes on operation:
@@ -98,6 +106,14 @@ static void clist_render_thread_no_output_fn(void* param);
         modulo any blocking that happens within the process_fn. For
         devices which can operate in this way, non-trivial speedups
         can be given.
+
+        Such devices can further ask for GX_PROCPAGE_COST_SCHEDULE.
+        Rather than walking the bands in order, the bands are then
+        handed out (via clist_claim_next_band) most expensive first,
+        using the size of each band's command list as the estimate.
+        A single pathological band is thus started straight away,
+        and the cheap bands fill in around it, rather than it being
+        reached last and leaving every other thread idle.
 */
 
 /* clone a device and set params and its chunk memory                   */
@@ -133,6 +149,9 @@ setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_device *dev, boo
         emprintf1(dev->memory, "chunk_wrap returned error code: %d\n", code);
         return NULL;
     }
+    /* The thread is the only user of the chunk allocator, so it can keep */
+    /* the large blocks it frees without any locking.                     */
+    gs_memory_chunk_set_block_cache(thread_mem, CLIST_THREAD_BLOCK_CACHE_SIZE);
     /* Find the prototype for this device (needed so we can copy from it) */
     for (i=0; (protodev = (gx_device *)gs_getdevice(i)) != NULL; i++)
         if (strcmp(protodev->dname, dev->dname) == 0)
@@ -333,11 +352,22 @@ setup_device_and_mem_for_thread(gs_memory_t *chunk_base_mem, gx_device *dev, boo
         /* writer mode, the foreground's array will be freed.                          */
         if ((code = clist_read_color_usage_array(ncrdev)) < 0)
             goto out_cleanup;
+        /* The band render cache belongs to the foreground device, which keeps */
+        /* it across clist_open for the next page; this thread only borrows it. */
+        if ((code = clist_alloc_band_render_cache(cdev)) < 0)
+            goto out_cleanup;
+        ncdev->band_render_cache = cdev->band_render_cache;
+        if ((code = clist_read_band_hashes(ncrdev)) < 0)
+            goto out_cleanup;
     } else {
     /* Use the same profile table and color usage array in each thread */
         ncdev->icc_table = cdev->icc_table;		/* OK for multiple rendering threads */
         ((gx_device_clist_reader *)ncdev)->color_usage_array =
                 ((gx_device_clist_reader *)cdev)->color_usage_array;
+        /* and the band render cache, which is shared by all of them */
+        ncdev->band_render_cache = cdev->band_render_cache;
+        ((gx_device_clist_reader *)ncdev)->band_hashes =
+                ((gx_device_clist_reader *)cdev)->band_hashes;
     }
     /* Needed for case when the target has cielab profile and pdf14 device
        has a RGB profile stored in the profile list of the clist */
@@ -353,6 +383,7 @@ out_cleanup:
     if (ncdev->page_info.cfile != NULL)
         ncdev->page_info.io_procs->fclose(ncdev->page_info.cfile, ncdev->page_info.cfname, false);
     ncdev->do_not_open_or_close_bandfiles = true; /* we already closed the files */
+    ncdev->band_render_cache = NULL;	/* owned by the main device */
 
     /* we can't get here with ndev == NULL */
     gdev_prn_free_memory(ndev);
@@ -361,6 +392,188 @@ out_cleanup:
     return NULL;
 }
 
+typedef struct band_cost_s {
+    int64_t cost;
+    int band;
+} band_cost_t;
+
+static int
+band_cost_compare(const void *a, const void *b)
+{
+    const band_cost_t *ca = (const band_cost_t *)a;
+    const band_cost_t *cb = (const band_cost_t *)b;
+
+    if (ca->cost != cb->cost)
+        return ca->cost > cb->cost ? -1 : 1;
+    return ca->band - cb->band;
+}
+
+/* Build the order in which bands are handed out in the
+ * GX_PROCPAGE_COST_SCHEDULE mode. The cost of a band is estimated from the
+ * size of its command list, and the most expensive bands are scheduled
+ * first so that the slowest band is not left until the end of the page
+ * with every other thread idle. Bands of equal cost keep their order in
+ * the lookahead direction.
+ */
+static int
+clist_setup_band_schedule(gx_device_clist_reader *crdev, gs_memory_t *mem)
+{
+    int band_count = crdev->nbands;
+    int64_t *costs;
+    band_cost_t *order;
+    int i, code;
+
+    crdev->band_schedule = (int *)gs_alloc_byte_array(mem, band_count, sizeof(int),
+                                                      "clist_setup_band_schedule");
+    costs = (int64_t *)gs_alloc_byte_array(mem, band_count, sizeof(int64_t),
+                                           "clist_setup_band_schedule");
+    order = (band_cost_t *)gs_alloc_byte_array(mem, band_count, sizeof(band_cost_t),
+                                               "clist_setup_band_schedule");
+    crdev->band_schedule_monitor = gx_monitor_label(gx_monitor_alloc(mem), "BandSchedule");
+    if (crdev->band_schedule == NULL || costs == NULL || order == NULL ||
+        crdev->band_schedule_monitor == NULL) {
+        code = gs_note_error(gs_error_VMerror);
+        goto out;
+    }
+    code = clist_read_band_costs(crdev, costs);
+    if (code < 0)
+        goto out;
+    for (i = 0; i < band_count; i++) {
+        order[i].cost = costs[i];
+        order[i].band = crdev->thread_lookahead_direction > 0 ? i : band_count - 1 - i;
+    }
+    qsort(order, band_count, sizeof(band_cost_t), band_cost_compare);
+    for (i = 0; i < band_count; i++) {
+        crdev->band_schedule[i] = crdev->thread_lookahead_direction > 0 ?
+                                  order[i].band : band_count - 1 - order[i].band;
+        if_debug3m(':', mem, "[:]band schedule %d: band %d, cost %"PRId64"\n",
+                   i, crdev->band_schedule[i], order[i].cost);
+    }
+    crdev->band_schedule_next = 0;
+
+out:
+    gs_free_object(mem, order, "clist_setup_band_schedule");
+    gs_free_object(mem, costs, "clist_setup_band_schedule");
+    if (code < 0)
+        clist_free_band_schedule(crdev, mem);
+    return code;
+}
+
+static void
+clist_free_band_schedule(gx_device_clist_reader *crdev, gs_memory_t *mem)
+{
+    if (crdev->band_schedule_monitor != NULL)
+        gx_monitor_free(crdev->band_schedule_monitor);
+    crdev->band_schedule_monitor = NULL;
+    gs_free_object(mem, crdev->band_schedule, "clist_free_band_schedule");
+    crdev->band_schedule = NULL;
+    gs_free_object(mem, crdev->band_costs, "clist_setup_band_costs");
+    crdev->band_costs = NULL;
+}
+
+/* When the bands are output in order, a thread that finishes a band can't
+ * start another until the band has been output, so one expensive band holds
+ * up the output while the other threads sit on finished bands. Bands that
+ * are expensive to render (by the same estimate as clist_setup_band_schedule)
+ * are therefore handed out early, if they are no more than this many bands
+ * per thread ahead of the bands being rendered in order.
+ */
+#define BAND_COST_LOOKAHEAD_PER_THREAD 2
+
+/* Read the band costs for clist_take_band. If we can't, the bands are just
+ * handed out in order. */
+static void
+clist_setup_band_costs(gx_device_clist_reader *crdev, gs_memory_t *mem)
+{
+    crdev->band_costs = (int64_t *)gs_alloc_byte_array(mem, crdev->nbands, sizeof(int64_t),
+                                                       "clist_setup_band_costs");
+    if (crdev->band_costs == NULL)
+        return;
+    if (clist_read_band_costs(crdev, crdev->band_costs) < 0) {
+        gs_free_object(mem, crdev->band_costs, "clist_setup_band_costs");
+        crdev->band_costs = NULL;
+    }
+}
+
+/*
+ * Hand out the band for a thread to render when the output is in band order.
+ * This is next_band, the first band not yet handed out, unless the band
+ * costs are known and a band within the look ahead costs at least twice as
+ * much, in which case the most expensive such band is handed out instead.
+ * next_needed is the band the output will ask for next: that is never
+ * passed over, so it is always being rendered by the time it is wanted. No
+ * more than half the threads are given bands out of order, so most of them
+ * keep working on the bands the output will want soonest. Returns -1 when
+ * every band has been handed out.
+ */
+static int
+clist_take_band(gx_device_clist_reader *crdev, int next_needed)
+{
+    int64_t *costs = crdev->band_costs;
+    int dir = crdev->thread_lookahead_direction;
+    int band = crdev->next_band;
+    int best = band;
+    int lookahead = crdev->num_render_threads * BAND_COST_LOOKAHEAD_PER_THREAD;
+    int ahead = 0;
+    int i, n;
+
+    if (band < 0 || band >= crdev->nbands)
+        return -1;
+    if (costs == NULL) {
+        crdev->next_band += dir;
+        return band;
+    }
+    if (band != next_needed) {
+        for (i = band + dir, n = 1; n < lookahead && i >= 0 && i < crdev->nbands; i += dir, n++) {
+            if (costs[i] < 0)
+                ahead++;
+            else if (costs[i] > costs[best])
+                best = i;
+        }
+        if (ahead >= max(crdev->num_render_threads / 2, 1) || costs[best] < 2 * costs[band])
+            best = band;
+        else
+            if_debug4m(':', crdev->memory, "[:]band %d (cost %"PRId64") ahead of band %d (cost %"PRId64")\n",
+                       best, costs[best], band, costs[band]);
+    }
+    costs[best] = -1;
+    while (crdev->next_band >= 0 && crdev->next_band < crdev->nbands &&
+           costs[crdev->next_band] < 0)
+        crdev->next_band += dir;
+    return best;
+}
+
+/* Return the band for the next thread started by clist_setup_render_threads */
+static int
+clist_setup_next_band(gx_device_clist_reader *crdev, int band, int thread_index)
+{
+    if (crdev->band_schedule != NULL)
+        return thread_index < crdev->nbands ? crdev->band_schedule[thread_index] : -1;
+    if (crdev->band_costs != NULL)
+        return thread_index < crdev->num_render_threads ? clist_take_band(crdev, -1) : -1;
+    return band + crdev->thread_lookahead_direction;
+}
+
+int
+clist_claim_next_band(gx_device *dev)
+{
+    gx_device_clist_reader *crdev = &((gx_device_clist *)dev)->reader;
+    gx_device_clist_reader *orig_dev = crdev->orig_clist_device;
+    int code;
+
+    if (orig_dev == NULL || orig_dev->band_schedule == NULL)
+        return_error(gs_error_undefined);
+
+    code = gx_monitor_enter(orig_dev->band_schedule_monitor);
+    if (code < 0)
+        return code;
+    if (orig_dev->band_schedule_next < orig_dev->nbands)
+        crdev->next_band = orig_dev->band_schedule[orig_dev->band_schedule_next++];
+    else
+        crdev->next_band = -1;
+    return gx_monitor_leave(orig_dev->band_schedule_monitor);
+}
+
 /* Set up and start the render threads */
 static int
 clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *options)
@@ -436,11 +649,23 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
     /* Almost all devices go in increasing line order (except the bmp* devices ) */
     crdev->thread_lookahead_direction = (y < (cdev->height - 1)) ? 1 : -1;
     band = y / band_height;
+    if (options && options->output_fn == NULL && (options->options & GX_PROCPAGE_COST_SCHEDULE)) {
+        if ((code = clist_setup_band_schedule(crdev, mem)) < 0)
+            goto fail;
+        band = crdev->band_schedule[0];
+    } else if ((options == NULL || options->output_fn != NULL) && crdev->num_render_threads > 1) {
+        clist_setup_band_costs(crdev, mem);
+        if (crdev->band_costs != NULL) {
+            crdev->next_band = band;
+            band = clist_take_band(crdev, band);
+        }
+    }
 
     /* If the 'mem' is not thread safe, we need to wrap it in a locking memory */
     gs_memory_status(chunk_base_mem, &mem_status);
     if (mem_status.is_thread_safe == false) {
-            return_error(gs_error_VMerror);
+        code = gs_note_error(gs_error_VMerror);
+        goto fail;
     }
 
     /* If we don't have one large enough already, create an icc cache list */
@@ -450,8 +675,9 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
                                     crdev->num_render_threads,
                                     sizeof(void*), "clist_render_setup_threads");
         if (crdev->icc_cache_list == NULL) {
-            crdev->icc_cache_list = NULL;
-            return_error(gs_error_VMerror);
+            crdev->icc_cache_list = old;
+            code = gs_note_error(gs_error_VMerror);
+            goto fail;
         }
         if (crdev->icc_cache_list_len > 0)
             memcpy(crdev->icc_cache_list, old, crdev->icc_cache_list_len * sizeof(gsicc_link_cache_t *));
@@ -463,7 +689,7 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
 
     /* Loop creating the devices and semaphores for each thread, then start them */
     for (i=0; (i < crdev->num_render_threads) && (band >= 0) && (band < band_count);
-            i++, band += crdev->thread_lookahead_direction) {
+            i++, band = clist_setup_next_band(crdev, band, i)) {
         gx_device *ndev;
         clist_render_thread_control_t *thread = &(crdev->render_threads[i]);
 
@@ -557,8 +783,6 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
                 gs_free_object(mem, chunk_base_mem, "clist_setup_render_threads(locked allocator)");
             }
         }
-        gs_free_object(mem, crdev->render_threads, "clist_setup_render_threads");
-        crdev->render_threads = NULL;
         /* restore the file pointers */
         if (cdev->page_info.cfile == NULL) {
             char fmode[4];
@@ -573,12 +797,21 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
             cdev->page_info.io_procs->fseek(cdev->page_info.bfile, 0, SEEK_SET, cdev->page_info.bfname);
         }
         emprintf1(mem, "Rendering threads not started, code=%d.\n", code);
-        return_error(code);
+        code = gs_note_error(code);
+        goto fail;
+    }
+    if (crdev->band_costs == NULL)
+        crdev->next_band = band;
+    else if (code < 0 && band >= 0 && band < band_count) {
+        /* Hand the band of the thread that couldn't be set up out again */
+        crdev->band_costs[band] = 0;
+        if ((band - crdev->next_band) * crdev->thread_lookahead_direction < 0)
+            crdev->next_band = band;
     }
     k = crdev->num_render_threads;
     crdev->num_render_threads = i;
     crdev->curr_render_thread = 0;
-    crdev->next_band = band;
+    crdev->band_schedule_next = i;
     /* Free up any "reserve" memory we may have allocated, and start the
      * threads since we deferred that in the thread setup loop above.
      * We know if we get here we can start at least 1 thread.
@@ -594,6 +827,16 @@ clist_setup_render_threads(gx_device *dev, int y, gx_process_page_options_t *opt
         dmprintf1(mem, "%% Using %d rendering threads\n", i);
 
     return code;
+
+fail:
+    /* No thread was started: free what was set up for them. */
+    for (j = 0; j < crdev->num_render_threads; j++)
+        gs_free_object(mem, reserve_memory_array[j], "clist_setup_render_threads");
+    gs_free_object(mem, reserve_memory_array, "clist_setup_render_threads");
+    gs_free_object(mem, crdev->render_threads, "clist_setup_render_threads");
+    crdev->render_threads = NULL;
+    clist_free_band_schedule(crdev, mem);
+    return code;
 }
 
 /* This is also exported for teardown after background printing */
@@ -618,6 +861,7 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
     } else {
         /* make sure this doesn't get freed by gdev_prn_free_memory below */
         ((gx_device_clist_reader *)thread_cdev)->color_usage_array = NULL;
+        thread_crdev->band_hashes = NULL;
 
         /* For non-bg_print cases the icc_table is shared between devices, but
          * is not reference counted or anything. We rely on it being shared with
@@ -626,6 +870,8 @@ teardown_device_and_mem_for_thread(gx_device *dev, gp_thread_id thread_id, bool
          */
         thread_crdev->icc_table = NULL;
     }
+    /* The band render cache belongs to the main device */
+    thread_cdev->band_render_cache = NULL;
     rc_decrement(thread_crdev->icc_cache_cl, "teardown_render_thread");
     thread_crdev->icc_cache_cl = NULL;
     /*
@@ -709,6 +955,7 @@ clist_teardown_render_threads(gx_device *dev)
         }
         gs_free_object(mem, crdev->render_threads, "clist_teardown_render_threads");
         crdev->render_threads = NULL;
+        clist_free_band_schedule(crdev, mem);
 
         /* Now re-open the clist temp files so we can write to them */
         if (cdev->page_info.cfile == NULL) {
@@ -930,11 +1177,23 @@ clist_get_band_from_thread(gx_device *dev, int band_needed, gx_process_page_opti
     gx_device_clist_common *thread_cdev = (gx_device_clist_common *)thread->cdev;
     int band_height = crdev->page_info.band_params.BandHeight;
     int band_count = cdev->nbands;
+    int band;
     byte *tmp;                  /* for swapping data areas */
 
-    /* We expect that the thread needed will be the 'current' thread */
+    /* We expect that the thread needed will be the 'current' thread, but */
+    /* expensive bands may have been handed out ahead of their turn.      */
+    if (thread->band != band_needed && crdev->band_costs != NULL) {
+        for (i = 0; i < crdev->num_render_threads; i++) {
+            if (crdev->render_threads[i].band == band_needed) {
+                thread_index = i;
+                thread = &(crdev->render_threads[i]);
+                thread_cdev = (gx_device_clist_common *)thread->cdev;
+                break;
+            }
+        }
+    }
     if (thread->band != band_needed) {
-        int band = band_needed;
+        band = band_needed;
 
         emprintf3(thread->memory,
                   "thread->band = %d, band_needed = %d, direction = %d, ",
@@ -957,6 +1216,9 @@ clist_get_band_from_thread(gx_device *dev, int band_needed, gx_process_page_opti
             crdev->thread_lookahead_direction = 1;    /* force forward if we are looking for band 0 */
 
         dmprintf1(thread->memory, "new_direction = %d\n", crdev->thread_lookahead_direction);
+        /* From here on the bands are handed out strictly in order */
+        gs_free_object(cdev->bandlist_memory, crdev->band_costs, "clist_setup_band_costs");
+        crdev->band_costs = NULL;
 
         /* Loop starting the threads in the new lookahead_direction */
         for (i=0; (i < crdev->num_render_threads) && (band >= 0) && (band < band_count);
@@ -997,13 +1259,12 @@ clist_get_band_from_thread(gx_device *dev, int band_needed, gx_process_page_opti
     if (cdev->ymax > dev->height)
         cdev->ymax = dev->height;
 
-    if (crdev->next_band >= 0 && crdev->next_band < band_count) {
-        code = clist_start_render_thread(dev, thread_index, crdev->next_band);
-        crdev->next_band += crdev->thread_lookahead_direction;
-    }
+    band = clist_take_band(crdev, band_needed + crdev->thread_lookahead_direction);
+    if (band >= 0)
+        code = clist_start_render_thread(dev, thread_index, band);
     /* bump the 'curr' to the next thread */
-    crdev->curr_render_thread = crdev->curr_render_thread == crdev->num_render_threads - 1 ?
-                0 : crdev->curr_render_thread + 1;
+    crdev->curr_render_thread = thread_index == crdev->num_render_threads - 1 ?
+                0 : thread_index + 1;
 
     return code;
 }
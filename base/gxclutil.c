@@ -392,6 +392,12 @@ cmd_put_list_op(gx_device_clist_writer * cldev, cmd_list * pcl, uint size)
 #endif
 
         cmd_count_add1(stats_cmd.other_band);
+        /* Anything written to a single band may draw into it, so the */
+        /* band can no longer be reproduced from its page fill alone. */
+        if (pcl != cldev->band_range_list)
+            cldev->states[((intptr_t)pcl - (intptr_t)&cldev->states->list) /
+                          sizeof(*cldev->states)].color_usage.content =
+                gx_band_content_drawn;
         dp = (byte *) (cp + 1);
         if (pcl->tail != 0) {
 #ifdef DEBUG
@@ -34,10 +34,12 @@ clist_decompressor_template(void)
     return &s_zlibD_template;
 }
 void
-clist_compressor_init(stream_state *state)
+clist_compressor_init(stream_state *state, bool favor_speed)
 {
     s_zlib_set_defaults(state);
     ((stream_zlib_state *)state)->no_wrapper = true;
+    if (favor_speed)
+        ((stream_zlib_state *)state)->level = 1; /* Z_BEST_SPEED */
     state->templat = &s_zlibE_template;
 }
 void
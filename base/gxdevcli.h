@@ -677,14 +677,25 @@ typedef struct gx_device_cached_colors_s {
  */
 /* if you make any additions/changes to this structure you need to make
    the appropriate additions/changes to gdev_space_params_cmp() */
+typedef enum {
+    BandListCompressAuto = 0,	/* compress when the band list gets large */
+    BandListCompressAlways	/* compress all of a memory band list */
+} gdev_band_list_compression;
+
 typedef struct gx_band_params_s {
     int BandWidth;		/* (optional) band width in pixels */
     int BandHeight;		/* (optional) */
     size_t BandBufferSpace;	/* (optional) */
     size_t tile_cache_size;	/* (optional) */
+    gdev_band_list_compression compression;	/* (optional) */
+    bool adaptive;		/* (optional) choose BandHeight per page */
+    size_t render_cache_size;	/* (optional) bytes of rendered bands to */
+                                /* keep across pages, 0 = none */
+    bool report_stats;		/* (optional) report band list codec */
+                                /* statistics for each page */
 } gx_band_params_t;
 
-#define BAND_PARAMS_INITIAL_VALUES 0, 0, 0, 0
+#define BAND_PARAMS_INITIAL_VALUES 0, 0, 0, 0, BandListCompressAuto, false, 0, false
 
 typedef enum {
     BandingAuto = 0,
@@ -1425,6 +1436,15 @@ struct gx_process_page_options_s
  * 0 to n-1. */
 #define GX_PROCPAGE_BOTTOM_UP 1
 
+/* If GX_PROCPAGE_COST_SCHEDULE (only used when output_fn == NULL), the
+ * bands are handed out in decreasing order of their estimated rendering
+ * cost, so that a single expensive band is started early rather than
+ * being left until last. The process_fn must then select its next band
+ * by calling clist_claim_next_band rather than updating next_band itself.
+ * (With an output_fn, the costs are used anyway, but only to start an
+ * expensive band a little ahead of its turn: see clist_take_band.) */
+#define GX_PROCPAGE_COST_SCHEDULE 2
+
 #define dev_t_proc_process_page(proc, dev_t)\
   int proc(dev_t *dev, gx_process_page_options_t *options)
 #define dev_proc_process_page(proc)\
@@ -27,6 +27,10 @@
 #include "ets.h"
 #endif
 
+#ifdef HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 /* Nasty inline declaration, as gxht_thresh.h requires penum */
 void gx_ht_threshold_row_bit_sub(byte *contone,  byte *threshold_strip,
                              int contone_stride, byte *halftone,
@@ -1184,6 +1188,95 @@ static void down_core4_mfs(gx_downscaler_t *ds,
     pack_8to1(out_buffer, outp, awidth*4);
 }
 
+/* Box filter code shared by the 8 bit cores (no error diffusion) */
+
+/* Number of column sums that down_box8 works on at a time. */
+#define DOWN_BOX_SUMS 512
+
+/* Sum 'factor' rows, 'span' bytes apart, of 'n' bytes each into sums. */
+static void down_sum_rows8(ushort *sums, const byte *inp, int n, int span,
+                           int factor)
+{
+    int i = 0, y;
+    const byte *p;
+#ifdef HAVE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i lo = zero;
+        __m128i hi = zero;
+
+        p = inp + i;
+        for (y = factor; y > 0; y--)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)p);
+
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+            p += span;
+        }
+        _mm_storeu_si128((__m128i *)(sums + i), lo);
+        _mm_storeu_si128((__m128i *)(sums + i + 8), hi);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        int value = 0;
+
+        p = inp + i;
+        for (y = factor; y > 0; y--)
+        {
+            value += *p;
+            p += span;
+        }
+        sums[i] = value;
+    }
+}
+
+/* Average each factor x factor block of pixels of nc interleaved 8 bit
+ * components. This is inlined so that the callers with a fixed factor
+ * get code specialised for it. The rows are summed first, in a way the compiler (or SSE2)
+ * can do many bytes at a time, and then the columns; the result is the
+ * same as summing each block in turn. The division by factor*factor is
+ * done by multiplying by a reciprocal, which is exact for these sums. */
+inline static void down_box8(gx_downscaler_t *ds,
+                             byte            *outp,
+                             byte            *inp,
+                             int              span,
+                             int              factor,
+                             int              nc)
+{
+    ushort sums[DOWN_BOX_SUMS];
+    int    div    = factor*factor;
+    uint64_t recip = ((uint64_t)1<<32)/div + 1;
+    int    step   = factor*nc;
+    int    chunk  = DOWN_BOX_SUMS / step;
+    int    x, xx, c, n;
+
+    for (x = ds->awidth; x > 0; x -= n)
+    {
+        const ushort *s = sums;
+
+        n = min(x, chunk);
+        down_sum_rows8(sums, inp, n * step, span, factor);
+        for (xx = n; xx > 0; xx--)
+        {
+            for (c = 0; c < nc; c++)
+            {
+                int value = 0;
+                int i;
+
+                for (i = 0; i < step; i += nc)
+                    value += s[i + c];
+                *outp++ = (byte)(((value + (div>>1)) * recip) >> 32);
+            }
+            s += step;
+        }
+        inp += n * step;
+    }
+}
+
 /* Grey (or planar) downscale code */
 static void down_core16(gx_downscaler_t *ds,
                         byte            *outp,
@@ -1246,13 +1339,12 @@ static void down_core8(gx_downscaler_t *ds,
                        int              plane,
                        int              span)
 {
-    int   x, xx, y, value;
+    int   y;
     int   pad_white;
     byte *inp;
     int   width  = ds->width;
     int   awidth = ds->awidth;
     int   factor = ds->factor;
-    int   div    = factor*factor;
 
     pad_white = (awidth - width) * factor;
     if (pad_white < 0)
@@ -1268,25 +1360,7 @@ static void down_core8(gx_downscaler_t *ds,
         }
     }
 
-    inp = in_buffer;
-    {
-        /* Left to Right pass (no min feature size) */
-        const int back = span * factor -1;
-        for (x = awidth; x > 0; x--)
-        {
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            *outp++ = (value+(div>>1))/div;
-        }
-    }
+    down_box8(ds, outp, in_buffer, span, factor, 1);
 }
 
 static void down_core8_2(gx_downscaler_t *ds,
@@ -1529,13 +1603,12 @@ static void down_core24(gx_downscaler_t *ds,
                         int              plane,
                         int              span)
 {
-    int   x, xx, y, value;
+    int   y;
     int   pad_white;
     byte *inp;
     int   width  = ds->width;
     int   awidth = ds->awidth;
     int   factor = ds->factor;
-    int   div    = factor*factor;
 
     pad_white = (awidth - width) * factor * 3;
     if (pad_white < 0)
@@ -1551,54 +1624,13 @@ static void down_core24(gx_downscaler_t *ds,
         }
     }
 
-    inp = in_buffer;
-    {
-        /* Left to Right pass (no min feature size) */
-        const int back  = span * factor - 3;
-        const int back2 = factor * 3 - 1;
-        for (x = awidth; x > 0; x--)
-        {
-            /* R */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= back2;
-            *outp++ = (value+(div>>1))/div;
-            /* G */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= back2;
-            *outp++ = (value+(div>>1))/div;
-            /* B */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= 2;
-            *outp++ = (value+(div>>1))/div;
-        }
-    }
+    /* Give the common factors code of their own */
+    if (factor == 2)
+        down_box8(ds, outp, in_buffer, span, 2, 3);
+    else if (factor == 3)
+        down_box8(ds, outp, in_buffer, span, 3, 3);
+    else
+        down_box8(ds, outp, in_buffer, span, factor, 3);
 }
 
 /* CMYK downscale (no error diffusion) code */
@@ -1610,13 +1642,12 @@ static void down_core32(gx_downscaler_t *ds,
                         int              plane,
                         int              span)
 {
-    int   x, xx, y, value;
+    int   y;
     int   pad_white;
     byte *inp;
     int   width  = ds->width;
     int   awidth = ds->awidth;
     int   factor = ds->factor;
-    int   div    = factor*factor;
 
     pad_white = (awidth - width) * factor * 4;
     if (pad_white < 0)
@@ -1632,67 +1663,13 @@ static void down_core32(gx_downscaler_t *ds,
         }
     }
 
-    inp = in_buffer;
-    {
-        /* Left to Right pass (no min feature size) */
-        const int back  = span * factor - 4;
-        const int back2 = factor * 4 - 1;
-        for (x = awidth; x > 0; x--)
-        {
-            /* C */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= back2;
-            *outp++ = (value+(div>>1))/div;
-            /* M */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= back2;
-            *outp++ = (value+(div>>1))/div;
-            /* Y */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= back2;
-            *outp++ = (value+(div>>1))/div;
-            /* K */
-            value = 0;
-            for (xx = factor; xx > 0; xx--)
-            {
-                for (y = factor; y > 0; y--)
-                {
-                    value += *inp;
-                    inp += span;
-                }
-                inp -= back;
-            }
-            inp -= 3;
-            *outp++ = (value+(div>>1))/div;
-        }
-    }
+    /* Give the common factors code of their own */
+    if (factor == 2)
+        down_box8(ds, outp, in_buffer, span, 2, 4);
+    else if (factor == 3)
+        down_box8(ds, outp, in_buffer, span, 3, 4);
+    else
+        down_box8(ds, outp, in_buffer, span, factor, 4);
 }
 
 void gx_downscaler_decode_factor(int factor, int *up, int *down)
@@ -3243,7 +3220,10 @@ static int downscaler_process_fn(void *arg_, gx_device *dev, gx_device *bdev, co
     code = dev_proc(bdev, get_bits_rectangle)(bdev, &in_rect, &params);
     if (code < 0)
         return code;
-    raster_in = params.raster;
+    if (params.options & GB_RASTER_STANDARD)
+        raster_in = gx_device_raster(bdev, true);
+    else
+        raster_in = params.raster;
     in_ptr = params.data[0];
 
     /* Where do we write it to? */
@@ -3251,7 +3231,11 @@ static int downscaler_process_fn(void *arg_, gx_device *dev, gx_device *bdev, co
         code = dev_proc(bdev, get_bits_rectangle)(buffer->bdev, &out_rect, &params);
         if (code < 0)
             return code;
-        raster_out = params.raster;
+        /* A returned pointer comes with the standard raster. */
+        if (params.options & GB_RASTER_STANDARD)
+            raster_out = gx_device_raster(buffer->bdev, true);
+        else
+            raster_out = params.raster;
         out_ptr = params.data[0];
     } else {
         raster_out = raster_in;
@@ -3365,6 +3349,7 @@ int gx_downscaler_process_page(gx_device                 *dev,
     my_options.output_fn = options->output_fn ? downscaler_output_fn : NULL;
     my_options.free_buffer_fn = downscaler_free_fn;
     my_options.arg = &arg;
+    my_options.options = options->options;
 
     return dev_proc(dev, process_page)(dev, &my_options);
 }
@@ -21,6 +21,7 @@
 #include "gxfixed.h"
 #include "gxfarith.h"
 #include "gxgstate.h"		/* for access to line params */
+#include "gsstate.h"		/* for gs_getadaptiveflattening */
 #include "gzpath.h"
 
 /* Forward declarations */
@@ -90,6 +91,7 @@ gx_path_copy_reducing(const gx_path *ppath_old, gx_path *ppath,
     const segment *pseg;
     fixed flat = fixed_flatness;
     gs_fixed_point expansion;
+    bool adaptive = ppath->memory != NULL && gs_getadaptiveflattening(ppath->memory);
     /*
      * Since we're going to be adding to the path, unshare it
      * before we start.
@@ -204,7 +206,11 @@ gx_path_copy_reducing(const gx_path *ppath_old, gx_path *ppath,
                             start = ppath->current_subpath->last;
                             notes |= sn_not_first;
                             cseg = *pc;
-                            code = gx_subdivide_curve(ppath, k, &cseg, notes);
+                            if (adaptive)
+                                code = gx_subdivide_curve_adaptive(ppath, k, &cseg, notes,
+                                            gx_curve_flat_tolerance(x0, y0, pc, flat));
+                            else
+                                code = gx_subdivide_curve(ppath, k, &cseg, notes);
                             if (code < 0)
                                 break;
                             /*
@@ -231,7 +237,11 @@ gx_path_copy_reducing(const gx_path *ppath_old, gx_path *ppath,
                                 adjust_point_to_tangent(end, end->prev, &start->pt);
                         } else {
                             cseg = *pc;
-                            code = gx_subdivide_curve(ppath, k, &cseg, notes);
+                            if (adaptive)
+                                code = gx_subdivide_curve_adaptive(ppath, k, &cseg, notes,
+                                            gx_curve_flat_tolerance(x0, y0, pc, flat));
+                            else
+                                code = gx_subdivide_curve(ppath, k, &cseg, notes);
                         }
                     }
                     break;
@@ -95,6 +95,44 @@ gx_curve_log2_samples(fixed x0, fixed y0, const curve_segment * pc,
     return k;
 }
 
+/*
+ * When flattening adaptively, a curve is split at its midpoint, as often
+ * as gx_curve_log2_samples allows, except that a piece which is already
+ * within the flatness of its chord is not split any further.  The test
+ * uses D as defined above, so no piece is ever flattened less accurately
+ * than with uniform subdivision; the flatness gets the same treatment as
+ * there, except that a flatness of 0 (characters) becomes 1/8 pixel.
+ */
+fixed
+gx_curve_flat_tolerance(fixed x0, fixed y0, const curve_segment * pc,
+                        fixed fixed_flat)
+{
+    fixed
+        x03 = any_abs(pc->pt.x - x0),
+        y03 = any_abs(pc->pt.y - y0);
+
+    if ((x03 | y03) < int2fixed(16))
+        fixed_flat >>= 1;
+    if (fixed_flat == 0)
+        fixed_flat = fixed_1 >> 3;
+    return fixed_flat;
+}
+
+bool
+gx_curve_is_flat(fixed x0, fixed y0, fixed x1, fixed y1,
+                 fixed x2, fixed y2, fixed x3, fixed y3, fixed tolerance)
+{
+    int64_t
+        dx0 = (int64_t)x0 - x1 - x1 + x2, dy0 = (int64_t)y0 - y1 - y1 + y2,
+        dx1 = (int64_t)x1 - x2 - x2 + x3, dy1 = (int64_t)y1 - y2 - y2 + y3;
+    int64_t d;
+
+    dx0 = any_abs(dx0), dy0 = any_abs(dy0);
+    dx1 = any_abs(dx1), dy1 = any_abs(dy1);
+    d = max(dx0, dx1) + max(dy0, dy1);
+    return d - (d >> 2) <= tolerance;
+}
+
 /*
  * Split a curve segment into two pieces at the (parametric) midpoint.
  * Algorithm is from "The Beta2-split: A special case of the Beta-spline
@@ -618,4 +656,64 @@ gx_subdivide_curve(gx_path * ppath, int k, curve_segment * pc, segment_notes not
     return gx_subdivide_curve_rec(&iter, ppath, k, pc, notes, points);
 }
 
+typedef struct {
+    gx_path *ppath;
+    fixed tolerance;
+    segment_notes notes;
+    int count;
+    gs_fixed_point points[max_points];
+} adaptive_flatten_state;
+
+static int
+gx_subdivide_curve_adaptive_rec(adaptive_flatten_state *st, fixed x0, fixed y0,
+                                const curve_segment *pc, int k)
+{
+    int code;
+
+    if (k > 0 && !gx_curve_is_flat(x0, y0, pc->p1.x, pc->p1.y,
+                                   pc->p2.x, pc->p2.y, pc->pt.x, pc->pt.y,
+                                   st->tolerance)) {
+        curve_segment cseg1, cseg2;
+
+        split_curve_midpoint(x0, y0, pc, &cseg1, &cseg2);
+        code = gx_subdivide_curve_adaptive_rec(st, x0, y0, &cseg1, k - 1);
+        if (code < 0)
+            return code;
+        return gx_subdivide_curve_adaptive_rec(st, cseg1.pt.x, cseg1.pt.y,
+                                               &cseg2, k - 1);
+    }
+    if (st->count == max_points) {
+        code = generate_segments(st->ppath, st->points, st->count, st->notes);
+        if (code < 0)
+            return code;
+        st->notes |= sn_not_first;
+        st->count = 0;
+    }
+    st->points[st->count++] = pc->pt;
+    return 0;
+}
+
+/*
+ * Flatten a segment of the path adaptively (see gx_curve_flat_tolerance).
+ * k is the greatest depth to subdivide to, as for gx_subdivide_curve.
+ * Midpoint subdivision can't overflow, so there's no range restriction.
+ */
+int
+gx_subdivide_curve_adaptive(gx_path * ppath, int k, curve_segment * pc,
+                            segment_notes notes, fixed tolerance)
+{
+    adaptive_flatten_state st;
+    int code;
+
+    st.ppath = ppath;
+    st.tolerance = tolerance;
+    st.notes = notes;
+    st.count = 0;
+    code = gx_subdivide_curve_adaptive_rec(&st, ppath->position.x,
+                                           ppath->position.y, pc, k);
+    if (code < 0)
+        return code;
+    return generate_segments(ppath, st.points, st.count, st.notes);
+}
+
 #undef max_points
@@ -38,6 +38,10 @@
 #include "gxfill.h"
 #include "gxdcolor.h"
 #include "assert_.h"
+#include "gsstate.h"
+#include "gpsync.h"
+#include "gxsync.h"
+#include "gslibctx.h"
 #include <stdlib.h>             /* for qsort */
 #include <limits.h>             /* For INT_MAX */
 
@@ -150,13 +154,207 @@ enum
     DIRN_DOWN = 1
 };
 
-/* Centre of a pixel routines */
+/* Sorting of the intersection rows.
+ *
+ * Each scanline's intersections must be sorted before filtering. Rows
+ * are nearly always short, so calling qsort (with a function call per
+ * comparison) is a poor fit. Instead we insertion sort short rows and
+ * partitions, and quicksort longer rows with the comparisons inlined.
+ * The record orderings are total, so the results are exactly those of
+ * the comparison functions we used to pass to qsort.
+ */
+#define ROW_SORT_INSERTION_LIMIT 16
+/* Enough for 2 entries for each of 32 levels of partitioning; we always
+ * stack the larger partition, so we never need more. */
+#define ROW_SORT_STACK_SIZE 64
 
-static int intcmp(const void *a, const void *b)
+/* Rows of single ints (sorted on value). */
+static void
+sort_row_int(int * gs_restrict row, int len)
 {
-    return *((int*)a) - *((int *)b);
+    int stack[ROW_SORT_STACK_SIZE];
+    int sp = 0;
+    int lo = 0, hi = len-1;
+
+    for (;;) {
+        int i, j, p, t;
+
+        if (hi - lo < ROW_SORT_INSERTION_LIMIT) {
+            for (i = lo+1; i <= hi; i++) {
+                p = row[i];
+                for (j = i; j > lo && row[j-1] > p; j--)
+                    row[j] = row[j-1];
+                row[j] = p;
+            }
+            if (sp == 0)
+                return;
+            hi = stack[--sp];
+            lo = stack[--sp];
+            continue;
+        }
+
+        /* Median of three to the middle, then Hoare partition. */
+        i = lo + ((hi-lo)>>1);
+        if (row[i] < row[lo])
+            t = row[i], row[i] = row[lo], row[lo] = t;
+        if (row[hi] < row[i]) {
+            t = row[i], row[i] = row[hi], row[hi] = t;
+            if (row[i] < row[lo])
+                t = row[i], row[i] = row[lo], row[lo] = t;
+        }
+        p = row[i];
+        i = lo-1;
+        j = hi+1;
+        for (;;) {
+            do i++; while (row[i] < p);
+            do j--; while (row[j] > p);
+            if (i >= j)
+                break;
+            t = row[i], row[i] = row[j], row[j] = t;
+        }
+        /* Stack the larger half, loop on the smaller. */
+        if (j - lo > hi - j) {
+            stack[sp++] = lo;
+            stack[sp++] = j;
+            lo = j+1;
+        } else {
+            stack[sp++] = j+1;
+            stack[sp++] = hi;
+            hi = j;
+        }
+    }
 }
 
+/* Rows of int pairs (sorted on [0], then [1]). */
+#define PAIR_LT(a, b) ((a)[0] < (b)[0] || ((a)[0] == (b)[0] && (a)[1] < (b)[1]))
+#define PAIR_SWAP(a, b) \
+    do { int t_ = (a)[0]; (a)[0] = (b)[0]; (b)[0] = t_;\
+              t_ = (a)[1]; (a)[1] = (b)[1]; (b)[1] = t_; } while (0)
+
+static void
+sort_row_pair(int * gs_restrict row, int len)
+{
+    int stack[ROW_SORT_STACK_SIZE];
+    int sp = 0;
+    int lo = 0, hi = len-1;
+
+    for (;;) {
+        int i, j, p[2];
+
+        if (hi - lo < ROW_SORT_INSERTION_LIMIT) {
+            for (i = lo+1; i <= hi; i++) {
+                p[0] = row[2*i];
+                p[1] = row[2*i+1];
+                for (j = i; j > lo && PAIR_LT(p, &row[2*(j-1)]); j--) {
+                    row[2*j]   = row[2*j-2];
+                    row[2*j+1] = row[2*j-1];
+                }
+                row[2*j]   = p[0];
+                row[2*j+1] = p[1];
+            }
+            if (sp == 0)
+                return;
+            hi = stack[--sp];
+            lo = stack[--sp];
+            continue;
+        }
+
+        i = lo + ((hi-lo)>>1);
+        if (PAIR_LT(&row[2*i], &row[2*lo]))
+            PAIR_SWAP(&row[2*i], &row[2*lo]);
+        if (PAIR_LT(&row[2*hi], &row[2*i])) {
+            PAIR_SWAP(&row[2*i], &row[2*hi]);
+            if (PAIR_LT(&row[2*i], &row[2*lo]))
+                PAIR_SWAP(&row[2*i], &row[2*lo]);
+        }
+        p[0] = row[2*i];
+        p[1] = row[2*i+1];
+        i = lo-1;
+        j = hi+1;
+        for (;;) {
+            do i++; while (PAIR_LT(&row[2*i], p));
+            do j--; while (PAIR_LT(p, &row[2*j]));
+            if (i >= j)
+                break;
+            PAIR_SWAP(&row[2*i], &row[2*j]);
+        }
+        if (j - lo > hi - j) {
+            stack[sp++] = lo;
+            stack[sp++] = j;
+            lo = j+1;
+        } else {
+            stack[sp++] = j+1;
+            stack[sp++] = hi;
+            hi = j;
+        }
+    }
+}
+
+/* Rows of int quads (sorted on [0], then [2], then [1], then [3]). */
+#define QUAD_LT(a, b) \
+    ((a)[0] != (b)[0] ? (a)[0] < (b)[0] :\
+     (a)[2] != (b)[2] ? (a)[2] < (b)[2] :\
+     (a)[1] != (b)[1] ? (a)[1] < (b)[1] :\
+                        (a)[3] < (b)[3])
+#define QUAD_COPY(a, b) \
+    ((a)[0] = (b)[0], (a)[1] = (b)[1], (a)[2] = (b)[2], (a)[3] = (b)[3])
+
+static void
+sort_row_quad(int * gs_restrict row, int len)
+{
+    int stack[ROW_SORT_STACK_SIZE];
+    int sp = 0;
+    int lo = 0, hi = len-1;
+
+    for (;;) {
+        int i, j, p[4], t[4];
+
+        if (hi - lo < ROW_SORT_INSERTION_LIMIT) {
+            for (i = lo+1; i <= hi; i++) {
+                QUAD_COPY(p, &row[4*i]);
+                for (j = i; j > lo && QUAD_LT(p, &row[4*(j-1)]); j--)
+                    QUAD_COPY(&row[4*j], &row[4*(j-1)]);
+                QUAD_COPY(&row[4*j], p);
+            }
+            if (sp == 0)
+                return;
+            hi = stack[--sp];
+            lo = stack[--sp];
+            continue;
+        }
+
+        i = lo + ((hi-lo)>>1);
+        if (QUAD_LT(&row[4*i], &row[4*lo]))
+            QUAD_COPY(t, &row[4*i]), QUAD_COPY(&row[4*i], &row[4*lo]), QUAD_COPY(&row[4*lo], t);
+        if (QUAD_LT(&row[4*hi], &row[4*i])) {
+            QUAD_COPY(t, &row[4*i]), QUAD_COPY(&row[4*i], &row[4*hi]), QUAD_COPY(&row[4*hi], t);
+            if (QUAD_LT(&row[4*i], &row[4*lo]))
+                QUAD_COPY(t, &row[4*i]), QUAD_COPY(&row[4*i], &row[4*lo]), QUAD_COPY(&row[4*lo], t);
+        }
+        QUAD_COPY(p, &row[4*i]);
+        i = lo-1;
+        j = hi+1;
+        for (;;) {
+            do i++; while (QUAD_LT(&row[4*i], p));
+            do j--; while (QUAD_LT(p, &row[4*j]));
+            if (i >= j)
+                break;
+            QUAD_COPY(t, &row[4*i]), QUAD_COPY(&row[4*i], &row[4*j]), QUAD_COPY(&row[4*j], t);
+        }
+        if (j - lo > hi - j) {
+            stack[sp++] = lo;
+            stack[sp++] = j;
+            lo = j+1;
+        } else {
+            stack[sp++] = j+1;
+            stack[sp++] = hi;
+            hi = j;
+        }
+    }
+}
+
+/* Centre of a pixel routines */
+
 #if defined(DEBUG_SCAN_CONVERTER)
 int debugging_scan_converter = 1;
 
@@ -446,7 +644,16 @@ static void mark_line(fixed sx, fixed sy, fixed ex, fixed ey, int base_y, int he
     }
 }
 
-static void mark_curve(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int depth)
+/* When flattening adaptively (flat >= 0), a piece of a curve that is
+ * already within flat of its chord is marked as a line, rather than being
+ * subdivided all the way down. */
+static inline int
+curve_is_flat(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed flat)
+{
+    return flat >= 0 && gx_curve_is_flat(sx, sy, c1x, c1y, c2x, c2y, ex, ey, flat);
+}
+
+static void mark_curve(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int depth, fixed flat)
 {
     fixed ax = (sx + c1x)>>1;
     fixed ay = (sy + c1y)>>1;
@@ -462,16 +669,16 @@ static void mark_curve(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixe
     fixed gy = (dy + fy)>>1;
 
     assert(depth >= 0);
-    if (depth == 0)
+    if (depth == 0 || curve_is_flat(sx, sy, c1x, c1y, c2x, c2y, ex, ey, flat))
         mark_line(sx, sy, ex, ey, base_y, height, table, index);
     else {
         depth--;
-        mark_curve(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, depth);
-        mark_curve(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, depth);
+        mark_curve(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, depth, flat);
+        mark_curve(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, depth, flat);
     }
 }
 
-static void mark_curve_big(fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, fixed base_y, fixed height, int *table, int *index, int depth)
+static void mark_curve_big(fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, fixed base_y, fixed height, int *table, int *index, int depth, fixed flat)
 {
     fixed64 ax = (sx + c1x)>>1;
     fixed64 ay = (sy + c1y)>>1;
@@ -487,23 +694,23 @@ static void mark_curve_big(fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fix
     fixed64 gy = (dy + fy)>>1;
 
     assert(depth >= 0);
-    if (depth == 0)
+    if (depth == 0 || curve_is_flat((fixed)sx, (fixed)sy, (fixed)c1x, (fixed)c1y, (fixed)c2x, (fixed)c2y, (fixed)ex, (fixed)ey, flat))
         mark_line((fixed)sx, (fixed)sy, (fixed)ex, (fixed)ey, base_y, height, table, index);
     else {
         depth--;
-        mark_curve_big(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, depth);
-        mark_curve_big(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, depth);
+        mark_curve_big(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, depth, flat);
+        mark_curve_big(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, depth, flat);
     }
 }
 
-static void mark_curve_top(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int depth)
+static void mark_curve_top(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int depth, fixed flat)
 {
     fixed test = (sx^(sx<<1))|(sy^(sy<<1))|(c1x^(c1x<<1))|(c1y^(c1y<<1))|(c2x^(c2x<<1))|(c2y^(c2y<<1))|(ex^(ex<<1))|(ey^(ey<<1));
 
     if (test < 0)
-        mark_curve_big(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, depth);
+        mark_curve_big(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, depth, flat);
     else
-        mark_curve(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, depth);
+        mark_curve(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, depth, flat);
 }
 
 static int make_bbox(gx_path       * path,
@@ -871,6 +1078,7 @@ int gx_scan_convert(gx_device     * gs_restrict pdev,
     int            i;
     int            code;
     int            zero;
+    bool           adaptive = gs_getadaptiveflattening(pdev->memory);
 
     edgebuffer->index = NULL;
     edgebuffer->table = NULL;
@@ -923,8 +1131,9 @@ int gx_scan_convert(gx_device     * gs_restrict pdev,
                 case s_curve: {
                     const curve_segment *const pcur = (const curve_segment *)pseg;
                     int k = gx_curve_log2_samples(sx, sy, pcur, fixed_flat);
+                    fixed flat = (adaptive ? gx_curve_flat_tolerance(sx, sy, pcur, fixed_flat) : -1);
 
-                    mark_curve_top(sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, ibox.p.y, scanlines, table, index, k);
+                    mark_curve_top(sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, ibox.p.y, scanlines, table, index, k, flat);
                     break;
                 }
                 case s_gap:
@@ -964,20 +1173,7 @@ int gx_scan_convert(gx_device     * gs_restrict pdev,
         int *row = &table[index[i]];
         int  rowlen = *row++;
 
-        /* Bubblesort short runs, qsort longer ones. */
-        /* FIXME: Check "6" below */
-        if (rowlen <= 6) {
-            int j, k;
-            for (j = 0; j < rowlen-1; j++) {
-                int t = row[j];
-                for (k = j+1; k < rowlen; k++) {
-                    int s = row[k];
-                    if (t > s)
-                         row[k] = t, t = row[j] = s;
-                }
-            }
-        } else
-            qsort(row, rowlen, sizeof(int), intcmp);
+        sort_row_int(row, rowlen);
     }
 
     return 0;
@@ -1084,16 +1280,6 @@ gx_fill_edgebuffer(gx_device       * gs_restrict pdev,
 
 /* Any part of a pixel routines */
 
-static int edgecmp(const void *a, const void *b)
-{
-    int left  = ((int*)a)[0];
-    int right = ((int*)b)[0];
-    left -= right;
-    if (left)
-        return left;
-    return ((int*)a)[1] - ((int*)b)[1];
-}
-
 #ifdef DEBUG_SCAN_CONVERTER
 static void
 gx_edgebuffer_print_app(gx_edgebuffer * edgebuffer)
@@ -1976,7 +2162,7 @@ end:
     }
 }
 
-static void mark_curve_app(cursor *cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth)
+static void mark_curve_app(cursor *cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth, fixed flat)
 {
         int ax = (sx + c1x)>>1;
         int ay = (sy + c1y)>>1;
@@ -1992,16 +2178,16 @@ static void mark_curve_app(cursor *cr, fixed sx, fixed sy, fixed c1x, fixed c1y,
         int gy = (dy + fy)>>1;
 
         assert(depth >= 0);
-        if (depth == 0)
+        if (depth == 0 || curve_is_flat(sx, sy, c1x, c1y, c2x, c2y, ex, ey, flat))
             mark_line_app(cr, sx, sy, ex, ey);
         else {
             depth--;
-            mark_curve_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth);
-            mark_curve_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth);
+            mark_curve_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth, flat);
+            mark_curve_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth, flat);
         }
 }
 
-static void mark_curve_big_app(cursor *cr, fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, int depth)
+static void mark_curve_big_app(cursor *cr, fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, int depth, fixed flat)
 {
     fixed64 ax = (sx + c1x)>>1;
     fixed64 ay = (sy + c1y)>>1;
@@ -2017,23 +2203,23 @@ static void mark_curve_big_app(cursor *cr, fixed64 sx, fixed64 sy, fixed64 c1x,
     fixed64 gy = (dy + fy)>>1;
 
     assert(depth >= 0);
-    if (depth == 0)
+    if (depth == 0 || curve_is_flat((fixed)sx, (fixed)sy, (fixed)c1x, (fixed)c1y, (fixed)c2x, (fixed)c2y, (fixed)ex, (fixed)ey, flat))
         mark_line_app(cr, (fixed)sx, (fixed)sy, (fixed)ex, (fixed)ey);
     else {
         depth--;
-        mark_curve_big_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth);
-        mark_curve_big_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth);
+        mark_curve_big_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth, flat);
+        mark_curve_big_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth, flat);
     }
 }
 
-static void mark_curve_top_app(cursor *cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth)
+static void mark_curve_top_app(cursor *cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth, fixed flat)
 {
     fixed test = (sx^(sx<<1))|(sy^(sy<<1))|(c1x^(c1x<<1))|(c1y^(c1y<<1))|(c2x^(c2x<<1))|(c2y^(c2y<<1))|(ex^(ex<<1))|(ey^(ey<<1));
 
     if (test < 0)
-        mark_curve_big_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth);
+        mark_curve_big_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth, flat);
     else
-        mark_curve_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth);
+        mark_curve_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth, flat);
 }
 
 static int make_table_app(gx_device     * pdev,
@@ -2072,6 +2258,7 @@ int gx_scan_convert_app(gx_device     * gs_restrict pdev,
     cursor         cr;
     int            code;
     int            zero;
+    bool           adaptive = gs_getadaptiveflattening(pdev->memory);
 
     edgebuffer->index = NULL;
     edgebuffer->table = NULL;
@@ -2140,8 +2327,9 @@ int gx_scan_convert_app(gx_device     * gs_restrict pdev,
                 case s_curve: {
                     const curve_segment *const pcur = (const curve_segment *)pseg;
                     int k = gx_curve_log2_samples(sx, sy, pcur, fixed_flat);
+                    fixed flat = (adaptive ? gx_curve_flat_tolerance(sx, sy, pcur, fixed_flat) : -1);
 
-                    mark_curve_top_app(&cr, sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, k);
+                    mark_curve_top_app(&cr, sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, k, flat);
                     break;
                 }
                 case s_gap:
@@ -2180,30 +2368,7 @@ int gx_scan_convert_app(gx_device     * gs_restrict pdev,
         int *row = &table[index[i]];
         int  rowlen = *row++;
 
-        /* Bubblesort short runs, qsort longer ones. */
-        /* FIXME: Verify the figure 6 below */
-        if (rowlen <= 6) {
-            int j, k;
-            for (j = 0; j < rowlen-1; j++) {
-                int * gs_restrict t = &row[j<<1];
-                for (k = j+1; k < rowlen; k++) {
-                    int * gs_restrict s = &row[k<<1];
-                    int tmp;
-                    if (t[0] < s[0])
-                        continue;
-                    if (t[0] > s[0])
-                        goto swap01;
-                    if (t[1] <= s[1])
-                        continue;
-                    if (0) {
-swap01:
-                        tmp = t[0], t[0] = s[0], s[0] = tmp;
-                    }
-                    tmp = t[1], t[1] = s[1], s[1] = tmp;
-                }
-            }
-        } else
-            qsort(row, rowlen, 2*sizeof(int), edgecmp);
+        sort_row_pair(row, rowlen);
     }
 
     return 0;
@@ -2331,15 +2496,6 @@ gx_fill_edgebuffer_app(gx_device       * gs_restrict pdev,
 
 /* Centre of a pixel trapezoid routines */
 
-static int intcmp_tr(const void *a, const void *b)
-{
-    int left  = ((int*)a)[0];
-    int right = ((int*)b)[0];
-    if (left != right)
-        return left - right;
-    return ((int*)a)[1] - ((int*)b)[1];
-}
-
 #ifdef DEBUG_SCAN_CONVERTER
 static void
 gx_edgebuffer_print_tr(gx_edgebuffer * edgebuffer)
@@ -2502,7 +2658,7 @@ static void mark_line_tr(fixed sx, fixed sy, fixed ex, fixed ey, int base_y, int
     }
 }
 
-static void mark_curve_tr(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int *id, int depth)
+static void mark_curve_tr(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int *id, int depth, fixed flat)
 {
     fixed ax = (sx + c1x)>>1;
     fixed ay = (sy + c1y)>>1;
@@ -2518,17 +2674,17 @@ static void mark_curve_tr(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, f
     fixed gy = (dy + fy)>>1;
 
     assert(depth >= 0);
-    if (depth == 0) {
+    if (depth == 0 || curve_is_flat(sx, sy, c1x, c1y, c2x, c2y, ex, ey, flat)) {
         *id += 1;
         mark_line_tr(sx, sy, ex, ey, base_y, height, table, index, *id);
     } else {
         depth--;
-        mark_curve_tr(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, id, depth);
-        mark_curve_tr(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, id, depth);
+        mark_curve_tr(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, id, depth, flat);
+        mark_curve_tr(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, id, depth, flat);
     }
 }
 
-static void mark_curve_big_tr(fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, fixed base_y, fixed height, int *table, int *index, int *id, int depth)
+static void mark_curve_big_tr(fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, fixed base_y, fixed height, int *table, int *index, int *id, int depth, fixed flat)
 {
     fixed64 ax = (sx + c1x)>>1;
     fixed64 ay = (sy + c1y)>>1;
@@ -2544,24 +2700,24 @@ static void mark_curve_big_tr(fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y,
     fixed64 gy = (dy + fy)>>1;
 
     assert(depth >= 0);
-    if (depth == 0) {
+    if (depth == 0 || curve_is_flat((fixed)sx, (fixed)sy, (fixed)c1x, (fixed)c1y, (fixed)c2x, (fixed)c2y, (fixed)ex, (fixed)ey, flat)) {
         *id += 1;
         mark_line_tr((fixed)sx, (fixed)sy, (fixed)ex, (fixed)ey, base_y, height, table, index, *id);
     } else {
         depth--;
-        mark_curve_big_tr(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, id, depth);
-        mark_curve_big_tr(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, id, depth);
+        mark_curve_big_tr(sx, sy, ax, ay, dx, dy, gx, gy, base_y, height, table, index, id, depth, flat);
+        mark_curve_big_tr(gx, gy, fx, fy, cx, cy, ex, ey, base_y, height, table, index, id, depth, flat);
     }
 }
 
-static void mark_curve_top_tr(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int *id, int depth)
+static void mark_curve_top_tr(fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, fixed base_y, fixed height, int *table, int *index, int *id, int depth, fixed flat)
 {
     fixed test = (sx^(sx<<1))|(sy^(sy<<1))|(c1x^(c1x<<1))|(c1y^(c1y<<1))|(c2x^(c2x<<1))|(c2y^(c2y<<1))|(ex^(ex<<1))|(ey^(ey<<1));
 
     if (test < 0)
-        mark_curve_big_tr(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, id, depth);
+        mark_curve_big_tr(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, id, depth, flat);
     else
-        mark_curve_tr(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, id, depth);
+        mark_curve_tr(sx, sy, c1x, c1y, c2x, c2y, ex, ey, base_y, height, table, index, id, depth, flat);
 }
 
 static int make_table_tr(gx_device     * pdev,
@@ -2600,6 +2756,7 @@ int gx_scan_convert_tr(gx_device     * gs_restrict pdev,
     int            code;
     int            id = 0;
     int            zero;
+    bool           adaptive = gs_getadaptiveflattening(pdev->memory);
 
     edgebuffer->index = NULL;
     edgebuffer->table = NULL;
@@ -2652,8 +2809,9 @@ int gx_scan_convert_tr(gx_device     * gs_restrict pdev,
                 case s_curve: {
                     const curve_segment *const pcur = (const curve_segment *)pseg;
                     int k = gx_curve_log2_samples(sx, sy, pcur, fixed_flat);
+                    fixed flat = (adaptive ? gx_curve_flat_tolerance(sx, sy, pcur, fixed_flat) : -1);
 
-                    mark_curve_top_tr(sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, ibox.p.y, scanlines, table, index, &id, k);
+                    mark_curve_top_tr(sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, ibox.p.y, scanlines, table, index, &id, k, flat);
                     break;
                 }
                 case s_gap:
@@ -2704,27 +2862,7 @@ int gx_scan_convert_tr(gx_device     * gs_restrict pdev,
         int *row = &table[index[i]];
         int  rowlen = *row++;
 
-        /* Bubblesort short runs, qsort longer ones. */
-        /* FIXME: Verify the figure 6 below */
-        if (rowlen <= 6) {
-            int j, k;
-            for (j = 0; j < rowlen-1; j++) {
-                int * gs_restrict t = &row[j<<1];
-                for (k = j+1; k < rowlen; k++) {
-                    int * gs_restrict s = &row[k<<1];
-                    int tmp;
-                    if (t[0] < s[0])
-                        continue;
-                    if (t[0] == s[0]) {
-                        if (t[1] <= s[1])
-                            continue;
-                    } else
-                        tmp = t[0], t[0] = s[0], s[0] = tmp;
-                    tmp = t[1], t[1] = s[1], s[1] = tmp;
-                }
-            }
-        } else
-            qsort(row, rowlen, 2*sizeof(int), intcmp_tr);
+        sort_row_pair(row, rowlen);
     }
 
     return 0;
@@ -2953,21 +3091,6 @@ rowdifferent:{}
 
 /* Any part of a pixel trapezoid routines */
 
-static int edgecmp_tr(const void *a, const void *b)
-{
-    int left  = ((int*)a)[0];
-    int right = ((int*)b)[0];
-    if (left != right)
-        return left - right;
-    left = ((int*)a)[2] - ((int*)b)[2];
-    if (left != 0)
-        return left;
-    left = ((int*)a)[1] - ((int*)b)[1];
-    if (left != 0)
-        return left;
-    return ((int*)a)[3] - ((int*)b)[3];
-}
-
 #ifdef DEBUG_SCAN_CONVERTER
 static void
 gx_edgebuffer_print_filtered_tr_app(gx_edgebuffer * edgebuffer)
@@ -3942,7 +4065,7 @@ end:
     }
 }
 
-static void mark_curve_tr_app(cursor_tr * gs_restrict cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth, int * gs_restrict id)
+static void mark_curve_tr_app(cursor_tr * gs_restrict cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth, fixed flat, int * gs_restrict id)
 {
         int ax = (sx + c1x)>>1;
         int ay = (sy + c1y)>>1;
@@ -3958,17 +4081,17 @@ static void mark_curve_tr_app(cursor_tr * gs_restrict cr, fixed sx, fixed sy, fi
         int gy = (dy + fy)>>1;
 
         assert(depth >= 0);
-        if (depth == 0) {
+        if (depth == 0 || curve_is_flat(sx, sy, c1x, c1y, c2x, c2y, ex, ey, flat)) {
             *id += 1;
             mark_line_tr_app(cr, sx, sy, ex, ey, *id);
         } else {
             depth--;
-            mark_curve_tr_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth, id);
-            mark_curve_tr_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth, id);
+            mark_curve_tr_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth, flat, id);
+            mark_curve_tr_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth, flat, id);
         }
 }
 
-static void mark_curve_big_tr_app(cursor_tr * gs_restrict cr, fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, int depth, int * gs_restrict id)
+static void mark_curve_big_tr_app(cursor_tr * gs_restrict cr, fixed64 sx, fixed64 sy, fixed64 c1x, fixed64 c1y, fixed64 c2x, fixed64 c2y, fixed64 ex, fixed64 ey, int depth, fixed flat, int * gs_restrict id)
 {
     fixed64 ax = (sx + c1x)>>1;
     fixed64 ay = (sy + c1y)>>1;
@@ -3984,24 +4107,24 @@ static void mark_curve_big_tr_app(cursor_tr * gs_restrict cr, fixed64 sx, fixed6
     fixed64 gy = (dy + fy)>>1;
 
     assert(depth >= 0);
-    if (depth == 0) {
+    if (depth == 0 || curve_is_flat((fixed)sx, (fixed)sy, (fixed)c1x, (fixed)c1y, (fixed)c2x, (fixed)c2y, (fixed)ex, (fixed)ey, flat)) {
         *id += 1;
         mark_line_tr_app(cr, (fixed)sx, (fixed)sy, (fixed)ex, (fixed)ey, *id);
     } else {
         depth--;
-        mark_curve_big_tr_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth, id);
-        mark_curve_big_tr_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth, id);
+        mark_curve_big_tr_app(cr, sx, sy, ax, ay, dx, dy, gx, gy, depth, flat, id);
+        mark_curve_big_tr_app(cr, gx, gy, fx, fy, cx, cy, ex, ey, depth, flat, id);
     }
 }
 
-static void mark_curve_top_tr_app(cursor_tr * gs_restrict cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth, int * gs_restrict id)
+static void mark_curve_top_tr_app(cursor_tr * gs_restrict cr, fixed sx, fixed sy, fixed c1x, fixed c1y, fixed c2x, fixed c2y, fixed ex, fixed ey, int depth, fixed flat, int * gs_restrict id)
 {
     fixed test = (sx^(sx<<1))|(sy^(sy<<1))|(c1x^(c1x<<1))|(c1y^(c1y<<1))|(c2x^(c2x<<1))|(c2y^(c2y<<1))|(ex^(ex<<1))|(ey^(ey<<1));
 
     if (test < 0)
-        mark_curve_big_tr_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth, id);
+        mark_curve_big_tr_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth, flat, id);
     else
-        mark_curve_tr_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth, id);
+        mark_curve_tr_app(cr, sx, sy, c1x, c1y, c2x, c2y, ex, ey, depth, flat, id);
 }
 
 static int make_table_tr_app(gx_device     * pdev,
@@ -4045,6 +4168,7 @@ int gx_scan_convert_tr_app(gx_device     * gs_restrict pdev,
     int            code;
     int            id = 0;
     int            zero;
+    bool           adaptive = gs_getadaptiveflattening(pdev->memory);
 
     edgebuffer->index = NULL;
     edgebuffer->table = NULL;
@@ -4114,8 +4238,9 @@ int gx_scan_convert_tr_app(gx_device     * gs_restrict pdev,
                 case s_curve: {
                     const curve_segment *const pcur = (const curve_segment *)pseg;
                     int k = gx_curve_log2_samples(sx, sy, pcur, fixed_flat);
+                    fixed flat = (adaptive ? gx_curve_flat_tolerance(sx, sy, pcur, fixed_flat) : -1);
 
-                    mark_curve_top_tr_app(&cr, sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, k, &id);
+                    mark_curve_top_tr_app(&cr, sx, sy, pcur->p1.x, pcur->p1.y, pcur->p2.x, pcur->p2.y, ex, ey, k, flat, &id);
                     break;
                 }
                 case s_gap:
@@ -4154,42 +4279,7 @@ int gx_scan_convert_tr_app(gx_device     * gs_restrict pdev,
         int *row = &table[index[i]];
         int  rowlen = *row++;
 
-        /* Bubblesort short runs, qsort longer ones. */
-        /* Figure of '6' comes from testing */
-        if (rowlen <= 6) {
-            int j, k;
-            for (j = 0; j < rowlen-1; j++) {
-                int * gs_restrict t = &row[j<<2];
-                for (k = j+1; k < rowlen; k++) {
-                    int * gs_restrict s = &row[k<<2];
-                    int tmp;
-                    if (t[0] < s[0])
-                        continue;
-                    if (t[0] > s[0])
-                        goto swap0213;
-                    if (t[2] < s[2])
-                        continue;
-                    if (t[2] > s[2])
-                        goto swap213;
-                    if (t[1] < s[1])
-                        continue;
-                    if (t[1] > s[1])
-                        goto swap13;
-                    if (t[3] <= s[3])
-                        continue;
-                    if (0) {
-swap0213:
-                        tmp = t[0], t[0] = s[0], s[0] = tmp;
-swap213:
-                        tmp = t[2], t[2] = s[2], s[2] = tmp;
-swap13:
-                        tmp = t[1], t[1] = s[1], s[1] = tmp;
-                    }
-                    tmp = t[3], t[3] = s[3], s[3] = tmp;
-                }
-            }
-        } else
-            qsort(row, rowlen, 4*sizeof(int), edgecmp_tr);
+        sort_row_quad(row, rowlen);
     }
 
     return 0;
@@ -4565,15 +4655,23 @@ gx_scan_converter_t gx_scan_converter_tr_app =
     gx_fill_edgebuffer_tr_app
 };
 
-int
-gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
-                               gx_device       *dev,
-                               gx_path         *ppath,
-                         const gs_fixed_rect   *ibox,
-                               fixed            flat,
-                               int              rule,
-                         const gx_device_color *pdevc,
-                               int              lop)
+/* Scan convert and filter a path a band at a time, keeping the size of
+ * each edgebuffer reasonable, and pass the bands to band_proc in turn.
+ * band_proc returns 0 to continue, 1 to stop early, or an error. */
+typedef int (scanc_band_proc_t)(gx_device           *dev,
+                                gx_edgebuffer       *eb,
+                          const gs_fixed_rect       *band,
+                                void                *arg);
+
+static int
+scan_convert_bands(const gx_scan_converter_t *sc,
+                         gx_device           *dev,
+                         gx_path             *ppath,
+                   const gs_fixed_rect       *ibox,
+                         fixed                flat,
+                         int                  rule,
+                         scanc_band_proc_t   *band_proc,
+                         void                *arg)
 {
     int code;
     gx_edgebuffer eb;
@@ -4619,14 +4717,474 @@ gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
                               &eb,
                               rule);
         if (code >= 0)
-            code = sc->fill(dev,
-                            pdevc,
-                            &eb,
-                            lop);
+            code = band_proc(dev,
+                             &eb,
+                             &ibox2,
+                             arg);
         gx_edgebuffer_fin(dev,&eb);
         ibox2.p.y += height;
     }
-    while (ibox2.p.y < ibox->q.y);
+    while (code != 1 && ibox2.p.y < ibox->q.y);
 
     return code;
 }
+
+typedef struct {
+    const gx_scan_converter_t *sc;
+    const gx_device_color     *pdevc;
+    int                        lop;
+} scanc_fill_args;
+
+static int
+fill_band(gx_device *dev, gx_edgebuffer *eb, const gs_fixed_rect *band, void *arg)
+{
+    scanc_fill_args *fa = (scanc_fill_args *)arg;
+    int code = fa->sc->fill(dev, fa->pdevc, eb, fa->lop);
+
+    return code < 0 ? code : 0;
+}
+
+/* Filling very large paths with several threads.
+ *
+ * Only the final fill of an edgebuffer needs the device; scan converting
+ * and filtering one band of a path is independent of every other band.
+ * So, when gs_setfillthreads has asked for it, fills of paths with very
+ * many segments spanning many scanlines are split into horizontal tiles.
+ * All but the first tile are scan converted by worker threads while the
+ * calling thread does the first one, and the tiles are then filled, in
+ * order, by the calling thread.  Only the segments that reach into the
+ * scanlines being filled are counted, so that when banding a fill is only
+ * split in the bands that hold a large share of it.
+ *
+ * The worker threads are kept in a pool hung off the library context, and
+ * are only started once.  Tiles are queued for them; a tile that no worker
+ * has taken by the time the calling thread gets to it is done by the
+ * calling thread itself.
+ *
+ * A worker keeps at most FILL_TILE_MAX_BANDS bands of its tile in memory;
+ * if the tile needs more than that, the rest of it is done in the usual
+ * way by the calling thread once the stored bands have been filled.
+ */
+#define FILL_TILE_MIN_SEGMENTS 10000
+#define FILL_TILE_MIN_HEIGHT   32
+#define FILL_TILE_MAX_TILES    16
+#define FILL_TILE_MAX_BANDS    8
+
+typedef enum {
+    TILE_QUEUED,        /* waiting for a worker */
+    TILE_OWN,           /* taken back by the calling thread */
+    TILE_TAKEN,         /* being converted by a worker */
+    TILE_DONE           /* converted by a worker */
+} scanc_tile_state;
+
+typedef struct scanc_tile_s scanc_tile;
+struct scanc_tile_s {
+    const gx_scan_converter_t *sc;
+    gx_device                 *dev;
+    gx_path                   *ppath;
+    gs_fixed_rect              rect;
+    fixed                      flat;
+    int                        rule;
+    gx_edgebuffer              eb[FILL_TILE_MAX_BANDS];
+    int                        neb;
+    fixed                      done_y;  /* the stored bands end here */
+    int                        code;
+    scanc_tile_state           state;
+    gx_semaphore_t            *done;    /* signalled when a worker finishes */
+    scanc_tile                *next;    /* in the pool's queue */
+};
+
+typedef struct scanc_fill_pool_s scanc_fill_pool;
+
+/* gx_semaphore_signal only wakes a waiter when the count goes from 0 to 1,
+ * so each worker waits on a semaphore of its own. */
+typedef struct {
+    scanc_fill_pool           *pool;
+    gx_semaphore_t            *wake;    /* signalled when tiles are queued */
+    gp_thread_id               thread;
+} scanc_fill_worker;
+
+struct scanc_fill_pool_s {
+    gx_monitor_t              *lock;    /* for the queue and tile states */
+    scanc_tile                *queue;
+    bool                       quit;
+    int                        nthreads;
+    scanc_fill_worker          workers[FILL_TILE_MAX_TILES-1];
+};
+
+static int
+store_band(gx_device *dev, gx_edgebuffer *eb, const gs_fixed_rect *band, void *arg)
+{
+    scanc_tile *tile = (scanc_tile *)arg;
+
+    /* Take ownership of the edgebuffer's tables. */
+    tile->eb[tile->neb++] = *eb;
+    gx_edgebuffer_init(eb);
+    tile->done_y = band->q.y;
+
+    return tile->neb == FILL_TILE_MAX_BANDS;
+}
+
+static void
+scan_convert_tile(void *arg)
+{
+    scanc_tile *tile = (scanc_tile *)arg;
+
+    tile->code = scan_convert_bands(tile->sc,
+                                    tile->dev,
+                                    tile->ppath,
+                                    &tile->rect,
+                                    tile->flat,
+                                    tile->rule,
+                                    store_band,
+                                    tile);
+}
+
+static void
+fill_pool_worker(void *arg)
+{
+    scanc_fill_worker *worker = (scanc_fill_worker *)arg;
+    scanc_fill_pool *pool = worker->pool;
+    scanc_tile *tile;
+    gx_semaphore_t *done;
+
+    while (1) {
+        gx_semaphore_wait(worker->wake);
+        /* Take tiles until the queue is empty; it may already be, if
+         * other workers or the calling threads got to them first. */
+        while (1) {
+            gx_monitor_enter(pool->lock);
+            if (pool->quit) {
+                gx_monitor_leave(pool->lock);
+                return;
+            }
+            tile = pool->queue;
+            if (tile != NULL) {
+                pool->queue = tile->next;
+                tile->state = TILE_TAKEN;
+            }
+            gx_monitor_leave(pool->lock);
+            if (tile == NULL)
+                break;
+            scan_convert_tile(tile);
+            /* The tile may be gone as soon as its state says it is done. */
+            gx_monitor_enter(pool->lock);
+            done = tile->done;
+            tile->state = TILE_DONE;
+            gx_monitor_leave(pool->lock);
+            gx_semaphore_signal(done);
+        }
+    }
+}
+
+/* Wake the workers after tiles have been queued; called with the pool's
+ * lock held. */
+static void
+fill_pool_wake(scanc_fill_pool *pool)
+{
+    int i;
+
+    for (i = 0; i < pool->nthreads; i++)
+        gx_semaphore_signal(pool->workers[i].wake);
+}
+
+static void
+fill_pool_free(gs_memory_t *mem, void *p)
+{
+    scanc_fill_pool *pool = (scanc_fill_pool *)p;
+    int i;
+
+    gx_monitor_enter(pool->lock);
+    pool->quit = true;
+    fill_pool_wake(pool);
+    gx_monitor_leave(pool->lock);
+    for (i = 0; i < pool->nthreads; i++) {
+        gp_thread_finish(pool->workers[i].thread);
+        gx_semaphore_free(pool->workers[i].wake);
+    }
+    gx_monitor_free(pool->lock);
+    gs_free_object(mem, pool, "fill_pool_free");
+}
+
+/* Get the library's fill thread pool, creating it if need be, and start
+ * workers until it has 'threads' of them (if it can). */
+static scanc_fill_pool *
+fill_pool_get(const gs_memory_t *mem, int threads)
+{
+    gs_lib_ctx_core_t *core = mem->gs_lib_ctx->core;
+    scanc_fill_pool *pool;
+
+    if (threads > FILL_TILE_MAX_TILES-1)
+        threads = FILL_TILE_MAX_TILES-1;
+    gx_monitor_enter((gx_monitor_t *)core->monitor);
+    pool = (scanc_fill_pool *)core->fill_thread_pool;
+    if (pool == NULL) {
+        pool = (scanc_fill_pool *)gs_alloc_bytes_immovable(core->memory,
+                                                sizeof(scanc_fill_pool),
+                                                "fill_pool_get");
+        if (pool != NULL) {
+            memset(pool, 0, sizeof(*pool));
+            pool->lock = gx_monitor_alloc(core->memory);
+            if (pool->lock == NULL) {
+                gs_free_object(core->memory, pool, "fill_pool_get");
+                pool = NULL;
+            } else {
+                core->fill_thread_pool = pool;
+                core->free_fill_thread_pool = fill_pool_free;
+            }
+        }
+    }
+    while (pool != NULL && pool->nthreads < threads) {
+        scanc_fill_worker *worker = &pool->workers[pool->nthreads];
+
+        worker->pool = pool;
+        worker->wake = gx_semaphore_alloc(core->memory);
+        if (worker->wake == NULL)
+            break;
+        if (gp_thread_start(fill_pool_worker, worker, &worker->thread) < 0) {
+            gx_semaphore_free(worker->wake);
+            break;
+        }
+        gp_thread_label(worker->thread, "Fill tile");
+        gx_monitor_enter(pool->lock);
+        pool->nthreads++;
+        gx_monitor_leave(pool->lock);
+    }
+    gx_monitor_leave((gx_monitor_t *)core->monitor);
+
+    return pool;
+}
+
+/* Does the path have at least count segments that reach into the
+ * scanlines of ibox? */
+static bool
+path_has_segments(const gx_path *ppath, const gs_fixed_rect *ibox, int count)
+{
+    const segment *pseg;
+    fixed y = 0;
+
+    for (pseg = (const segment *)ppath->first_subpath; pseg != NULL; pseg = pseg->next) {
+        if (pseg->type != s_start) {
+            fixed ymin = min(y, pseg->pt.y);
+            fixed ymax = max(y, pseg->pt.y);
+
+            if (pseg->type == s_curve) {
+                const curve_segment *pc = (const curve_segment *)pseg;
+
+                ymin = min(ymin, min(pc->p1.y, pc->p2.y));
+                ymax = max(ymax, max(pc->p1.y, pc->p2.y));
+            }
+            if (ymax >= ibox->p.y && ymin <= ibox->q.y && --count == 0)
+                return true;
+        }
+        y = pseg->pt.y;
+    }
+    return false;
+}
+
+/* Work out the height (in scanlines) of the tiles to use for a fill, or
+ * return 0 if the fill isn't worth splitting up. */
+static int
+fill_tile_height(gx_device           *dev,
+                 gx_path             *ppath,
+           const gs_fixed_rect       *ibox,
+                 int                  threads)
+{
+    int mfb = dev->max_fill_band;
+    int scanlines = fixed2int_ceiling(ibox->q.y) - fixed2int(ibox->p.y);
+    int ntiles = scanlines / FILL_TILE_MIN_HEIGHT;
+    int height;
+
+    if (ntiles > threads + 1)
+        ntiles = threads + 1;
+    if (ntiles > FILL_TILE_MAX_TILES)
+        ntiles = FILL_TILE_MAX_TILES;
+    if (ntiles < 2 ||
+        dev->memory->thread_safe_memory == NULL ||
+        !path_has_segments(ppath, ibox, FILL_TILE_MIN_SEGMENTS))
+        return 0;
+    height = (scanlines + ntiles - 1) / ntiles;
+    if (mfb != 0)
+        height = (height + mfb - 1) & ~(mfb - 1);
+
+    return height;
+}
+
+static int
+scan_convert_and_fill_tiles(const gx_scan_converter_t *sc,
+                                  gx_device       *dev,
+                                  gx_path         *ppath,
+                            const gs_fixed_rect   *ibox,
+                                  fixed            flat,
+                                  int              rule,
+                                  scanc_fill_args *fa,
+                                  int              height)
+{
+    scanc_tile tiles[FILL_TILE_MAX_TILES];
+    scanc_fill_pool *pool;
+    scanc_tile **pqueue;
+    gx_semaphore_t *done = NULL;
+    gx_device tdev;
+    gs_fixed_rect bbox;
+    int mfb = dev->max_fill_band;
+    int y = fixed2int(ibox->p.y);
+    int ye = fixed2int_ceiling(ibox->q.y);
+    int ntiles, i, j;
+    int taken = 0, signals = 0;
+    int code;
+
+    /* gx_path_bbox may update the bbox cached in the path, so get that
+     * done now; from here on the workers only ever read the path. */
+    code = gx_path_bbox(ppath, &bbox);
+    if (code < 0)
+        return code;
+
+    /* The scan converters and filters only use the device for its
+     * allocator and max_fill_band, so the workers share a copy of the
+     * device that allocates from thread safe memory. */
+    tdev = *dev;
+    tdev.memory = dev->memory->thread_safe_memory;
+
+    /* Each tile owns whole scanlines, aligned to max_fill_band, so that
+     * no scanline is filled twice. */
+    if (mfb != 0)
+        y &= ~(mfb - 1);
+    for (ntiles = 0; ntiles < FILL_TILE_MAX_TILES && y < ye; ntiles++) {
+        scanc_tile *tile = &tiles[ntiles];
+
+        tile->sc     = sc;
+        tile->dev    = &tdev;
+        tile->ppath  = ppath;
+        tile->flat   = flat;
+        tile->rule   = rule;
+        tile->neb    = 0;
+        tile->code   = 0;
+        tile->state  = TILE_OWN;
+        tile->done   = NULL;
+        tile->next   = NULL;
+        tile->rect   = *ibox;
+        if (ntiles > 0)
+            tile->rect.p.y = int2fixed(y);
+        y += height;
+        if (y < ye && ntiles < FILL_TILE_MAX_TILES-1)
+            tile->rect.q.y = int2fixed(y) - 1;
+        else
+            y = ye;
+        tile->done_y = tile->rect.p.y;
+    }
+
+    /* Queue all but the first tile for the pool.  If there is no pool,
+     * every tile is converted in this thread when its turn comes. */
+    pool = fill_pool_get(dev->memory, ntiles - 1);
+    if (pool != NULL && pool->nthreads > 0)
+        done = gx_semaphore_alloc(dev->memory->thread_safe_memory);
+    if (done != NULL) {
+        gx_monitor_enter(pool->lock);
+        for (pqueue = &pool->queue; *pqueue != NULL; pqueue = &(*pqueue)->next)
+            ;
+        for (i = 1; i < ntiles; i++) {
+            tiles[i].state = TILE_QUEUED;
+            tiles[i].done = done;
+            *pqueue = &tiles[i];
+            pqueue = &tiles[i].next;
+        }
+        fill_pool_wake(pool);
+        gx_monitor_leave(pool->lock);
+    }
+
+    for (i = 0; i < ntiles; i++) {
+        scanc_tile *tile = &tiles[i];
+        bool own = true;
+
+        if (i > 0 && done != NULL) {
+            gx_monitor_enter(pool->lock);
+            if (tile->state == TILE_QUEUED) {
+                /* No worker has got to it yet, so take it back. */
+                for (pqueue = &pool->queue; *pqueue != tile; pqueue = &(*pqueue)->next)
+                    ;
+                *pqueue = tile->next;
+                tile->state = TILE_OWN;
+            } else {
+                own = false;
+                taken++;
+            }
+            gx_monitor_leave(pool->lock);
+        }
+        if (own)
+            scan_convert_tile(tile);
+        else {
+            /* Each signal is for one of our tiles that a worker finished,
+             * though not necessarily this one. */
+            while (1) {
+                bool finished;
+
+                gx_monitor_enter(pool->lock);
+                finished = tile->state == TILE_DONE;
+                gx_monitor_leave(pool->lock);
+                if (finished)
+                    break;
+                gx_semaphore_wait(done);
+                signals++;
+            }
+        }
+        for (j = 0; j < tile->neb; j++) {
+            if (code >= 0)
+                code = fill_band(dev, &tile->eb[j], NULL, fa);
+            gx_edgebuffer_fin(&tdev, &tile->eb[j]);
+        }
+        if (code < 0)
+            continue;
+        if (tile->code < 0 && tile->code != gs_error_VMerror)
+            code = tile->code;
+        else if (tile->done_y < tile->rect.q.y) {
+            /* The worker stopped early, or ran out of memory; do the
+             * rest of the tile here. */
+            gs_fixed_rect rest = tile->rect;
+
+            rest.p.y = tile->done_y;
+            code = scan_convert_bands(sc, dev, ppath, &rest, flat, rule,
+                                      fill_band, fa);
+        }
+    }
+
+    /* Every tile has been converted, but a worker may not have signalled
+     * yet; don't free the semaphore from under it. */
+    if (done != NULL) {
+        while (signals < taken) {
+            gx_semaphore_wait(done);
+            signals++;
+        }
+        gx_semaphore_free(done);
+    }
+
+    return code;
+}
+
+int
+gx_scan_convert_and_fill(const gx_scan_converter_t *sc,
+                               gx_device       *dev,
+                               gx_path         *ppath,
+                         const gs_fixed_rect   *ibox,
+                               fixed            flat,
+                               int              rule,
+                         const gx_device_color *pdevc,
+                               int              lop)
+{
+    scanc_fill_args fa;
+    int threads = gs_getfillthreads(dev->memory);
+
+    fa.sc = sc;
+    fa.pdevc = pdevc;
+    fa.lop = lop;
+
+    if (threads > 0) {
+        int height = fill_tile_height(dev, ppath, ibox, threads);
+
+        if (height > 0)
+            return scan_convert_and_fill_tiles(sc, dev, ppath, ibox, flat,
+                                               rule, &fa, height);
+    }
+
+    return scan_convert_bands(sc, dev, ppath, ibox, flat, rule,
+                              fill_band, &fa);
+}
@@ -37,6 +37,8 @@
 #include "gxpaint.h"
 #include "gsstate.h"            /* for gs_currentcpsimode */
 #include "gzacpath.h"
+#include "gxsync.h"
+#include "gslibctx.h"
 
 /* RJW: There appears to be a difference in the xps and postscript models
  * (at least in as far as Microsofts implementation of xps and Acrobats of
@@ -489,6 +491,361 @@ gx_join_path_and_reverse(gx_path * path, gx_path * rpath)
     return gx_path_close_subpath(path);
 }
 
+/*
+ * Cache the outlines of strokes that are built as a whole and filled in
+ * one go (e.g. with transparency).  Documents often stroke the same path
+ * over and over at different places on the page (table grids, repeated
+ * symbols, HPGL), and with banding the same stroke is also redone for
+ * every band it crosses.  So we remember the outline produced for a path
+ * and, when the same path is stroked again with the same parameters,
+ * move the remembered outline into place and fill that, instead of
+ * redoing the joins and caps and building the outline again.
+ *
+ * The key is the flattened, dash expanded path relative to its first
+ * point, together with everything from the graphics state that affects
+ * the outline.  The sub-pixel position of the first point is part of the
+ * key too (the miter check looks at absolute half pixels), so a cached
+ * outline is only ever moved by whole pixels, and the result is exactly
+ * what stroking the path would have produced.
+ *
+ * The cache is a small direct mapped table held by the library context,
+ * and so shared by all the threads using it.  An entry is marked busy
+ * while its outline is being filled; anyone else wanting it meanwhile
+ * just strokes the path.  A path only gets stored the second time it is
+ * seen, so pages without repeats pay for little more than hashing.
+ */
+#define STROKE_CACHE_LOG2_SLOTS 6
+#define STROKE_CACHE_SLOTS (1 << STROKE_CACHE_LOG2_SLOTS)
+#define STROKE_CACHE_MAX_SEGMENTS 400
+
+/* Everything other than the path that determines the outline. */
+typedef struct stroke_cache_params_s {
+    stroke_line_proc_t line_proc;
+    float ctm[4];
+    float half_width;
+    float miter_limit;
+    float miter_check;
+    double dot_length;                  /* in device space */
+    int start_cap, end_cap, dash_cap;
+    int join, curve_join;
+    int dot_portrait;
+    int reflected;
+    gs_fixed_point origin_frac;         /* sub-pixel position of the path */
+} stroke_cache_params;
+
+/* A path segment, relative to the first point of the path. */
+typedef struct stroke_cache_seg_s {
+    gs_fixed_point pt;
+    gs_fixed_point tangent;             /* only for s_dash */
+    ushort type;
+    ushort notes;
+    int closed;                         /* only for s_start */
+} stroke_cache_seg;
+
+typedef struct stroke_cache_key_s {
+    stroke_cache_params params;
+    gs_fixed_point origin;
+    uint hash;
+    int count;
+    int slot;
+    bool store;                         /* store the outline once built */
+} stroke_cache_key;
+
+typedef struct stroke_cache_entry_s {
+    uint hash;
+    int count;
+    stroke_cache_params params;
+    gs_fixed_point origin;              /* where the outline is now */
+    stroke_cache_seg *segs;             /* NULL until the path is seen twice */
+    gx_path *outline;
+    bool clears_sgr;                    /* stroking resets dev->sgr */
+    bool busy;
+} stroke_cache_entry;
+
+typedef struct gx_stroke_cache_s {
+    gs_memory_t *memory;
+    gx_monitor_t *lock;
+    stroke_cache_entry entries[STROKE_CACHE_SLOTS];
+} gx_stroke_cache;
+
+static void
+stroke_cache_clear_entry(gx_stroke_cache *cache, stroke_cache_entry *e)
+{
+    if (e->outline != NULL)
+        gx_path_free(e->outline, "stroke_cache_clear_entry");
+    gs_free_object(cache->memory, e->segs, "stroke_cache_clear_entry");
+    e->outline = NULL;
+    e->segs = NULL;
+}
+
+static void
+stroke_cache_free(gs_memory_t *mem, void *p)
+{
+    gx_stroke_cache *cache = (gx_stroke_cache *)p;
+    int i;
+
+    for (i = 0; i < STROKE_CACHE_SLOTS; i++)
+        stroke_cache_clear_entry(cache, &cache->entries[i]);
+    gx_monitor_free(cache->lock);
+    gs_free_object(mem, cache, "stroke_cache_free");
+}
+
+/* Get the library's stroke cache, creating it if need be. */
+static gx_stroke_cache *
+stroke_cache_get(const gs_memory_t *mem)
+{
+    gs_lib_ctx_core_t *core = mem->gs_lib_ctx->core;
+    gx_stroke_cache *cache;
+
+    gx_monitor_enter((gx_monitor_t *)core->monitor);
+    cache = (gx_stroke_cache *)core->stroke_cache;
+    if (cache == NULL) {
+        cache = (gx_stroke_cache *)gs_alloc_bytes_immovable(core->memory,
+                                                sizeof(gx_stroke_cache),
+                                                "stroke_cache_get");
+        if (cache != NULL) {
+            memset(cache, 0, sizeof(*cache));
+            cache->memory = core->memory;
+            cache->lock = gx_monitor_alloc(core->memory);
+            if (cache->lock == NULL) {
+                gs_free_object(core->memory, cache, "stroke_cache_get");
+                cache = NULL;
+            } else {
+                core->stroke_cache = cache;
+                core->free_stroke_cache = stroke_cache_free;
+            }
+        }
+    }
+    gx_monitor_leave((gx_monitor_t *)core->monitor);
+
+    return cache;
+}
+
+static void
+stroke_cache_seg_init(stroke_cache_seg *rec, const segment *pseg,
+                      const gs_fixed_point *origin)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->pt.x = pseg->pt.x - origin->x;
+    rec->pt.y = pseg->pt.y - origin->y;
+    rec->type = pseg->type;
+    rec->notes = pseg->notes;
+    if (pseg->type == s_dash)
+        rec->tangent = ((const dash_segment *)pseg)->tangent;
+    else if (pseg->type == s_start)
+        rec->closed = ((const subpath *)pseg)->is_closed;
+}
+
+/* FNV-1a, a word at a time; size must be a multiple of sizeof(uint). */
+static uint
+stroke_cache_hash(uint hash, const void *data, size_t size)
+{
+    const uint *p = (const uint *)data;
+
+    for (size /= sizeof(uint); size > 0; size--)
+        hash = (hash ^ *p++) * 16777619;
+    return hash;
+}
+
+/* The low bits of an FNV hash aren't well mixed, so use the top ones. */
+static inline int
+stroke_cache_slot(uint hash)
+{
+    return (int)((hash * 2654435761U) >> (32 - STROKE_CACHE_LOG2_SLOTS));
+}
+
+/*
+ * Look for the outline of spath in the cache.  On a hit, move the cached
+ * outline into place, return it in *poutline and return 1; the caller
+ * must give it back with stroke_cache_release once it has been filled.
+ * Otherwise return 0, and set key->store if the outline should be passed
+ * to stroke_cache_store once it has been built.
+ */
+static int
+stroke_cache_lookup(const gx_path *spath, const gs_gstate *pgs,
+                    stroke_line_proc_t line_proc, double device_dot_length,
+                    bool reflected, stroke_cache_key *key,
+                    gx_path **poutline, bool *clears_sgr)
+{
+    const gx_line_params *pgs_lp = gs_currentlineparams_inline(pgs);
+    stroke_cache_params *params = &key->params;
+    const segment *pseg = (const segment *)spath->first_subpath;
+    gx_stroke_cache *cache;
+    stroke_cache_entry *e;
+    stroke_cache_seg rec;
+    uint hash = 2166136261U;
+    int count = 0;
+    int code = 0;
+
+    key->store = false;
+    if (pseg == NULL || gx_path_has_curves(spath))
+        return 0;
+    key->origin = pseg->pt;
+    memset(params, 0, sizeof(*params));
+    params->line_proc = line_proc;
+    params->ctm[0] = pgs->ctm.xx;
+    params->ctm[1] = pgs->ctm.xy;
+    params->ctm[2] = pgs->ctm.yx;
+    params->ctm[3] = pgs->ctm.yy;
+    params->half_width = pgs_lp->half_width;
+    params->miter_limit = pgs_lp->miter_limit;
+    params->miter_check = pgs_lp->miter_check;
+    params->dot_length = device_dot_length;
+    params->start_cap = pgs_lp->start_cap;
+    params->end_cap = pgs_lp->end_cap;
+    params->dash_cap = pgs_lp->dash_cap;
+    params->join = pgs_lp->join;
+    params->curve_join = pgs_lp->curve_join;
+    params->dot_portrait = is_fzero(pgs_lp->dot_orientation.xy);
+    params->reflected = reflected;
+    params->origin_frac.x = key->origin.x & (fixed_1 - 1);
+    params->origin_frac.y = key->origin.y & (fixed_1 - 1);
+    hash = stroke_cache_hash(hash, params, sizeof(*params));
+    for (; pseg != NULL; pseg = pseg->next) {
+        if (++count > STROKE_CACHE_MAX_SEGMENTS)
+            return 0;
+        stroke_cache_seg_init(&rec, pseg, &key->origin);
+        hash = stroke_cache_hash(hash, &rec, sizeof(rec));
+    }
+    key->hash = hash;
+    key->count = count;
+    key->slot = stroke_cache_slot(hash);
+
+    cache = stroke_cache_get(pgs->memory);
+    if (cache == NULL)
+        return 0;
+    gx_monitor_enter(cache->lock);
+    e = &cache->entries[key->slot];
+    if (e->busy) {
+        /* In use; leave it be. */
+    } else if (e->hash == hash && e->count == count) {
+        if (e->outline == NULL) {
+            /* Second time we've seen this path, so keep it. */
+            key->store = true;
+        } else if (!memcmp(&e->params, params, sizeof(*params))) {
+            const stroke_cache_seg *srec = e->segs;
+
+            for (pseg = (const segment *)spath->first_subpath; pseg != NULL;
+                 pseg = pseg->next, srec++) {
+                stroke_cache_seg_init(&rec, pseg, &key->origin);
+                if (memcmp(&rec, srec, sizeof(rec)))
+                    break;
+            }
+            if (pseg == NULL) {
+                code = gx_path_translate(e->outline,
+                                         key->origin.x - e->origin.x,
+                                         key->origin.y - e->origin.y);
+                if (code >= 0) {
+                    e->origin = key->origin;
+                    e->busy = true;
+                    *poutline = e->outline;
+                    *clears_sgr = e->clears_sgr;
+                    code = 1;
+                }
+            }
+        }
+    } else {
+        stroke_cache_clear_entry(cache, e);
+        e->hash = hash;
+        e->count = count;
+    }
+    gx_monitor_leave(cache->lock);
+
+    return code;
+}
+
+/* Give back an outline returned by stroke_cache_lookup. */
+static void
+stroke_cache_release(const gs_gstate *pgs, const stroke_cache_key *key)
+{
+    gx_stroke_cache *cache = stroke_cache_get(pgs->memory);
+
+    gx_monitor_enter(cache->lock);
+    cache->entries[key->slot].busy = false;
+    gx_monitor_leave(cache->lock);
+}
+
+/* Remember the outline built for the path looked up with key. */
+static void
+stroke_cache_store(const gx_path *spath, const gx_path *outline,
+                   const gs_gstate *pgs, const stroke_cache_key *key,
+                   bool clears_sgr)
+{
+    gx_stroke_cache *cache = stroke_cache_get(pgs->memory);
+    stroke_cache_entry *e;
+    const segment *pseg;
+    stroke_cache_seg *srec;
+
+    if (cache == NULL)
+        return;
+    gx_monitor_enter(cache->lock);
+    e = &cache->entries[key->slot];
+    /* Another thread may have got here first. */
+    if (e->busy || e->hash != key->hash || e->count != key->count ||
+        e->outline != NULL)
+        goto out;
+    e->segs = (stroke_cache_seg *)gs_alloc_byte_array(cache->memory,
+                                        key->count, sizeof(stroke_cache_seg),
+                                        "stroke_cache_store");
+    e->outline = gx_path_alloc(cache->memory, "stroke_cache_store");
+    if (e->segs == NULL || e->outline == NULL ||
+        gx_path_copy(outline, e->outline) < 0) {
+        /* Not being able to cache the outline isn't an error. */
+        stroke_cache_clear_entry(cache, e);
+        goto out;
+    }
+    for (pseg = (const segment *)spath->first_subpath, srec = e->segs;
+         pseg != NULL; pseg = pseg->next, srec++)
+        stroke_cache_seg_init(srec, pseg, &key->origin);
+    e->params = key->params;
+    e->origin = key->origin;
+    e->clears_sgr = clears_sgr;
+out:
+    gx_monitor_leave(cache->lock);
+}
+
+/*
+ * Stroke a path of hairlines (the caller has established that the line
+ * is always thin and that the strokes are drawn directly) by handing each
+ * segment straight to draw_thin_line, without the partial_line machinery
+ * the general case needs for joins and caps.  This is what the general
+ * case ends up doing too, so the output is the same.  Only paths made of
+ * nothing but straight lines of non-zero length are handled here (which
+ * includes the usual result of dash expansion); if there's anything else
+ * (dots, gaps, tiny dashes), return 1 and draw nothing.
+ */
+static int
+stroke_thin_lines(const gx_path *spath, gx_device *dev,
+                  const gs_gstate *pgs, const gx_device_color *pdevc)
+{
+    dev_proc_draw_thin_line((*draw_thin_line)) = dev_proc(dev, draw_thin_line);
+    const segment *pseg;
+    fixed x = 0, y = 0;
+    int code;
+
+    for (pseg = (const segment *)spath->first_subpath; pseg != NULL;
+         pseg = pseg->next) {
+        if (pseg->type != s_start) {
+            if ((pseg->type != s_line && pseg->type != s_line_close) ||
+                (pseg->pt.x == x && pseg->pt.y == y))
+                return 1;
+        }
+        x = pseg->pt.x, y = pseg->pt.y;
+    }
+    for (pseg = (const segment *)spath->first_subpath; pseg != NULL;
+         pseg = pseg->next) {
+        if (pseg->type != s_start) {
+            code = (*draw_thin_line)(dev, x, y, pseg->pt.x, pseg->pt.y,
+                                     pdevc, pgs->log_op,
+                                     pgs->fill_adjust.x, pgs->fill_adjust.y);
+            if (code < 0)
+                return code;
+        }
+        x = pseg->pt.x, y = pseg->pt.y;
+    }
+    return 0;
+}
+
 /*
  * Stroke a path.  If to_path != 0, append the stroke outline to it;
  * if to_path == 0, draw the strokes on pdev.
@@ -564,6 +921,9 @@ gx_stroke_path_only_aux(gx_path          *ppath, /* lgtm[cpp/use-of-goto] */
     gs_matrix initial_matrix;
     bool initial_matrix_reflected, flattened_path = false;
     note_flags flags;
+    stroke_cache_key cache_key;
+    bool use_cache;
+    bool clears_sgr = false, saved_sgr = false;
 
     (*dev_proc(pdev, get_initial_matrix)) (pdev, &initial_matrix);
     initial_matrix_reflected = initial_matrix.xy * initial_matrix.yx >
@@ -615,6 +975,10 @@ gx_stroke_path_only_aux(gx_path          *ppath, /* lgtm[cpp/use-of-goto] */
                         ibox.q.y + expansion.y);
         }
     }
+    /* A cached outline may be moved anywhere else on the page, so only
+     * cache strokes that are well inside the fixed range. */
+    use_cache = (ibox.p.x > min_fixed / 4 && ibox.p.y > min_fixed / 4 &&
+                 ibox.q.x < max_fixed / 4 && ibox.q.y < max_fixed / 4);
     /* Check the expanded bounding box against the clipping regions. */
     if (pcpath)
         gx_cpath_inner_box(pcpath, &cbox);
@@ -781,6 +1145,13 @@ gx_stroke_path_only_aux(gx_path          *ppath, /* lgtm[cpp/use-of-goto] */
             dash_count = 0;
         }
     }
+    if (always_thin && line_proc == stroke_fill && !traditional) {
+        /* Hairlines need no joins or caps, so try drawing them directly. */
+        code = stroke_thin_lines(spath, dev, pgs, pdevc);
+        if (code <= 0)
+            goto exit;
+        code = 0;
+    }
     if (to_path == 0) {
         /* We might try to defer this if it's expensive.... */
         to_path = &stroke_path_body;
@@ -790,6 +1161,47 @@ gx_stroke_path_only_aux(gx_path          *ppath, /* lgtm[cpp/use-of-goto] */
         to_path_reverse = &stroke_path_reverse;
         gx_path_init_local(&stroke_path_reverse, ppath->memory);
     }
+    /* We can only use the cache when the whole outline is built before
+     * being filled, and stroke adjustment doesn't carry state from one
+     * stroke to the next. */
+    use_cache &= (to_path == &stroke_path_body &&
+                  !lop_is_idempotent(pgs->log_op) && !pgs->stroke_adjust);
+    if (use_cache) {
+        gx_path *outline;
+
+        code = stroke_cache_lookup(spath, pgs, line_proc, device_dot_length,
+                                   initial_matrix_reflected, &cache_key,
+                                   &outline, &clears_sgr);
+        if (code < 0)
+            goto exit;
+        if (code > 0) {
+            code = 0;
+            if (clears_sgr)
+                dev->sgr.stroke_stored = false;
+            if (!gx_path_is_void(outline)) {
+                /* Share the cached segments, so that anything the fill
+                 * allocates comes from the usual place. */
+                gx_path_free(&stroke_path_body, "gx_stroke_path_only");
+                code = gx_path_init_local_shared(&stroke_path_body, outline,
+                                                 ppath->memory);
+                if (code >= 0) {
+                    fill_params.adjust.x = STROKE_ADJUSTMENT(always_thin, pgs, x);
+                    fill_params.adjust.y = STROKE_ADJUSTMENT(always_thin, pgs, y);
+                    code = gx_fill_path_only(&stroke_path_body, pdev, pgs,
+                                             &fill_params, pdevc, pcpath);
+                    gx_path_free(&stroke_path_body, "gx_stroke_path_only");
+                }
+                gx_path_init_local(&stroke_path_body, ppath->memory);
+            }
+            stroke_cache_release(pgs, &cache_key);
+            goto exit;
+        }
+        if (cache_key.store) {
+            /* Find out whether stroking the path resets dev->sgr. */
+            saved_sgr = dev->sgr.stroke_stored;
+            dev->sgr.stroke_stored = true;
+        }
+    }
     for (psub = spath->first_subpath; psub != 0;) {
         int index = 0;
         const segment *pseg = (const segment *)psub;
@@ -1136,6 +1548,13 @@ gx_stroke_path_only_aux(gx_path          *ppath, /* lgtm[cpp/use-of-goto] */
     }
     if (to_path_reverse != NULL)
         code = gx_join_path_and_reverse(to_path, to_path_reverse);
+    if (use_cache && cache_key.store) {
+        clears_sgr = !dev->sgr.stroke_stored;
+        if (!clears_sgr)
+            dev->sgr.stroke_stored = saved_sgr;
+        if (code >= 0)
+            stroke_cache_store(spath, to_path, pgs, &cache_key, clears_sgr);
+    }
     FILL_STROKE_PATH(pdev, always_thin, pcpath, true);
   exit:
     if (dev == (gx_device *)&cdev)
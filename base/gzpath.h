@@ -163,6 +163,15 @@ gx_subpath_is_rectangular(const subpath * pstart, gs_fixed_rect * pbox,
 /* the curve to within the desired flatness. */
 int gx_curve_log2_samples(fixed, fixed, const curve_segment *, fixed);
 
+/*
+ * Return the tolerance for adaptive flattening of a curve, and check
+ * whether a curve (given as its 4 control points) is within a tolerance
+ * of its chord.
+ */
+fixed gx_curve_flat_tolerance(fixed, fixed, const curve_segment *, fixed);
+bool gx_curve_is_flat(fixed, fixed, fixed, fixed, fixed, fixed, fixed, fixed,
+                      fixed);
+
 /*
  * If necessary, find the values of t (never more than 2) which split the
  * curve into monotonic parts.  Return the number of split points.
@@ -174,6 +183,10 @@ int gx_curve_monotonize(gx_path * ppath, const curve_segment * pc);
 
 /* Flatten a partial curve by sampling (internal procedure). */
 int gx_subdivide_curve(gx_path *, int, curve_segment *, segment_notes);
+
+/* Flatten a partial curve adaptively, to within a tolerance. */
+int gx_subdivide_curve_adaptive(gx_path *, int, curve_segment *,
+                                segment_notes, fixed);
 /*
  * Define the maximum number of points for sampling if we want accurate
  * rasterizing.  2^(k_sample_max*3)-1 must fit into a uint with a bit
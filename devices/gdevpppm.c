@@ -39,7 +39,6 @@ struct gx_device_pppm_s {
     gx_prn_device_common;
     gx_downscaler_params downscale;
     gs_offset_t header_len;
-    gx_monitor_t *monitor;
 };
 
 static int
@@ -176,17 +175,8 @@ static int pppm_process_and_output(void *arg, gx_device *dev, gx_device *bdev, c
     }
 
     /* If we are running in clist multi-threaded mode, we need to nominate the next band that we should work with. */
-    if (orig_dev) {
-        code = gx_monitor_enter(orig_fdev->monitor);
-        if (code < 0)
-            return code;
-
-        clrdev->next_band = orig_dev->next_band;
-        orig_dev->next_band += orig_dev->thread_lookahead_direction;
-        code = gx_monitor_leave(orig_fdev->monitor);
-        if (code < 0)
-            return code;
-    }
+    if (orig_dev)
+        code = clist_claim_next_band(dev);
 
     return code;
 }
@@ -199,7 +189,6 @@ pppm_print_page(gx_device_printer *pdev, gp_file *file)
     static const unsigned char ppmsig[] = { 'P', '6', '\n' };
     char text[32];
     gx_process_page_options_t process = { 0 };
-    int code;
 
     if (!gp_can_share_fdesc()) {
         emprintf(pdev->memory, "The pppm device relies on being able to call gp_fpwrite, and this is not supported on this platform.\n\n");
@@ -220,13 +209,7 @@ pppm_print_page(gx_device_printer *pdev, gp_file *file)
     process.process_fn = pppm_process_and_output;
     process.output_fn = NULL;
     process.arg = file;
+    process.options = GX_PROCPAGE_COST_SCHEDULE;
 
-    fdev->monitor = gx_monitor_alloc(fdev->memory);
-    if (fdev->monitor == NULL)
-        return_error(gs_error_VMerror);
-
-    code = gx_downscaler_process_page((gx_device *)fdev, &process, fdev->downscale.downscale_factor);
-    gx_monitor_free(fdev->monitor);
-
-    return code;
+    return gx_downscaler_process_page((gx_device *)fdev, &process, fdev->downscale.downscale_factor);
 }
@@ -438,6 +438,343 @@ int tiff_set_fields_for_printer(gx_device_printer *pdev,
     return 0;
 }
 
+/*
+ * Strip encoding as a process_page stage.
+ *
+ * For contone output, the compression of each strip can be done on the
+ * rendering threads as soon as the band holding it has been rendered (and
+ * downscaled), rather than serially once the whole page is available.
+ * Every strip that lies wholly within a band is encoded into a small
+ * in-memory TIFF (see tiff_from_mem_file) owned by that band's buffer; the
+ * output_fn then copies the encoded strips into the real file, in order,
+ * with TIFFWriteRawStrip. Rows of strips that straddle a band boundary are
+ * gathered up by the output_fn and encoded there. The resulting file is
+ * identical to that produced by writing the page a scanline at a time.
+ */
+typedef struct tiff_strip_arg_s {
+    TIFF *tif;
+    int width;
+    int height;
+    int rows_per_strip;
+    int bpc;
+    uint16_t spp;
+    uint16_t photometric;
+    uint16_t compression;
+    size_t line_size;
+    /* Rows of a strip that straddles a band boundary. */
+    byte *carry;
+    int carry_y;
+    int carry_rows;
+} tiff_strip_arg_t;
+
+typedef struct tiff_strip_buffer_s {
+    gs_memory_t *memory;
+    int y;              /* First row of the band */
+    int h;              /* Rows in the band */
+    int lead;           /* Rows before the first whole strip */
+    int trail;          /* Rows after the last whole strip */
+    int first_strip;    /* First whole strip */
+    int num_strips;     /* Number of whole strips */
+    int max_strips;
+    uint64_t *strip_offset;
+    uint64_t *strip_size;
+    byte *rows;         /* All rows of the band, packed */
+    tiff_mem_file_t file; /* Encoded whole strips */
+} tiff_strip_buffer_t;
+
+static int
+tiff_strip_init_buffer(void *arg_, gx_device *dev, gs_memory_t *memory, int w, int h, void **pbuffer)
+{
+    tiff_strip_arg_t *arg = (tiff_strip_arg_t *)arg_;
+    tiff_strip_buffer_t *buffer;
+
+    buffer = (tiff_strip_buffer_t *)gs_alloc_bytes(memory, sizeof(*buffer),
+                                                   "tiff_strip_init_buffer");
+    if (buffer == NULL)
+        return_error(gs_error_VMerror);
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->memory = memory;
+    tiff_mem_file_init(&buffer->file, memory);
+    buffer->max_strips = h / arg->rows_per_strip + 2;
+    buffer->rows = gs_alloc_bytes(memory, (size_t)h * arg->line_size,
+                                  "tiff_strip_init_buffer(rows)");
+    buffer->strip_offset = (uint64_t *)gs_alloc_bytes(memory,
+                                  buffer->max_strips * sizeof(uint64_t) * 2,
+                                  "tiff_strip_init_buffer(strips)");
+    if (buffer->rows == NULL || buffer->strip_offset == NULL) {
+        gs_free_object(memory, buffer->rows, "tiff_strip_init_buffer(rows)");
+        gs_free_object(memory, buffer->strip_offset, "tiff_strip_init_buffer(strips)");
+        gs_free_object(memory, buffer, "tiff_strip_init_buffer");
+        return_error(gs_error_VMerror);
+    }
+    buffer->strip_size = buffer->strip_offset + buffer->max_strips;
+    *pbuffer = buffer;
+    return 0;
+}
+
+static void
+tiff_strip_free_buffer(void *arg, gx_device *dev, gs_memory_t *memory, void *buffer_)
+{
+    tiff_strip_buffer_t *buffer = (tiff_strip_buffer_t *)buffer_;
+
+    if (buffer == NULL)
+        return;
+    tiff_mem_file_free(&buffer->file);
+    gs_free_object(memory, buffer->rows, "tiff_strip_init_buffer(rows)");
+    gs_free_object(memory, buffer->strip_offset, "tiff_strip_init_buffer(strips)");
+    gs_free_object(memory, buffer, "tiff_strip_init_buffer");
+}
+
+/* Encode strips [first, first+n) from the packed rows at data. */
+static int
+tiff_strip_encode(tiff_strip_arg_t *arg, tiff_strip_buffer_t *buffer,
+                  byte *data, int first, int n)
+{
+    int rps = arg->rows_per_strip;
+    int rows = min((first + n) * rps, arg->height) - first * rps;
+    TIFF *mtif;
+    uint64_t *offsets, *sizes;
+    int i, code = 0;
+
+    mtif = tiff_from_mem_file(&buffer->file, "tiff_strip_encode",
+                              TIFFIsBigEndian(arg->tif));
+    if (mtif == NULL)
+        return_error(gs_error_VMerror);
+
+    TIFFSetField(mtif, TIFFTAG_IMAGEWIDTH, arg->width);
+    TIFFSetField(mtif, TIFFTAG_IMAGELENGTH, rows);
+    TIFFSetField(mtif, TIFFTAG_BITSPERSAMPLE, arg->bpc);
+    TIFFSetField(mtif, TIFFTAG_SAMPLESPERPIXEL, arg->spp);
+    TIFFSetField(mtif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(mtif, TIFFTAG_PHOTOMETRIC, arg->photometric);
+    TIFFSetField(mtif, TIFFTAG_COMPRESSION, arg->compression);
+    TIFFSetField(mtif, TIFFTAG_ROWSPERSTRIP, rps);
+
+    for (i = 0; i < n; i++) {
+        int h = min(rps, rows - i * rps);
+
+        if (TIFFWriteEncodedStrip(mtif, i, data, (tmsize_t)h * arg->line_size) < 0) {
+            code = gs_note_error(gs_error_ioerror);
+            break;
+        }
+        data += (size_t)h * arg->line_size;
+    }
+    if (code >= 0) {
+        if (!TIFFGetField(mtif, TIFFTAG_STRIPOFFSETS, &offsets) ||
+            !TIFFGetField(mtif, TIFFTAG_STRIPBYTECOUNTS, &sizes))
+            code = gs_note_error(gs_error_ioerror);
+        else {
+            memcpy(buffer->strip_offset, offsets, n * sizeof(uint64_t));
+            memcpy(buffer->strip_size, sizes, n * sizeof(uint64_t));
+        }
+    }
+    TIFFCleanup(mtif);
+    return code;
+}
+
+static int
+tiff_strip_process(void *arg_, gx_device *dev, gx_device *bdev, const gs_int_rect *rect, void *buffer_)
+{
+    tiff_strip_arg_t *arg = (tiff_strip_arg_t *)arg_;
+    tiff_strip_buffer_t *buffer = (tiff_strip_buffer_t *)buffer_;
+    int rps = arg->rows_per_strip;
+    int y = rect->p.y;
+    int h = min(rect->q.y, arg->height) - y;
+    int end, i, code;
+    uint raster;
+    gs_get_bits_params_t params;
+    gs_int_rect my_rect;
+    byte *p, *q;
+
+    buffer->y = y;
+    buffer->h = max(h, 0);
+    buffer->lead = buffer->h;
+    buffer->trail = 0;
+    buffer->num_strips = 0;
+    if (h <= 0)
+        return 0;
+
+    params.options = GB_COLORS_NATIVE | GB_ALPHA_NONE | GB_PACKING_CHUNKY | GB_RETURN_POINTER | GB_ALIGN_ANY | GB_OFFSET_0 | GB_RASTER_ANY;
+    my_rect.p.x = 0;
+    my_rect.p.y = 0;
+    my_rect.q.x = rect->q.x - rect->p.x;
+    my_rect.q.y = h;
+    code = dev_proc(bdev, get_bits_rectangle)(bdev, &my_rect, &params);
+    if (code < 0)
+        return code;
+
+    /* A returned pointer comes with the standard raster. */
+    if (params.options & GB_RASTER_STANDARD)
+        raster = gx_device_raster(bdev, true);
+    else
+        raster = params.raster;
+
+    p = params.data[0];
+    q = buffer->rows;
+    for (i = 0; i < h; i++) {
+        memcpy(q, p, arg->line_size);
+#if defined(ARCH_IS_BIG_ENDIAN) && (!ARCH_IS_BIG_ENDIAN)
+        if (arg->bpc == 16)
+            TIFFSwabArrayOfShort((uint16_t *)q, arg->width * (long)arg->spp);
+#endif
+        p += raster;
+        q += arg->line_size;
+    }
+
+    /* Find the strips that lie wholly within this band. The last strip of
+     * the page may be short. */
+    buffer->first_strip = (y + rps - 1) / rps;
+    if (y + h == arg->height)
+        end = (arg->height + rps - 1) / rps;
+    else
+        end = (y + h) / rps;
+    if (end <= buffer->first_strip)
+        return 0;
+    buffer->num_strips = end - buffer->first_strip;
+    buffer->lead = buffer->first_strip * rps - y;
+    buffer->trail = y + h - min(end * rps, arg->height);
+
+    return tiff_strip_encode(arg, buffer,
+                             buffer->rows + (size_t)buffer->lead * arg->line_size,
+                             buffer->first_strip, buffer->num_strips);
+}
+
+/* Add rows to a strip that straddles bands, writing it once complete. */
+static int
+tiff_strip_carry(tiff_strip_arg_t *arg, byte *data, int y, int n)
+{
+    int rps = arg->rows_per_strip;
+
+    for (; n > 0; n--, y++, data += arg->line_size) {
+        int strip, strip_end;
+
+        if (arg->carry_rows == 0)
+            arg->carry_y = y;
+        memcpy(arg->carry + (size_t)arg->carry_rows * arg->line_size,
+               data, arg->line_size);
+        arg->carry_rows++;
+        strip = arg->carry_y / rps;
+        strip_end = min((strip + 1) * rps, arg->height);
+        if (arg->carry_y + arg->carry_rows == strip_end) {
+            if (TIFFWriteEncodedStrip(arg->tif, strip, arg->carry,
+                          (tmsize_t)arg->carry_rows * arg->line_size) < 0)
+                return_error(gs_error_ioerror);
+            arg->carry_rows = 0;
+        }
+    }
+    return 0;
+}
+
+static int
+tiff_strip_output(void *arg_, gx_device *dev, void *buffer_)
+{
+    tiff_strip_arg_t *arg = (tiff_strip_arg_t *)arg_;
+    tiff_strip_buffer_t *buffer = (tiff_strip_buffer_t *)buffer_;
+    int i, code;
+
+    code = tiff_strip_carry(arg, buffer->rows, buffer->y, buffer->lead);
+    if (code < 0)
+        return code;
+    for (i = 0; i < buffer->num_strips; i++) {
+        if (TIFFWriteRawStrip(arg->tif, buffer->first_strip + i,
+                              buffer->file.data + buffer->strip_offset[i],
+                              (tmsize_t)buffer->strip_size[i]) < 0)
+            return_error(gs_error_ioerror);
+    }
+    return tiff_strip_carry(arg,
+                            buffer->rows + (size_t)(buffer->h - buffer->trail) * arg->line_size,
+                            buffer->y + buffer->h - buffer->trail, buffer->trail);
+}
+
+/* Can this page be written by tiff_process_page_strips? The device must be
+ * chunky, at 8 or 16 bits per component, with one of the strip
+ * compressions used for contone, and the page must span more than one
+ * strip (a single strip gains nothing from this). */
+static bool
+tiff_can_process_page_strips(gx_device_printer *dev, TIFF *tif, int factor)
+{
+    uint32_t width = 0, height = 0, rps = 0;
+    uint16_t bps = 0, spp = 0, compression = 0, planar = 0;
+
+    if (dev->num_planar_planes != 0 || factor < 1 || factor > 8)
+        return false;
+    if (!TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width) ||
+        !TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height) ||
+        !TIFFGetField(tif, TIFFTAG_ROWSPERSTRIP, &rps) ||
+        !TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &bps) ||
+        !TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &spp) ||
+        !TIFFGetField(tif, TIFFTAG_COMPRESSION, &compression) ||
+        !TIFFGetField(tif, TIFFTAG_PLANARCONFIG, &planar))
+        return false;
+    if ((bps != 8 && bps != 16) || planar != PLANARCONFIG_CONTIG ||
+        (factor > 1 && (bps != 8 || spp == 2 || spp > 4)) ||
+        bps != dev->color_info.comp_bits[0] ||
+        spp != dev->color_info.num_components)
+        return false;
+    if (compression != COMPRESSION_NONE && compression != COMPRESSION_LZW &&
+        compression != COMPRESSION_PACKBITS)
+        return false;
+    if (rps == 0 || rps >= height)
+        return false;
+    /* The strips are cut from the (downscaled) bands; the file must not be
+     * wider or taller than those. */
+    return width <= (dev->width + factor - 1) / factor &&
+           height <= (dev->height + factor - 1) / factor;
+}
+
+static int
+tiff_process_page_strips(gx_device_printer *dev, TIFF *tif, int factor)
+{
+    tiff_strip_arg_t arg = { 0 };
+    gx_process_page_options_t options = { 0 };
+    uint32_t width, height, rps;
+    uint16_t bps;
+    int code;
+
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetField(tif, TIFFTAG_ROWSPERSTRIP, &rps);
+    TIFFGetField(tif, TIFFTAG_BITSPERSAMPLE, &bps);
+    TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &arg.spp);
+    TIFFGetField(tif, TIFFTAG_COMPRESSION, &arg.compression);
+    if (!TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &arg.photometric))
+        arg.photometric = PHOTOMETRIC_MINISBLACK;
+    arg.tif = tif;
+    arg.width = width;
+    arg.height = height;
+    arg.rows_per_strip = rps;
+    arg.bpc = bps;
+    arg.line_size = TIFFScanlineSize(tif);
+
+    code = TIFFCheckpointDirectory(tif);
+    if (code < 0)
+        return code;
+
+    arg.carry = gs_alloc_bytes(dev->memory, (size_t)rps * arg.line_size,
+                               "tiff_process_page_strips(carry)");
+    if (arg.carry == NULL)
+        return_error(gs_error_VMerror);
+
+    options.init_buffer_fn = tiff_strip_init_buffer;
+    options.free_buffer_fn = tiff_strip_free_buffer;
+    options.process_fn = tiff_strip_process;
+    options.output_fn = tiff_strip_output;
+    options.arg = &arg;
+
+    if (factor == 1)
+        code = dev_proc(dev, process_page)((gx_device *)dev, &options);
+    else
+        code = gx_downscaler_process_page((gx_device *)dev, &options, factor);
+    if (code >= 0 && arg.carry_rows != 0)
+        code = gs_note_error(gs_error_unknownerror);
+    if (code >= 0)
+        code = TIFFWriteDirectory(tif);
+
+    gs_free_object(dev->memory, arg.carry, "tiff_process_page_strips(carry)");
+
+    return code;
+}
+
 int
 tiff_print_page(gx_device_printer *dev, TIFF *tif, int min_feature_size)
 {
@@ -451,11 +788,14 @@ tiff_print_page(gx_device_printer *dev, TIFF *tif, int min_feature_size)
     int line_lag = 0;
     int filtered_count;
 
+    if (bpc != 1)
+        min_feature_size = 1;
+    if (min_feature_size <= 1 && tiff_can_process_page_strips(dev, tif, 1))
+        return tiff_process_page_strips(dev, tif, 1);
+
     data = gs_alloc_bytes(dev->memory, max_size, "tiff_print_page(data)");
     if (data == NULL)
         return_error(gs_error_VMerror);
-    if (bpc != 1)
-        min_feature_size = 1;
     if (min_feature_size > 1) {
         code = min_feature_size_init(dev->memory, min_feature_size,
                                      dev->width, dev->height,
@@ -541,6 +881,22 @@ tiff_downscale_and_print_page(gx_device_printer *dev, TIFF **tifp,
     int height = dev->height/factor;
     gx_downscaler_t ds;
 
+    /* Plain contone downscaling can be done band by band, with the strips
+     * being encoded as we go. */
+    if (bpc == 8 && tfdev->icclink == NULL &&
+        params->min_feature_size <= 1 && params->trap_w == 0 &&
+        params->trap_h == 0 && params->ets == 0 &&
+        !params->do_skew_detection &&
+        num_comps == dev->color_info.num_components &&
+        tiff_can_process_page_strips(dev, tif, factor)) {
+        code = tiff_process_page_strips(dev, tif, factor);
+        if (code < 0) {
+            TIFFClose(tif);
+            *tifp = NULL;
+        }
+        return code;
+    }
+
     code = TIFFCheckpointDirectory(tif);
     if (code < 0)
         return code;
@@ -48,6 +48,7 @@
 #include "pltop.h"
 #include "plapi.h"
 #include "gslibctx.h"
+#include "gsstate.h"        /* for gs_setfillthreads, gs_setadaptiveflattening */
 #include "gsicc_manage.h"
 #include "gxiodev.h"
 #include "stream.h"
@@ -1543,6 +1544,14 @@ static int check_for_special_int(pl_main_instance_t * pmi, const char *arg, int6
         pmi->reset_resources = b;
         return 0;
     }
+    if (argis(arg, "NumFillThreads")) {
+        gs_setfillthreads(pmi->memory, (int)b);
+        return 0;
+    }
+    if (argis(arg, "AdaptiveFlattening")) {
+        gs_setadaptiveflattening(pmi->memory, b != 0);
+        return 0;
+    }
     if (argis(arg, "NODISPLAY")) {
         pmi->pause = !b;
         pmi->device_index = get_device_index(pmi->memory, "nullpage");
@@ -1560,6 +1569,8 @@ static int check_for_special_float(pl_main_instance_t * pmi, const char *arg, fl
         argis(arg, "DOINTERPOLATE") ||
         argis(arg, "NOCACHE") ||
         argis(arg, "SCANCONVERTERTYPE") ||
+        argis(arg, "NumFillThreads") ||
+        argis(arg, "AdaptiveFlattening") ||
         argis(arg, "RESETRESOURCES") ||
         argis(arg, "NOSAFER")) {
         return gs_note_error(gs_error_rangecheck);
@@ -1574,6 +1585,8 @@ static int check_for_special_str(pl_main_instance_t * pmi, const char *arg, gs_p
         argis(arg, "DOINTERPOLATE") ||
         argis(arg, "NOCACHE") ||
         argis(arg, "SCANCONVERTERTYPE") ||
+        argis(arg, "NumFillThreads") ||
+        argis(arg, "AdaptiveFlattening") ||
         argis(arg, "RESETRESOURCES") ||
         argis(arg, "NOSAFER")) {
         return gs_note_error(gs_error_rangecheck);
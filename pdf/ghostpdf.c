@@ -39,8 +39,10 @@
 #include "pdf_doc.h"
 #include "pdf_repair.h"
 #include "pdf_xref.h"
+#include "pdf_deref.h"
 #include "pdf_device.h"
 #include "pdf_mark.h"
+#include "pdf_obj.h"
 
 #include "gsstate.h"        /* For gs_gstate */
 #include "gsicc_manage.h"  /* For gsicc_init_iccmanager() */
@@ -777,29 +779,77 @@ pdfi_report_errors(pdf_context *ctx)
  * be evaded. We need functions to get an index for a given string (which will
  * add the string to the table if its not present) and to cleear up the table
  * on finishing a PDF file.
+ *
+ * Files with many spot colours can put hundreds of names in here, so the entries
+ * are chained from a hash table for lookup by name, and kept in an array (entry
+ * n has index n + 1) for lookup by index.
  */
+#define PDFI_NAME_TABLE_INITIAL_SIZE 64
 
-int pdfi_get_name_index(pdf_context *ctx, char *name, int len, unsigned int *returned)
+/* Grow the index array and, keeping it at no more than one entry per bucket on
+ * average, the hash table.
+ */
+static int pdfi_grow_name_table(pdf_context *ctx)
 {
-    pdfi_name_entry_t *e = NULL, *last_entry = NULL, *new_entry = NULL;
-    int index = 0;
+    uint32_t new_size = ctx->name_index_size == 0 ? PDFI_NAME_TABLE_INITIAL_SIZE : ctx->name_index_size * 2;
+    pdfi_name_entry_t **new_index, **new_table;
+    uint32_t i;
+
+    if (new_size <= ctx->name_index_size)
+        return_error(gs_error_limitcheck);
+
+    new_index = (pdfi_name_entry_t **)gs_alloc_bytes(ctx->memory, (size_t)new_size * sizeof(pdfi_name_entry_t *), "pdfi_grow_name_table (index)");
+    new_table = (pdfi_name_entry_t **)gs_alloc_bytes(ctx->memory, (size_t)new_size * sizeof(pdfi_name_entry_t *), "pdfi_grow_name_table (hash)");
+    if (new_index == NULL || new_table == NULL) {
+        gs_free_object(ctx->memory, new_index, "pdfi_grow_name_table (index)");
+        gs_free_object(ctx->memory, new_table, "pdfi_grow_name_table (hash)");
+        return_error(gs_error_VMerror);
+    }
+    memset(new_table, 0x00, (size_t)new_size * sizeof(pdfi_name_entry_t *));
+    if (ctx->name_entries > 0)
+        memcpy(new_index, ctx->name_index, ctx->name_entries * sizeof(pdfi_name_entry_t *));
 
-    if (ctx->name_table == NULL) {
-        e = NULL;
-    } else {
-        e = ctx->name_table;
+    /* Rehash the existing entries */
+    for (i = 0; i < ctx->name_entries; i++) {
+        pdfi_name_entry_t *e = new_index[i];
+        uint32_t bucket = pdfi_name_hash((const byte *)e->name, e->len) & (new_size - 1);
+
+        e->next = new_table[bucket];
+        new_table[bucket] = e;
     }
 
-    while(e != NULL) {
-        if (e->len == len) {
-            if (memcmp(e->name, name, e->len) == 0) {
-                *returned = e->index;
-                return 0;
+    gs_free_object(ctx->memory, ctx->name_index, "pdfi_grow_name_table (index)");
+    gs_free_object(ctx->memory, ctx->name_table, "pdfi_grow_name_table (hash)");
+    ctx->name_index = new_index;
+    ctx->name_table = new_table;
+    ctx->name_index_size = new_size;
+    return 0;
+}
+
+int pdfi_get_name_index(pdf_context *ctx, char *name, int len, unsigned int *returned)
+{
+    pdfi_name_entry_t *e = NULL, *new_entry = NULL;
+    uint32_t hash = pdfi_name_hash((const byte *)name, len);
+    int code;
+
+    if (ctx->name_table != NULL) {
+        e = ctx->name_table[hash & (ctx->name_index_size - 1)];
+
+        while(e != NULL) {
+            if (e->len == len) {
+                if (memcmp(e->name, name, e->len) == 0) {
+                    *returned = e->index;
+                    return 0;
+                }
             }
+            e = e->next;
         }
-        last_entry = e;
-        index = e->index;
-        e = e->next;
+    }
+
+    if (ctx->name_entries == ctx->name_index_size) {
+        code = pdfi_grow_name_table(ctx);
+        if (code < 0)
+            return code;
     }
 
     new_entry = (pdfi_name_entry_t *)gs_alloc_bytes(ctx->memory, sizeof(pdfi_name_entry_t), "Alloc name table entry");
@@ -814,12 +864,11 @@ int pdfi_get_name_index(pdf_context *ctx, char *name, int len, unsigned int *ret
     memset(new_entry->name, 0x00, len+1);
     memcpy(new_entry->name, name, len);
     new_entry->len = len;
-    new_entry->index = ++index;
+    new_entry->index = ctx->name_entries + 1;
 
-    if (last_entry)
-        last_entry->next = new_entry;
-    else
-        ctx->name_table = new_entry;
+    new_entry->next = ctx->name_table[hash & (ctx->name_index_size - 1)];
+    ctx->name_table[hash & (ctx->name_index_size - 1)] = new_entry;
+    ctx->name_index[ctx->name_entries++] = new_entry;
 
     *returned = new_entry->index;
     return 0;
@@ -827,34 +876,37 @@ int pdfi_get_name_index(pdf_context *ctx, char *name, int len, unsigned int *ret
 
 static int pdfi_free_name_table(pdf_context *ctx)
 {
-    if (ctx->name_table) {
-        pdfi_name_entry_t *next = NULL, *e = (pdfi_name_entry_t *)ctx->name_table;
-
-        while (e != NULL) {
-            next = (pdfi_name_entry_t *)e->next;
-            gs_free_object(ctx->memory, e->name, "free name table entries");
-            gs_free_object(ctx->memory, e, "free name table entries");
-            e = next;
-        }
+    uint32_t i;
+
+    for (i = 0; i < ctx->name_entries; i++) {
+        gs_free_object(ctx->memory, ctx->name_index[i]->name, "free name table entries");
+        gs_free_object(ctx->memory, ctx->name_index[i], "free name table entries");
     }
+    gs_free_object(ctx->memory, ctx->name_index, "free name table index");
+    gs_free_object(ctx->memory, ctx->name_table, "free name table");
     ctx->name_table = NULL;
+    ctx->name_index = NULL;
+    ctx->name_index_size = ctx->name_entries = 0;
     return 0;
 }
 
+static pdfi_name_entry_t *pdfi_name_entry_from_index(pdf_context *ctx, int index)
+{
+    if (index < 1 || (uint32_t)index > ctx->name_entries)
+        return NULL;
+    return ctx->name_index[index - 1];
+}
+
 int pdfi_name_from_index(pdf_context *ctx, int index, unsigned char **name, unsigned int *len)
 {
-    pdfi_name_entry_t *e = (pdfi_name_entry_t *)ctx->name_table;
+    pdfi_name_entry_t *e = pdfi_name_entry_from_index(ctx, index);
 
-    while (e != NULL) {
-        if (e->index == index) {
-            *name = (unsigned char *)e->name;
-            *len = e->len;
-            return 0;
-        }
-        e = e->next;
-    }
+    if (e == NULL)
+        return_error(gs_error_undefined);
 
-    return_error(gs_error_undefined);
+    *name = (unsigned char *)e->name;
+    *len = e->len;
+    return 0;
 }
 
 int pdfi_separation_name_from_index(gs_gstate *pgs, gs_separation_name index, unsigned char **name, unsigned int *len)
@@ -870,18 +922,13 @@ int pdfi_separation_name_from_index(gs_gstate *pgs, gs_separation_name index, un
     if (ctx == NULL)
         return_error(gs_error_undefined);
 
-    e = (pdfi_name_entry_t *)ctx->name_table;
-
-    while (e != NULL) {
-        if (e->index == index) {
-            *name = (unsigned char *)e->name;
-            *len = e->len;
-            return 0;
-        }
-        e = e->next;
-    }
+    e = pdfi_name_entry_from_index(ctx, (int)index);
+    if (e == NULL)
+        return_error(gs_error_undefined);
 
-    return_error(gs_error_undefined);
+    *name = (unsigned char *)e->name;
+    *len = e->len;
+    return 0;
 }
 
 int pdfi_finish_pdf_file(pdf_context *ctx)
@@ -1648,6 +1695,313 @@ int pdfi_open_pdf_file(pdf_context *ctx, char *filename)
     return code;
 }
 
+/* Linearized files (PDF 1.7 Annex F) start with a linearization dictionary, followed by a
+ * cross-reference section and everything needed to draw the first page. When the file
+ * arrives as a stream (see pdftop.c) we can draw the first page as soon as that much has
+ * arrived, rather than waiting for the whole file.
+ */
+static bool pdfi_linearized_iswhite(byte c)
+{
+    return c == 0x00 || c == 0x09 || c == 0x0a || c == 0x0c || c == 0x0d || c == 0x20;
+}
+
+static const byte *pdfi_linearized_skip_white(const byte *p, const byte *end)
+{
+    while (p < end) {
+        if (*p == '%') {
+            while (p < end && *p != 0x0a && *p != 0x0d)
+                p++;
+        } else if (pdfi_linearized_iswhite(*p))
+            p++;
+        else
+            break;
+    }
+    return p;
+}
+
+/* Read a non-negative number, ignoring any fractional part (/Linearized 1.0) */
+static const byte *pdfi_linearized_read_num(const byte *p, const byte *end, int64_t *val)
+{
+    const byte *start = p;
+    int64_t v = 0;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (p - start > 18)
+            return NULL;
+        v = v * 10 + *p++ - '0';
+    }
+    if (p == start)
+        return NULL;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')
+            p++;
+    }
+    *val = v;
+    return p;
+}
+
+/* Look for a linearization dictionary in the first bytes of a file. The dictionary has to
+ * be the first object in the file and wholly within the first 1024 bytes.
+ * Returns 1 and fills in 'info' if the file is linearized and we can use it to draw the
+ * first page early, 0 if not.
+ */
+int pdfi_read_linearized_header(pdf_context *ctx, const byte *Buffer, int bytes, pdfi_linearized_t *info)
+{
+    const byte *p = Buffer, *end = Buffer + bytes;
+    int64_t val = 0, page = 0;
+    bool linearized = false;
+
+    memset(info, 0x00, sizeof(pdfi_linearized_t));
+
+    while (p + 5 <= end && memcmp(p, "%PDF-", 5) != 0)
+        p++;
+    if (p + 5 > end)
+        return 0;
+
+    /* The header comment, and usually a comment with binary characters, then 'n g obj' */
+    p = pdfi_linearized_skip_white(p, end);
+    p = pdfi_linearized_read_num(p, end, &val);
+    if (p == NULL)
+        return 0;
+    p = pdfi_linearized_skip_white(p, end);
+    p = pdfi_linearized_read_num(p, end, &val);
+    if (p == NULL)
+        return 0;
+    p = pdfi_linearized_skip_white(p, end);
+    if (end - p < 3 || memcmp(p, "obj", 3) != 0)
+        return 0;
+    p = pdfi_linearized_skip_white(p + 3, end);
+    if (end - p < 2 || p[0] != '<' || p[1] != '<')
+        return 0;
+    p += 2;
+
+    while (1) {
+        const byte *key;
+        int keylen;
+
+        p = pdfi_linearized_skip_white(p, end);
+        if (end - p < 2)
+            return 0;
+        if (p[0] == '>' && p[1] == '>')
+            break;
+        if (*p != '/')
+            return 0;
+        key = ++p;
+        while (p < end && !pdfi_linearized_iswhite(*p) && strchr("()<>[]{}/%", *p) == NULL)
+            p++;
+        keylen = p - key;
+
+        p = pdfi_linearized_skip_white(p, end);
+        if (p < end && *p == '[') {
+            /* The hint stream offsets (/H), we don't use them */
+            while (p < end && *p != ']')
+                p++;
+            if (p++ == end)
+                return 0;
+            continue;
+        }
+        p = pdfi_linearized_read_num(p, end, &val);
+        if (p == NULL)
+            return 0;
+
+        if (keylen == 10 && memcmp(key, "Linearized", 10) == 0)
+            linearized = true;
+        else if (keylen == 1) {
+            switch (*key) {
+                case 'L':
+                    info->length = val;
+                    break;
+                case 'E':
+                    info->first_page_end = val;
+                    break;
+                case 'O':
+                    if (val > 0x7fffffff)
+                        return 0;
+                    info->first_page_obj = (uint32_t)val;
+                    break;
+                case 'N':
+                    info->num_pages = val;
+                    break;
+                case 'P':
+                    page = val;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    p = pdfi_linearized_skip_white(p + 2, end);
+    if (end - p < 6 || memcmp(p, "endobj", 6) != 0)
+        return 0;
+    p = pdfi_linearized_skip_white(p + 6, end);
+    if (p == end)
+        return 0;
+    info->first_page_xref = p - Buffer;
+
+    /* /P is the number of the first page, if it isn't the first page in the file we can't
+     * simply render it and carry on with the rest of the pages later.
+     */
+    if (!linearized || page != 0 || info->first_page_obj == 0 || info->num_pages == 0 ||
+        info->first_page_end <= info->first_page_xref || info->first_page_end > info->length)
+        return 0;
+
+    if (ctx->args.pdfdebug)
+        outprintf(ctx->memory, "%% Linearized file, first page section ends at %"PRIdOFFSET"\n", info->first_page_end);
+    return 1;
+}
+
+static bool
+pdfi_fontdir_purge_all(const gs_memory_t * mem, cached_char * cc, void *dummy);
+
+/* Throw away everything we read while drawing the first page, ready for reading the whole
+ * file. Objects we read may refer to objects we didn't have yet, so we don't keep any of them.
+ */
+static void pdfi_close_linearized_first_page(pdf_context *ctx)
+{
+    pdfi_clearstack(ctx);
+    pdfi_doc_page_array_free(ctx);
+    ctx->num_pages = 0;
+    pdfi_check_free_memo(ctx);
+    pdfi_free_OptionalRoot(ctx);
+
+    pdfi_countdown(ctx->Root);
+    ctx->Root = NULL;
+    pdfi_countdown(ctx->Trailer);
+    ctx->Trailer = NULL;
+
+    if (ctx->xref_table != NULL) {
+        pdfi_purge_obj_cache(ctx);
+        pdfi_countdown(ctx->xref_table);
+        ctx->xref_table = NULL;
+    }
+    pdfi_free_objstm_cache(ctx);
+    if (ctx->font_dir)
+        gx_purge_selected_cached_chars(ctx->font_dir, pdfi_fontdir_purge_all, (void *)NULL);
+
+    if (ctx->main_stream) {
+        if (ctx->main_stream->s)
+            sfclose(ctx->main_stream->s);
+        gs_free_object(ctx->memory, ctx->main_stream, "pdfi_close_linearized_first_page");
+        ctx->main_stream = NULL;
+    }
+    ctx->main_stream_length = 0;
+    ctx->startxref = 0;
+    ctx->is_hybrid = false;
+    ctx->first_page_only = false;
+}
+
+/* Draw the first page of a linearized file when only the part of it up to the end of the
+ * first page section has been written to 'filename'.
+ * Returns 1 if the page was drawn, 0 if we couldn't do so (nothing has been sent to the
+ * device, and the page should be drawn along with the rest once the file is complete) or
+ * an error from drawing the page if we are stopping on errors.
+ */
+int pdfi_process_linearized_first_page(pdf_context *ctx, char *filename, pdfi_linearized_t *info)
+{
+    char saved_errors[PDF_ERROR_BYTE_SIZE], saved_warnings[PDF_WARNING_BYTE_SIZE];
+    bool saved_prefer_xrefstm = ctx->prefer_xrefstm;
+    pdf_dict *page_dict = NULL;
+    pdf_name *Type = NULL;
+    bool known = false, rendered = false;
+    stream *s = NULL;
+    uint64_t i;
+    int code;
+
+    memcpy(saved_errors, ctx->pdf_errors, PDF_ERROR_BYTE_SIZE);
+    memcpy(saved_warnings, ctx->pdf_warnings, PDF_WARNING_BYTE_SIZE);
+
+    s = sfopen(filename, "r", ctx->memory);
+    if (s == NULL)
+        return 0;
+    s->close_at_eod = false;
+
+    ctx->main_stream = (pdf_c_stream *)gs_alloc_bytes(ctx->memory, sizeof(pdf_c_stream), "pdfi_process_linearized_first_page");
+    if (ctx->main_stream == NULL) {
+        sfclose(s);
+        return_error(gs_error_VMerror);
+    }
+    memset(ctx->main_stream, 0x00, sizeof(pdf_c_stream));
+    ctx->main_stream->s = s;
+    ctx->main_stream_length = info->first_page_end;
+    ctx->startxref = info->first_page_xref;
+    ctx->first_page_only = true;
+
+    code = pdfi_read_xref(ctx);
+    if (code < 0 || ctx->xref_table == NULL || ctx->Trailer == NULL)
+        goto exit;
+
+    /* Check everything in the first page section really is before /E, so we know we have it */
+    for (i = 0; i < ctx->xref_table->xref_size; i++) {
+        xref_entry *entry = &ctx->xref_table->xref[i];
+
+        if (entry->object_num != 0 && !entry->free && !entry->compressed &&
+            entry->u.uncompressed.offset >= info->first_page_end)
+            goto exit;
+    }
+
+    pdfi_device_set_flags(ctx);
+    /* High level devices want the document level information before any pages, and
+     * encrypted files need the Encrypt dictionary, so leave those until we have the
+     * whole file.
+     */
+    if (ctx->device_state.HighLevelDevice || ctx->device_state.writepdfmarks ||
+        ctx->device_state.ModifiesPageOrder)
+        goto exit;
+    code = pdfi_dict_known(ctx, ctx->Trailer, "Encrypt", &known);
+    if (code < 0 || known)
+        goto exit;
+
+    code = pdfi_read_Root(ctx);
+    if (code < 0)
+        goto exit;
+    pdfi_read_OptionalRoot(ctx);
+    if (ctx->Collection != NULL)
+        goto exit;
+    /* The OutputIntents and AcroForm are set up by pdfi_doc_trailer, which wants the
+     * whole file, and they affect how every page is drawn, the first included.
+     */
+    code = pdfi_dict_known(ctx, ctx->Root, "OutputIntents", &known);
+    if (code < 0 || known)
+        goto exit;
+    code = pdfi_dict_known(ctx, ctx->Root, "AcroForm", &known);
+    if (code < 0 || known)
+        goto exit;
+
+    code = pdfi_doc_page_array_init_first_page(ctx, info->num_pages, info->first_page_obj);
+    if (code < 0)
+        goto exit;
+
+    /* Make sure we have the page before we start sending anything to the device */
+    code = pdfi_page_get_dict(ctx, 0, &page_dict);
+    if (code < 0)
+        goto exit;
+    code = pdfi_dict_get_type(ctx, page_dict, "Type", PDF_NAME, (pdf_obj **)&Type);
+    if (code < 0 || !pdfi_name_is(Type, "Page"))
+        goto exit;
+
+    pdfi_device_misc_config(ctx);
+
+    rendered = true;
+    code = pdfi_page_render(ctx, 0, true);
+    if (code < 0)
+        code = pdfi_set_error_stop(ctx, code, NULL, E_PDF_GS_LIB_ERROR, "pdfi_process_linearized_first_page", NULL);
+
+exit:
+    pdfi_countdown(Type);
+    pdfi_countdown(page_dict);
+    pdfi_close_linearized_first_page(ctx);
+    ctx->prefer_xrefstm = saved_prefer_xrefstm;
+
+    if (!rendered) {
+        /* Anything which went wrong was down to not having the whole file */
+        memcpy(ctx->pdf_errors, saved_errors, PDF_ERROR_BYTE_SIZE);
+        memcpy(ctx->pdf_warnings, saved_warnings, PDF_WARNING_BYTE_SIZE);
+        return 0;
+    }
+    return code < 0 ? code : 1;
+}
+
 static size_t pdfi_grdir_path_string_match(const byte *str, size_t sl0, byte *pat, size_t pl)
 {
     bool found = false;
@@ -1977,6 +2331,7 @@ pdf_context *pdfi_create_context(gs_memory_t *mem)
     ctx->args.preserveembeddedfiles = true;
     ctx->args.preservedocview = true;
     ctx->args.PDFCacheSize = MAX_OBJECT_CACHE_SIZE;
+    ctx->args.PDFCacheBytes = 0; /* Use PDFCacheSize unless a byte budget is set */
     /* NOTE: For testing certain annotations on cluster, might want to set this to false */
     ctx->args.printed = false; /* True if OutputFile is set, false otherwise see pdftop.c, pdf_impl_set_param() */
 
@@ -2004,12 +2359,6 @@ pdf_context *pdfi_create_context(gs_memory_t *mem)
 #if REFCNT_DEBUG
     ctx->UID = 1;
 #endif
-#if CACHE_STATISTICS
-    ctx->hits = 0;
-    ctx->misses = 0;
-    ctx->compressed_hits = 0;
-    ctx->compressed_misses = 0;
-#endif
 #ifdef DEBUG
     ctx->args.verbose_errors = ctx->args.verbose_warnings = 1;
 #endif
@@ -2052,10 +2401,10 @@ pdfi_print_cache(pdf_context *ctx)
 #endif
 #endif /* DEBUG */
 
-#if PURGE_CACHE_PER_PAGE
 void
 pdfi_purge_obj_cache(pdf_context *ctx)
 {
+    pdfi_merge_obj_cache_pools(ctx);
     if (ctx->cache_entries != 0) {
         pdf_obj_cache_entry *entry = ctx->cache_LRU, *next;
 
@@ -2074,9 +2423,9 @@ pdfi_purge_obj_cache(pdf_context *ctx)
         }
         ctx->cache_LRU = ctx->cache_MRU = NULL;
         ctx->cache_entries = 0;
+        ctx->cache_bytes = 0;
     }
 }
-#endif
 
 /* pdfi_clear_context frees all the PDF objects associated with interpreting a given
  * PDF file. Once we've called this we can happily run another file. This function is
@@ -2085,21 +2434,28 @@ pdfi_purge_obj_cache(pdf_context *ctx)
  */
 int pdfi_clear_context(pdf_context *ctx)
 {
-#if CACHE_STATISTICS
-    float compressed_hit_rate = 0.0, hit_rate = 0.0;
-
-    if (ctx->compressed_hits > 0 || ctx->compressed_misses > 0)
-        compressed_hit_rate = (float)ctx->compressed_hits / (float)(ctx->compressed_hits + ctx->compressed_misses);
-    if (ctx->hits > 0 || ctx->misses > 0)
-        hit_rate = (float)ctx->hits / (float)(ctx->hits + ctx->misses);
-
-    outprintf(ctx->memory, "Number of normal object cache hits: %"PRIi64"\n", ctx->hits);
-    outprintf(ctx->memory, "Number of normal object cache misses: %"PRIi64"\n", ctx->misses);
-    outprintf(ctx->memory, "Number of compressed object cache hits: %"PRIi64"\n", ctx->compressed_hits);
-    outprintf(ctx->memory, "Number of compressed object cache misses: %"PRIi64"\n", ctx->compressed_misses);
-    outprintf(ctx->memory, "Normal object cache hit rate: %f\n", hit_rate);
-    outprintf(ctx->memory, "Compressed object cache hit rate: %f\n", compressed_hit_rate);
-#endif
+    if ((CACHE_STATISTICS || ctx->args.PDFCacheStats) &&
+        (ctx->hits > 0 || ctx->misses > 0 || ctx->compressed_hits > 0 || ctx->compressed_misses > 0)) {
+        float compressed_hit_rate = 0.0, hit_rate = 0.0;
+
+        if (ctx->compressed_hits > 0 || ctx->compressed_misses > 0)
+            compressed_hit_rate = (float)ctx->compressed_hits / (float)(ctx->compressed_hits + ctx->compressed_misses);
+        if (ctx->hits > 0 || ctx->misses > 0)
+            hit_rate = (float)ctx->hits / (float)(ctx->hits + ctx->misses);
+
+        errprintf(ctx->memory, "Number of normal object cache hits: %"PRIu64"\n", ctx->hits);
+        errprintf(ctx->memory, "Number of normal object cache misses: %"PRIu64"\n", ctx->misses);
+        errprintf(ctx->memory, "Number of compressed object cache hits: %"PRIu64"\n", ctx->compressed_hits);
+        errprintf(ctx->memory, "Number of compressed object cache misses: %"PRIu64"\n", ctx->compressed_misses);
+        errprintf(ctx->memory, "Normal object cache hit rate: %f\n", hit_rate);
+        errprintf(ctx->memory, "Compressed object cache hit rate: %f\n", compressed_hit_rate);
+        errprintf(ctx->memory, "Object cache general pool: %u entries, %"PRIu64" bytes, %"PRIu64" evictions\n",
+                  ctx->cache_entries, ctx->cache_bytes, ctx->cache_evictions);
+        errprintf(ctx->memory, "Object cache resource pool: %u entries, %"PRIu64" bytes, %"PRIu64" evictions\n",
+                  ctx->res_cache_entries, ctx->res_cache_bytes, ctx->res_cache_evictions);
+        ctx->hits = ctx->misses = ctx->compressed_hits = ctx->compressed_misses = 0;
+        ctx->cache_evictions = ctx->res_cache_evictions = 0;
+    }
     if (ctx->PathSegments != NULL) {
         gs_free_object(ctx->memory, ctx->PathSegments, "pdfi_clear_context");
         ctx->PathSegments = NULL;
@@ -2157,6 +2513,7 @@ int pdfi_clear_context(pdf_context *ctx)
     pdfi_free_cstring_array(ctx, &ctx->args.preserveannottypes);
 
     pdfi_doc_page_array_free(ctx);
+    pdfi_check_free_memo(ctx);
 
     if (ctx->xref_table) {
         pdfi_countdown(ctx->xref_table);
@@ -2207,6 +2564,7 @@ int pdfi_clear_context(pdf_context *ctx)
         ctx->encryption.Password = NULL;
     }
 
+    pdfi_merge_obj_cache_pools(ctx);
     if (ctx->cache_entries != 0) {
         pdf_obj_cache_entry *entry = ctx->cache_LRU, *next;
 
@@ -2267,7 +2625,9 @@ int pdfi_clear_context(pdf_context *ctx)
 #endif
         ctx->cache_LRU = ctx->cache_MRU = NULL;
         ctx->cache_entries = 0;
+        ctx->cache_bytes = 0;
     }
+    pdfi_free_objstm_cache(ctx);
 
     /* We can't free the font directory before the graphics library fonts fonts are freed, as they reference the font_dir.
      * graphics library fonts are refrenced from pdf_font objects, and those may be in the cache, which means they
@@ -2330,6 +2690,8 @@ int pdfi_free_context(pdf_context *ctx)
     }
     rc_decrement(ctx->devbbox, "pdfi_free_context");
 
+    pdfi_free_num_pool(ctx);
+
     gs_free_object(ctx->memory, ctx, "pdfi_free_context");
 #if PDFI_LEAK_CHECK
     gs_memory_status(mem, &mstat);
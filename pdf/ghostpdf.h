@@ -124,7 +124,7 @@ typedef struct name_entry_s {
     char *name;
     int len;
     unsigned int index;
-    void *next;
+    struct name_entry_s *next;  /* Next entry in the same hash bucket */
 } pdfi_name_entry_t;
 
 typedef struct cmd_args_s {
@@ -175,6 +175,9 @@ typedef struct cmd_args_s {
     bool ignoretounicode;
     bool nonativefontmap;
     int  PDFCacheSize;
+    int  PDFCacheBytes;
+    bool PDFCacheStats;
+    bool PDFProgressive;        /* -dPDFProgressive, render the first page of linearized input early */
 } cmd_args_t;
 
 typedef struct encryption_state_s {
@@ -435,6 +438,11 @@ typedef struct pdf_context_s
     bool repaired;
     /* Repairing is true while the repair code is running, during this we ignore errors and warnings */
     bool repairing;
+    /* True while we render the first page of a linearized file before the rest of the file
+     * has arrived (see pdfi_process_linearized_first_page). Only the first page cross-reference
+     * section is available so we mustn't follow its /Prev, or try to repair the file.
+     */
+    bool first_page_only;
 
     /* The HeaderVersion is the declared version from the PDF header, but this
      * can be overridden by later trailer dictionaries, so the FinalVersion is
@@ -455,6 +463,12 @@ typedef struct pdf_context_s
     pdf_dict *PagesTree;
     uint64_t num_pages;
     uint32_t *page_array; /* cache of page dict object_num's for pdfmark Dest */
+    pdf_dict **page_inherited; /* Inherited keys for each page in page_array, see pdfi_get_page_dict() */
+    /* Where the last walk of the Pages tree found its page, see pdfi_page_index_resume() */
+    pdf_array *page_resume_Kids;
+    pdf_dict *page_resume_inherited;
+    int page_resume_index;      /* The entry in page_resume_Kids after the page found */
+    uint64_t page_resume_page;  /* and its page number */
     pdf_dict *AcroForm;
     bool NeedAppearances; /* From AcroForm, if any */
 
@@ -464,10 +478,29 @@ typedef struct pdf_context_s
     pdf_obj **stack_top;
     pdf_obj **stack_limit;
 
-    /* The object cache */
+    /* Released number objects kept for reuse, see pdfi_object_alloc() */
+    pdf_num *num_free_list;
+    uint32_t num_free_count;
+
+    /* The object cache, general and resource pools (see pdf_deref.c) */
     uint32_t cache_entries;
     pdf_obj_cache_entry *cache_LRU;
     pdf_obj_cache_entry *cache_MRU;
+    uint64_t cache_bytes;
+    uint32_t res_cache_entries;
+    pdf_obj_cache_entry *res_cache_LRU;
+    pdf_obj_cache_entry *res_cache_MRU;
+    uint64_t res_cache_bytes;
+
+    /* Decoded object streams, most recently used first */
+    pdfi_objstm *objstm_cache;
+    uint32_t objstm_cache_entries;
+    uint64_t objstm_cache_bytes;
+
+    /* Results of checking shared page Resources, by object number (see pdf_check.c) */
+    pdfi_check_memo *check_memo;
+    uint32_t check_memo_size;
+    uint32_t check_memo_entries;
 
     /* The loop detection state */
     uint32_t loop_detection_size;
@@ -488,8 +521,11 @@ typedef struct pdf_context_s
     pdf_stream *current_stream;
     stream_save current_stream_save;
 
-    /* A name table :-( */
-    pdfi_name_entry_t *name_table;
+    /* A name table :-( See pdfi_get_name_index() */
+    pdfi_name_entry_t **name_table;     /* Hash buckets, name_index_size of them */
+    pdfi_name_entry_t **name_index;     /* Entries in index order */
+    uint32_t name_index_size;
+    uint32_t name_entries;
 
     gs_string *fontmapfiles;
     int num_fontmapfiles;
@@ -514,12 +550,13 @@ typedef struct pdf_context_s
 #if REFCNT_DEBUG
     uint64_t ref_UID;
 #endif
-#if CACHE_STATISTICS
+    /* Object cache statistics, reported if PDFCACHESTATS is set */
     uint64_t hits;
     uint64_t misses;
     uint64_t compressed_hits;
     uint64_t compressed_misses;
-#endif
+    uint64_t cache_evictions;
+    uint64_t res_cache_evictions;
 #if PDFI_LEAK_CHECK
     gs_memory_status_t memstat;
 #endif
@@ -542,6 +579,20 @@ int pdfi_separation_name_from_index(gs_gstate *pgs, gs_separation_name index, un
 int pdfi_open_pdf_file(pdf_context *ctx, char *filename);
 int pdfi_set_input_stream(pdf_context *ctx, stream *stm);
 int pdfi_process_pdf_file(pdf_context *ctx, char *filename);
+
+/* The values from a linearization dictionary which we need in order to render the
+ * first page before the rest of the file has arrived.
+ */
+typedef struct pdfi_linearized_s {
+    gs_offset_t length;             /* /L, the length of the whole file */
+    gs_offset_t first_page_end;     /* /E, the end of the first page section */
+    gs_offset_t first_page_xref;    /* offset of the first page cross-reference section */
+    uint32_t first_page_obj;        /* /O, the object number of the first page */
+    uint64_t num_pages;             /* /N */
+} pdfi_linearized_t;
+
+int pdfi_read_linearized_header(pdf_context *ctx, const byte *Buffer, int bytes, pdfi_linearized_t *info);
+int pdfi_process_linearized_first_page(pdf_context *ctx, char *filename, pdfi_linearized_t *info);
 int pdfi_prep_collection(pdf_context *ctx, uint64_t *TotalFiles, char ***names_array);
 int pdfi_finish_pdf_file(pdf_context *ctx);
 int pdfi_close_pdf_file(pdf_context *ctx);
@@ -626,8 +677,6 @@ int pdfi_set_warning_var(pdf_context *ctx, int gs_error, const char *gs_lib_func
 
 #define PURGE_CACHE_PER_PAGE 0
 
-#if PURGE_CACHE_PER_PAGE
 void pdfi_purge_obj_cache(pdf_context *ctx);
-#endif
 
 #endif
@@ -165,6 +165,155 @@ cleanup:
     return code;
 }
 
+/* Catalogue style files often have thousands of pages which all share a single Resources
+ * dictionary, and we would check it again for every page. So we remember, by object number,
+ * what checking a page's Resources found and reuse that for later pages.
+ *
+ * A page's Resources are always checked from the same starting state (nothing found yet,
+ * the CheckedResources flags clear) so the result depends only on the dictionary and on
+ * whether we are looking for spot colours; the memo is only valid for the same setting.
+ * We don't use the memo when collecting the fonts used (which is a per-page list anyway)
+ * nor for pages with annotations; those are checked after the Resources and rely on
+ * CheckedResources to skip objects the Resources check has already dealt with.
+ */
+struct pdfi_check_memo_s {
+    uint32_t object_num;        /* 0 for an unused slot */
+    bool spot_check;
+    bool transparent;
+    bool BM_Not_Normal;
+    bool has_overprint;
+    pdf_array *spots;           /* Spot colour names found, in the order they were found */
+};
+
+void pdfi_check_free_memo(pdf_context *ctx)
+{
+    uint32_t i;
+
+    if (ctx->check_memo == NULL)
+        return;
+
+    for (i = 0; i < ctx->check_memo_size; i++)
+        pdfi_countdown(ctx->check_memo[i].spots);
+    gs_free_object(ctx->memory, ctx->check_memo, "pdfi_check_free_memo");
+    ctx->check_memo = NULL;
+    ctx->check_memo_size = ctx->check_memo_entries = 0;
+}
+
+/* The table is open addressed and never more than half full */
+static pdfi_check_memo *pdfi_check_memo_slot(pdfi_check_memo *table, uint32_t size, uint32_t object_num)
+{
+    uint32_t i = (object_num * 2654435761U) & (size - 1);
+
+    while (table[i].object_num != 0 && table[i].object_num != object_num)
+        i = (i + 1) & (size - 1);
+    return &table[i];
+}
+
+static pdfi_check_memo *pdfi_check_memo_find(pdf_context *ctx, uint32_t object_num)
+{
+    pdfi_check_memo *m;
+
+    if (ctx->check_memo == NULL)
+        return NULL;
+
+    m = pdfi_check_memo_slot(ctx->check_memo, ctx->check_memo_size, object_num);
+    return m->object_num == 0 ? NULL : m;
+}
+
+static int pdfi_check_memo_grow(pdf_context *ctx)
+{
+    pdfi_check_memo *new_table;
+    uint32_t i, new_size = ctx->check_memo_size == 0 ? 64 : ctx->check_memo_size * 2;
+
+    if (new_size < ctx->check_memo_size)
+        return_error(gs_error_limitcheck);
+
+    new_table = (pdfi_check_memo *)gs_alloc_bytes(ctx->memory, (size_t)new_size * sizeof(pdfi_check_memo), "pdfi_check_memo_grow");
+    if (new_table == NULL)
+        return_error(gs_error_VMerror);
+    memset(new_table, 0x00, (size_t)new_size * sizeof(pdfi_check_memo));
+
+    for (i = 0; i < ctx->check_memo_size; i++) {
+        if (ctx->check_memo[i].object_num != 0)
+            *pdfi_check_memo_slot(new_table, new_size, ctx->check_memo[i].object_num) = ctx->check_memo[i];
+    }
+    gs_free_object(ctx->memory, ctx->check_memo, "pdfi_check_memo_grow");
+    ctx->check_memo = new_table;
+    ctx->check_memo_size = new_size;
+    return 0;
+}
+
+static int pdfi_check_memo_add(pdf_context *ctx, uint32_t object_num, pdfi_check_tracker_t *result)
+{
+    pdfi_check_memo *m;
+    pdf_array *spots = NULL;
+    int code;
+
+    if (result->spot_dict != NULL && pdfi_dict_entries(result->spot_dict) > 0) {
+        pdf_obj *Key = NULL, *Value = NULL;
+        uint64_t index = 0, i = 0;
+
+        code = pdfi_array_alloc(ctx, pdfi_dict_entries(result->spot_dict), &spots);
+        if (code < 0)
+            return code;
+        pdfi_countup(spots);
+
+        code = pdfi_dict_first(ctx, result->spot_dict, &Key, &Value, &index);
+        while (code >= 0) {
+            code = pdfi_array_put(ctx, spots, i++, Key);
+            pdfi_countdown(Key);
+            pdfi_countdown(Value);
+            Key = Value = NULL;
+            if (code < 0)
+                break;
+            code = pdfi_dict_next(ctx, result->spot_dict, &Key, &Value, &index);
+        }
+        if (code < 0 && code != gs_error_undefined) {
+            pdfi_countdown(spots);
+            return code;
+        }
+    }
+
+    m = pdfi_check_memo_find(ctx, object_num);
+    if (m == NULL) {
+        if ((ctx->check_memo_entries + 1) * 2 > ctx->check_memo_size) {
+            code = pdfi_check_memo_grow(ctx);
+            if (code < 0) {
+                pdfi_countdown(spots);
+                return code;
+            }
+        }
+        m = pdfi_check_memo_slot(ctx->check_memo, ctx->check_memo_size, object_num);
+        m->object_num = object_num;
+        ctx->check_memo_entries++;
+    } else
+        pdfi_countdown(m->spots);
+
+    m->spot_check = result->spot_dict != NULL;
+    m->transparent = result->transparent;
+    m->BM_Not_Normal = result->BM_Not_Normal;
+    m->has_overprint = result->has_overprint;
+    m->spots = spots;
+    return 0;
+}
+
+static int pdfi_check_add_spot(pdf_context *ctx, pdf_dict *spot_dict, pdf_obj *name)
+{
+    bool known = false;
+    pdf_obj *dummy;
+    int code;
+
+    code = pdfi_dict_known_by_key(ctx, spot_dict, (pdf_name *)name, &known);
+    if (code < 0 || known)
+        return code;
+
+    code = pdfi_object_alloc(ctx, PDF_INT, 0, &dummy);
+    if (code < 0)
+        return code;
+
+    return pdfi_dict_put_obj(ctx, spot_dict, name, dummy, true);
+}
+
 /*
  * Check the Resources dictionary ColorSpace entry. pdfi_check_ColorSpace_for_spots is defined
  * in pdf_colour.c
@@ -1458,6 +1607,87 @@ exit:
     return code;
 }
 
+/* Check a page's Resources dictionary, using or recording the result in ctx->check_memo
+ * where we can (see pdfi_check_memo_s above).
+ */
+static int pdfi_check_page_Resources(pdf_context *ctx, pdf_dict *Resources, pdf_dict *page_dict,
+                                     pdfi_check_tracker_t *tracker)
+{
+    pdfi_check_tracker_t sub;
+    pdfi_check_memo *m;
+    bool known = false;
+    uint64_t i;
+    int code;
+
+    if (pdf_object_num((pdf_obj *)Resources) == 0 || tracker->font_array != NULL)
+        return pdfi_check_Resources(ctx, Resources, page_dict, tracker);
+
+    if (ctx->args.showannots) {
+        code = pdfi_dict_known(ctx, page_dict, "Annots", &known);
+        if (code < 0 || known)
+            return pdfi_check_Resources(ctx, Resources, page_dict, tracker);
+    }
+
+    m = pdfi_check_memo_find(ctx, Resources->object_num);
+    if (m != NULL && m->spot_check == (tracker->spot_dict != NULL)) {
+        tracker->transparent |= m->transparent;
+        tracker->BM_Not_Normal |= m->BM_Not_Normal;
+        tracker->has_overprint |= m->has_overprint;
+        if (m->spots != NULL) {
+            for (i = 0; i < pdfi_array_size(m->spots); i++) {
+                code = pdfi_check_add_spot(ctx, tracker->spot_dict, m->spots->values[i]);
+                if (code < 0)
+                    return code;
+            }
+        }
+        return 0;
+    }
+
+    /* Check the Resources with a tracker of our own, so that we can tell what they
+     * contributed. The spot dictionary may already have colorants from the page Group.
+     */
+    sub = *tracker;
+    sub.transparent = sub.BM_Not_Normal = sub.has_overprint = false;
+    sub.spot_dict = NULL;
+    if (tracker->spot_dict != NULL) {
+        code = pdfi_dict_alloc(ctx, 32, &sub.spot_dict);
+        if (code < 0)
+            return code;
+        pdfi_countup(sub.spot_dict);
+    }
+
+    code = pdfi_check_Resources(ctx, Resources, page_dict, &sub);
+
+    tracker->transparent |= sub.transparent;
+    tracker->BM_Not_Normal |= sub.BM_Not_Normal;
+    tracker->has_overprint |= sub.has_overprint;
+    if (sub.spot_dict != NULL) {
+        pdf_obj *Key = NULL, *Value = NULL;
+        uint64_t index = 0;
+        int code1;
+
+        code1 = pdfi_dict_first(ctx, sub.spot_dict, &Key, &Value, &index);
+        while (code1 >= 0) {
+            code1 = pdfi_check_add_spot(ctx, tracker->spot_dict, Key);
+            pdfi_countdown(Key);
+            pdfi_countdown(Value);
+            Key = Value = NULL;
+            if (code1 < 0)
+                break;
+            code1 = pdfi_dict_next(ctx, sub.spot_dict, &Key, &Value, &index);
+        }
+        if (code1 < 0 && code1 != gs_error_undefined && code >= 0)
+            code = code1;
+    }
+
+    /* Failing to remember the result isn't an error, we'll just check again next time */
+    if (code >= 0)
+        (void)pdfi_check_memo_add(ctx, Resources->object_num, &sub);
+
+    pdfi_countdown(sub.spot_dict);
+    return code;
+}
+
 /* Check for transparency and spots on page.
  *
  * Sets ctx->spot_capable_device
@@ -1509,7 +1739,7 @@ static int pdfi_check_page_inner(pdf_context *ctx, pdf_dict *page_dict,
     /* Now check any Resources dictionary in the Page dictionary */
     code = pdfi_dict_knownget_type(ctx, page_dict, "Resources", PDF_DICT, (pdf_obj **)&Resources);
     if (code > 0)
-        code = pdfi_check_Resources(ctx, Resources, page_dict, tracker);
+        code = pdfi_check_page_Resources(ctx, Resources, page_dict, tracker);
 
     if (code == gs_error_pdf_stackoverflow || (code < 0 &&
        (code = pdfi_set_error_stop(ctx, code, NULL, E_PDF_GS_LIB_ERROR, "pdfi_check_page_inner", "")) < 0)) {
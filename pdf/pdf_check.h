@@ -17,6 +17,7 @@
 #define PDF_CHECK
 
 int pdfi_check_page(pdf_context *ctx, pdf_dict *page_dict, pdf_array **fonts_array, pdf_array **spots_array, bool do_setup);
+void pdfi_check_free_memo(pdf_context *ctx);
 
 int pdfi_check_Pattern_transparency(pdf_context *ctx, pdf_dict *pattern,
                                     pdf_dict *page_dict, bool *transparent, bool *BM_Not_Normal);
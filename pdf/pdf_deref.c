@@ -37,18 +37,178 @@
  */
 /*#define DISABLE CACHE*/
 
-/* given an object, create a cache entry for it. If we have too many entries
- * then delete the leat-recently-used cache entry. Make the new entry be the
- * most-recently-used entry. The actual entries are attached to the xref table
- * (as well as being a double-linked list), because we detect an existing
- * cache entry by seeing that the xref table for the object number has a non-NULL
- * 'cache' member.
+/* The cache is split into two pools, each a double-linked list running from
+ * least to most-recently-used. Resources (fonts, CMaps and anything found through
+ * a Resources dictionary) go into one pool, everything else (page tree nodes,
+ * content streams, annotations...) into the other. When we need to make room we
+ * evict from the general pool first, so that a long run of pages each with their
+ * own content does not push out fonts and ExtGStates shared by all of them. The
+ * resource pool is only allowed to grow to PDFI_CACHE_RESOURCE_SHARE percent of
+ * the cache, beyond that it loses its own LRU entries.
+ *
+ * The size of the cache is either a count of objects (PDFCACHE) or, if PDFCACHEBYTES
+ * is set, an (estimated) number of bytes.
+ */
+#define PDFI_CACHE_RESOURCE_SHARE 75
+
+/* Fonts and CMaps hold a good deal of memory in the graphics library which we can't
+ * easily measure, use a fixed estimate for those.
+ */
+#define PDFI_CACHE_FONT_SIZE (64 * 1024)
+#define PDFI_CACHE_CMAP_SIZE (16 * 1024)
+
+/* A rough estimate of the memory used by an object in the cache. This does not descend
+ * into arrays or dictionaries, we simply assume each direct member is about the size of
+ * a number. Indirectly referenced members are cached (and counted) separately.
+ */
+static uint32_t pdfi_obj_cache_size(pdf_obj *o)
+{
+    uint64_t size;
+
+    switch (pdfi_type_of(o)) {
+        case PDF_STRING:
+            size = sizeof(pdf_string) + ((pdf_string *)o)->length;
+            break;
+        case PDF_NAME:
+            size = sizeof(pdf_name) + ((pdf_name *)o)->length;
+            break;
+        case PDF_BUFFER:
+            size = sizeof(pdf_buffer) + ((pdf_buffer *)o)->length;
+            break;
+        case PDF_ARRAY:
+            size = sizeof(pdf_array) + ((pdf_array *)o)->size * (sizeof(pdf_obj *) + sizeof(pdf_num));
+            break;
+        case PDF_DICT:
+            size = sizeof(pdf_dict) + ((pdf_dict *)o)->size * (sizeof(pdf_dict_entry) + 2 * sizeof(pdf_num))
+                   + ((pdf_dict *)o)->hash_size * sizeof(uint32_t);
+            break;
+        case PDF_STREAM:
+            size = sizeof(pdf_stream);
+            if (((pdf_stream *)o)->stream_dict != NULL)
+                size += pdfi_obj_cache_size((pdf_obj *)((pdf_stream *)o)->stream_dict);
+            break;
+        case PDF_FONT:
+            size = PDFI_CACHE_FONT_SIZE;
+            break;
+        case PDF_CMAP:
+            size = PDFI_CACHE_CMAP_SIZE;
+            break;
+        default:
+            size = sizeof(pdf_num);
+            break;
+    }
+    size += sizeof(pdf_obj_cache_entry);
+    return size > max_uint ? max_uint : (uint32_t)size;
+}
+
+static inline bool pdfi_obj_is_resource_type(pdf_obj *o)
+{
+    return pdfi_type_of(o) == PDF_FONT || pdfi_type_of(o) == PDF_CMAP;
+}
+
+/* Remove an entry from whichever pool it is in, leaving the xref alone */
+static void pdfi_cache_unlink(pdf_context *ctx, pdf_obj_cache_entry *entry)
+{
+    pdf_obj_cache_entry **LRU = entry->resource ? &ctx->res_cache_LRU : &ctx->cache_LRU;
+    pdf_obj_cache_entry **MRU = entry->resource ? &ctx->res_cache_MRU : &ctx->cache_MRU;
+
+    if (entry->previous != NULL)
+        ((pdf_obj_cache_entry *)entry->previous)->next = entry->next;
+    else
+        *LRU = entry->next;
+    if (entry->next != NULL)
+        ((pdf_obj_cache_entry *)entry->next)->previous = entry->previous;
+    else
+        *MRU = entry->previous;
+    entry->next = entry->previous = NULL;
+
+    if (entry->resource) {
+        ctx->res_cache_entries--;
+        ctx->res_cache_bytes -= entry->size;
+    } else {
+        ctx->cache_entries--;
+        ctx->cache_bytes -= entry->size;
+    }
+}
+
+/* Add an entry to its pool as the most-recently-used */
+static void pdfi_cache_link(pdf_context *ctx, pdf_obj_cache_entry *entry)
+{
+    pdf_obj_cache_entry **LRU = entry->resource ? &ctx->res_cache_LRU : &ctx->cache_LRU;
+    pdf_obj_cache_entry **MRU = entry->resource ? &ctx->res_cache_MRU : &ctx->cache_MRU;
+
+    entry->next = NULL;
+    entry->previous = *MRU;
+    if (*MRU != NULL)
+        (*MRU)->next = entry;
+    *MRU = entry;
+    if (*LRU == NULL)
+        *LRU = entry;
+
+    if (entry->resource) {
+        ctx->res_cache_entries++;
+        ctx->res_cache_bytes += entry->size;
+    } else {
+        ctx->cache_entries++;
+        ctx->cache_bytes += entry->size;
+    }
+}
+
+/* Is there room for another object of 'size' bytes ? */
+static bool pdfi_cache_is_full(pdf_context *ctx, uint32_t size)
+{
+    if (ctx->args.PDFCacheBytes > 0)
+        return ctx->cache_bytes + ctx->res_cache_bytes + size > (uint64_t)ctx->args.PDFCacheBytes;
+
+    return (int64_t)ctx->cache_entries + ctx->res_cache_entries >= ctx->args.PDFCacheSize;
+}
+
+/* Choose the entry to throw out when the cache is full */
+static pdf_obj_cache_entry *pdfi_cache_victim(pdf_context *ctx)
+{
+    if (ctx->res_cache_LRU != NULL) {
+        if (ctx->cache_LRU == NULL)
+            return ctx->res_cache_LRU;
+
+        if (ctx->args.PDFCacheBytes > 0) {
+            if (ctx->res_cache_bytes * 100 > (uint64_t)ctx->args.PDFCacheBytes * PDFI_CACHE_RESOURCE_SHARE)
+                return ctx->res_cache_LRU;
+        } else {
+            if ((int64_t)ctx->res_cache_entries * 100 > (int64_t)ctx->args.PDFCacheSize * PDFI_CACHE_RESOURCE_SHARE)
+                return ctx->res_cache_LRU;
+        }
+    }
+    return ctx->cache_LRU;
+}
+
+static void pdfi_cache_evict(pdf_context *ctx, pdf_obj_cache_entry *entry)
+{
+#if DEBUG_CACHE
+    dbgmprintf2(ctx->memory, "Evicting %d from the %s pool\n", entry->o->object_num, entry->resource ? "resource" : "general");
+#endif
+    pdfi_cache_unlink(ctx, entry);
+    if (entry->resource)
+        ctx->res_cache_evictions++;
+    else
+        ctx->cache_evictions++;
+    ctx->xref_table->xref[entry->o->object_num].cache = NULL;
+    pdfi_countdown(entry->o);
+    gs_free_object(ctx->memory, entry, "pdfi_add_to_cache, free LRU");
+}
+
+/* given an object, create a cache entry for it. If the cache is full then delete
+ * least-recently-used cache entries (see pdfi_cache_victim) until there is room.
+ * Make the new entry be the most-recently-used entry of its pool. The actual entries
+ * are attached to the xref table (as well as being a double-linked list), because we
+ * detect an existing cache entry by seeing that the xref table for the object number
+ * has a non-NULL 'cache' member.
  * So we need to update the xref as well if we add or delete cache entries.
  */
 static int pdfi_add_to_cache(pdf_context *ctx, pdf_obj *o)
 {
 #ifndef DISABLE_CACHE
     pdf_obj_cache_entry *entry;
+    uint32_t size;
 
     if (o < PDF_TOKEN_AS_OBJ(TOKEN__LAST_KEY))
         return 0;
@@ -66,25 +226,16 @@ static int pdfi_add_to_cache(pdf_context *ctx, pdf_obj *o)
 #if DEBUG_CACHE
         dbgmprintf1(ctx->memory, "Adding object %d\n", o->object_num);
 #endif
-    if (ctx->cache_entries == ctx->args.PDFCacheSize)
-    {
-#if DEBUG_CACHE
-        dbgmprintf(ctx->memory, "Cache full, evicting LRU\n");
-#endif
-        if (ctx->cache_LRU) {
-            entry = ctx->cache_LRU;
-#if DEBUG_CACHE
-            dbgmprintf1(ctx->memory, "Evicting %d\n", entry->o->object_num);
-#endif
-            ctx->cache_LRU = entry->next;
-            if (entry->next)
-                ((pdf_obj_cache_entry *)entry->next)->previous = NULL;
-            ctx->xref_table->xref[entry->o->object_num].cache = NULL;
-            pdfi_countdown(entry->o);
-            ctx->cache_entries--;
-            gs_free_object(ctx->memory, entry, "pdfi_add_to_cache, free LRU");
-        } else
-            return_error(gs_error_unknownerror);
+    size = pdfi_obj_cache_size(o);
+    while (pdfi_cache_is_full(ctx, size)) {
+        entry = pdfi_cache_victim(ctx);
+        if (entry == NULL) {
+            /* Nothing left to evict and still no room; the object is simply
+             * larger than the whole cache, so don't cache it.
+             */
+            return 0;
+        }
+        pdfi_cache_evict(ctx, entry);
     }
     entry = (pdf_obj_cache_entry *)gs_alloc_bytes(ctx->memory, sizeof(pdf_obj_cache_entry), "pdfi_add_to_cache");
     if (entry == NULL)
@@ -93,42 +244,25 @@ static int pdfi_add_to_cache(pdf_context *ctx, pdf_obj *o)
     memset(entry, 0x00, sizeof(pdf_obj_cache_entry));
 
     entry->o = o;
+    entry->size = size;
+    entry->resource = pdfi_obj_is_resource_type(o);
     pdfi_countup(o);
-    if (ctx->cache_MRU) {
-        entry->previous = ctx->cache_MRU;
-        ctx->cache_MRU->next = entry;
-    }
-    ctx->cache_MRU = entry;
-    if (ctx->cache_LRU == NULL)
-        ctx->cache_LRU = entry;
+    pdfi_cache_link(ctx, entry);
 
-    ctx->cache_entries++;
     ctx->xref_table->xref[o->object_num].cache = entry;
 #endif
     return 0;
 }
 
 /* Given an existing cache entry, promote it to be the most-recently-used
- * cache entry.
+ * cache entry of its pool.
  */
 static void pdfi_promote_cache_entry(pdf_context *ctx, pdf_obj_cache_entry *cache_entry)
 {
 #ifndef DISABLE_CACHE
-    if (ctx->cache_MRU && cache_entry != ctx->cache_MRU) {
-        if ((pdf_obj_cache_entry *)cache_entry->next != NULL)
-            ((pdf_obj_cache_entry *)cache_entry->next)->previous = cache_entry->previous;
-        if ((pdf_obj_cache_entry *)cache_entry->previous != NULL)
-            ((pdf_obj_cache_entry *)cache_entry->previous)->next = cache_entry->next;
-        else {
-            /* the existing entry is the current least recently used, we need to make the 'next'
-             * cache entry into the LRU.
-             */
-            ctx->cache_LRU = cache_entry->next;
-        }
-        cache_entry->next = NULL;
-        cache_entry->previous = ctx->cache_MRU;
-        ctx->cache_MRU->next = cache_entry;
-        ctx->cache_MRU = cache_entry;
+    if (cache_entry->next != NULL) {
+        pdfi_cache_unlink(ctx, cache_entry);
+        pdfi_cache_link(ctx, cache_entry);
     }
 #endif
     return;
@@ -145,6 +279,57 @@ int pdfi_cache_object(pdf_context *ctx, pdf_obj *o)
     return 0;
 }
 
+/* Called when an object has been found as a named resource. If the object is cached
+ * move it to the resource pool, so it will survive longer than per-page objects.
+ */
+void pdfi_cache_mark_resource(pdf_context *ctx, pdf_obj *o)
+{
+#ifndef DISABLE_CACHE
+    pdf_obj_cache_entry *cache_entry;
+
+    if (o < PDF_TOKEN_AS_OBJ(TOKEN__LAST_KEY) || o->object_num == 0)
+        return;
+    if (ctx->xref_table == NULL || o->object_num >= ctx->xref_table->xref_size)
+        return;
+
+    cache_entry = ctx->xref_table->xref[o->object_num].cache;
+    if (cache_entry == NULL || cache_entry->o != o)
+        return;
+
+    pdfi_cache_unlink(ctx, cache_entry);
+    cache_entry->resource = true;
+    pdfi_cache_link(ctx, cache_entry);
+#endif
+}
+
+/* Move all the resource pool entries onto the end of the general pool, leaving just
+ * the one list. Used when emptying the cache, so that code only has to walk
+ * ctx->cache_LRU.
+ */
+void pdfi_merge_obj_cache_pools(pdf_context *ctx)
+{
+    pdf_obj_cache_entry *entry = ctx->res_cache_LRU;
+
+    if (entry == NULL)
+        return;
+
+    for (; entry != NULL; entry = entry->next)
+        entry->resource = false;
+
+    ctx->res_cache_LRU->previous = ctx->cache_MRU;
+    if (ctx->cache_MRU != NULL)
+        ctx->cache_MRU->next = ctx->res_cache_LRU;
+    else
+        ctx->cache_LRU = ctx->res_cache_LRU;
+    ctx->cache_MRU = ctx->res_cache_MRU;
+    ctx->cache_entries += ctx->res_cache_entries;
+    ctx->cache_bytes += ctx->res_cache_bytes;
+
+    ctx->res_cache_LRU = ctx->res_cache_MRU = NULL;
+    ctx->res_cache_entries = 0;
+    ctx->res_cache_bytes = 0;
+}
+
 /* This one's a bit of an oddity, its used for fonts. When we build a PDF font object
  * we want the object cache to reference *that* object, not the dictionary which was
  * read out of the PDF file, so this allows us to replace the font dictionary in the
@@ -174,13 +359,30 @@ int replace_cache_entry(pdf_context *ctx, pdf_obj *o)
         if (cache_entry->o != NULL)
             old_cached_obj = cache_entry->o;
 
-        /* Put new entry in the cache */
+        /* Put new entry in the cache, its size (and possibly its pool) will
+         * have changed, so take it out of the list and put it back.
+         */
+        pdfi_cache_unlink(ctx, cache_entry);
         cache_entry->o = o;
+        cache_entry->size = pdfi_obj_cache_size(o);
+        if (pdfi_obj_is_resource_type(o))
+            cache_entry->resource = true;
         pdfi_countup(o);
-        pdfi_promote_cache_entry(ctx, cache_entry);
+        pdfi_cache_link(ctx, cache_entry);
 
         /* Now decrement the old cache entry, if any */
         pdfi_countdown(old_cached_obj);
+
+        /* The replacement is usually larger, trim the cache back to size
+         * (but don't throw out the object we just put in).
+         */
+        while (ctx->args.PDFCacheBytes > 0 && pdfi_cache_is_full(ctx, 0)) {
+            pdf_obj_cache_entry *victim = pdfi_cache_victim(ctx);
+
+            if (victim == NULL || victim == cache_entry)
+                break;
+            pdfi_cache_evict(ctx, victim);
+        }
     }
 #endif
     return 0;
@@ -626,19 +828,226 @@ static int pdfi_read_object(pdf_context *ctx, pdf_c_stream *s, gs_offset_t strea
     return pdfi_read_bare_object(ctx, s, stream_offset, objnum, gen);
 }
 
+/* Decoded object streams.
+ * Reading a compressed object used to mean seeking to its ObjStm, setting up the
+ * decode filters and parsing the table of object numbers and offsets all over
+ * again, for every object in the stream. Instead we decode each ObjStm once into
+ * memory, parse its table once, and keep a small number of these around (most
+ * recently used first) for subsequent objects.
+ */
+#define OBJSTM_CACHE_MAX_ENTRIES 16
+#define OBJSTM_CACHE_MAX_BYTES (32 * 1024 * 1024)
+
+struct pdfi_objstm_s {
+    pdfi_objstm *next;
+    uint64_t object_num;
+    gs_offset_t stream_offset;
+    int64_t Length;
+    int64_t First;
+    int64_t num_entries;
+    int *index;         /* num_entries pairs of object number and offset */
+    byte *data;         /* The decoded stream */
+    uint64_t length;
+    bool cached;        /* false if the decode failed part way */
+};
+
+static void pdfi_free_objstm(pdf_context *ctx, pdfi_objstm *objstm)
+{
+    gs_free_object(ctx->memory, objstm->index, "pdfi_free_objstm (index)");
+    gs_free_object(ctx->memory, objstm->data, "pdfi_free_objstm (data)");
+    gs_free_object(ctx->memory, objstm, "pdfi_free_objstm");
+}
+
+void pdfi_free_objstm_cache(pdf_context *ctx)
+{
+    pdfi_objstm *objstm = ctx->objstm_cache, *next;
+
+    while (objstm != NULL) {
+        next = objstm->next;
+        pdfi_free_objstm(ctx, objstm);
+        objstm = next;
+    }
+    ctx->objstm_cache = NULL;
+    ctx->objstm_cache_entries = 0;
+    ctx->objstm_cache_bytes = 0;
+}
+
+/* Read the whole of the (filtered) ObjStm into memory */
+static int pdfi_decode_objstm(pdf_context *ctx, pdf_stream *compressed_object, pdfi_objstm *objstm)
+{
+    pdf_c_stream *SubFile_stream = NULL, *compressed_stream = NULL;
+    uint64_t size = 0, initial_size;
+    int64_t avail;
+    byte *data;
+    uint read;
+    int status, code;
+
+    /* Start by guessing at 4 times the compressed size, but don't believe a
+     * /Length that runs past the end of the file. The buffer is doubled as
+     * needed. */
+    avail = ctx->main_stream_length - objstm->stream_offset;
+    if (avail > objstm->Length)
+        avail = objstm->Length;
+    initial_size = avail > 1024 ? (uint64_t)avail * 4 : 4096;
+
+    code = pdfi_seek(ctx, ctx->main_stream, objstm->stream_offset, SEEK_SET);
+    if (code < 0)
+        return code;
+
+    code = pdfi_apply_SubFileDecode_filter(ctx, objstm->Length, NULL, ctx->main_stream, &SubFile_stream, false);
+    if (code < 0)
+        return code;
+
+    code = pdfi_filter(ctx, compressed_object, SubFile_stream, &compressed_stream, false);
+    if (code < 0) {
+        pdfi_close_file(ctx, SubFile_stream);
+        return code;
+    }
+
+    do {
+        if (objstm->length == size) {
+            size = size == 0 ? initial_size : size * 2;
+            if (size > max_uint) {
+                code = gs_note_error(gs_error_limitcheck);
+                break;
+            }
+            data = gs_alloc_bytes(ctx->memory, size, "pdfi_decode_objstm (data)");
+            if (data == NULL) {
+                code = gs_note_error(gs_error_VMerror);
+                break;
+            }
+            if (objstm->length != 0)
+                memcpy(data, objstm->data, objstm->length);
+            gs_free_object(ctx->memory, objstm->data, "pdfi_decode_objstm (data)");
+            objstm->data = data;
+        }
+        status = sgets(compressed_stream->s, objstm->data + objstm->length, size - objstm->length, &read);
+        objstm->length += read;
+    } while (status == 0 && read != 0);
+
+    /* If the filter failed, what was decoded before the error can still be
+     * used, as it could when each object was read from the stream directly,
+     * but it isn't kept. */
+    if (code >= 0 && status == ERRC)
+        code = pdfi_set_error_stop(ctx, gs_note_error(gs_error_ioerror), "sgets", E_PDF_BADSTREAM, "pdfi_decode_objstm", NULL);
+    else
+        objstm->cached = true;
+
+    pdfi_close_file(ctx, compressed_stream);
+    pdfi_close_file(ctx, SubFile_stream);
+    return code;
+}
+
+/* Parse the table of object numbers and offsets at the start of the ObjStm */
+static int pdfi_read_objstm_index(pdf_context *ctx, pdfi_objstm *objstm)
+{
+    pdf_c_stream *stream = NULL;
+    int64_t i;
+    int code;
+
+    objstm->index = (int *)gs_alloc_bytes(ctx->memory, (objstm->num_entries + 1) * 2 * sizeof(int),
+                                          "pdfi_read_objstm_index");
+    if (objstm->index == NULL)
+        return_error(gs_error_VMerror);
+
+    code = pdfi_open_memory_stream_from_memory(ctx, objstm->length, objstm->data, &stream, true);
+    if (code < 0)
+        return code;
+
+    for (i = 0; i < objstm->num_entries * 2; i++) {
+        code = pdfi_read_bare_int(ctx, stream, &objstm->index[i]);
+        if (code < 0)
+            break;
+        if (code == 0) {
+            code = gs_note_error(gs_error_syntaxerror);
+            break;
+        }
+    }
+    pdfi_close_memory_stream(ctx, NULL, stream);
+    return code < 0 ? code : 0;
+}
+
+/* Find the decoded form of an ObjStm, decoding it (and adding it to the cache) if need be.
+ * One that could only be decoded in part is not cached, and must be freed by the caller.
+ */
+static int pdfi_get_objstm(pdf_context *ctx, pdf_stream *compressed_object, int64_t Length,
+                           int64_t First, int64_t num_entries, pdfi_objstm **pobjstm)
+{
+    pdfi_objstm *objstm, *prev = NULL;
+    gs_offset_t stream_offset = pdfi_stream_offset(ctx, compressed_object);
+    int code;
+
+    for (objstm = ctx->objstm_cache; objstm != NULL; prev = objstm, objstm = objstm->next) {
+        if (objstm->object_num == compressed_object->object_num &&
+            objstm->stream_offset == stream_offset && objstm->Length == Length &&
+            objstm->First == First && objstm->num_entries == num_entries) {
+            if (prev != NULL) {
+                prev->next = objstm->next;
+                objstm->next = ctx->objstm_cache;
+                ctx->objstm_cache = objstm;
+            }
+            *pobjstm = objstm;
+            return 0;
+        }
+    }
+
+    objstm = (pdfi_objstm *)gs_alloc_bytes(ctx->memory, sizeof(pdfi_objstm), "pdfi_get_objstm");
+    if (objstm == NULL)
+        return_error(gs_error_VMerror);
+    memset(objstm, 0x00, sizeof(pdfi_objstm));
+    objstm->object_num = compressed_object->object_num;
+    objstm->stream_offset = stream_offset;
+    objstm->Length = Length;
+    objstm->First = First;
+    objstm->num_entries = num_entries;
+
+    code = pdfi_decode_objstm(ctx, compressed_object, objstm);
+    if (code >= 0)
+        code = pdfi_read_objstm_index(ctx, objstm);
+    if (code < 0) {
+        pdfi_free_objstm(ctx, objstm);
+        return code;
+    }
+    if (!objstm->cached) {
+        /* The caller frees it */
+        *pobjstm = objstm;
+        return 0;
+    }
+
+    /* Make room, evicting the least recently used streams */
+    while (ctx->objstm_cache != NULL &&
+           (ctx->objstm_cache_entries >= OBJSTM_CACHE_MAX_ENTRIES ||
+            ctx->objstm_cache_bytes + objstm->length > OBJSTM_CACHE_MAX_BYTES)) {
+        pdfi_objstm **plast = &ctx->objstm_cache;
+
+        while ((*plast)->next != NULL)
+            plast = &(*plast)->next;
+        ctx->objstm_cache_entries--;
+        ctx->objstm_cache_bytes -= (*plast)->length;
+        pdfi_free_objstm(ctx, *plast);
+        *plast = NULL;
+    }
+    objstm->next = ctx->objstm_cache;
+    ctx->objstm_cache = objstm;
+    ctx->objstm_cache_entries++;
+    ctx->objstm_cache_bytes += objstm->length;
+
+    *pobjstm = objstm;
+    return 0;
+}
+
 static int pdfi_deref_compressed(pdf_context *ctx, uint64_t obj, uint64_t gen, pdf_obj **object,
                                  const xref_entry *entry, bool cache)
 {
     int code = 0;
     xref_entry *compressed_entry;
     pdf_c_stream *compressed_stream = NULL;
-    pdf_c_stream *SubFile_stream = NULL;
     pdf_c_stream *Object_stream = NULL;
-    int i = 0, object_length = 0;
+    pdfi_objstm *objstm = NULL;
+    int64_t i = 0, object_length = 0;
     int64_t num_entries;
-    int found_object;
     int64_t Length, First;
-    gs_offset_t offset = 0;
+    int64_t offset = 0;
     pdf_stream *compressed_object = NULL;
     pdf_dict *compressed_sdict = NULL; /* alias */
     pdf_name *Type = NULL;
@@ -654,9 +1063,7 @@ static int pdfi_deref_compressed(pdf_context *ctx, uint64_t obj, uint64_t gen, p
     }
 
     if (compressed_entry->cache == NULL) {
-#if CACHE_STATISTICS
         ctx->compressed_misses++;
-#endif
         code = pdfi_seek(ctx, ctx->main_stream, compressed_entry->u.uncompressed.offset, SEEK_SET);
         if (code < 0)
             goto exit;
@@ -688,9 +1095,7 @@ static int pdfi_deref_compressed(pdf_context *ctx, uint64_t obj, uint64_t gen, p
         if (code < 0)
             goto exit;
     } else {
-#if CACHE_STATISTICS
         ctx->compressed_hits++;
-#endif
         compressed_object = (pdf_stream *)compressed_entry->cache->o;
         pdfi_countup(compressed_object);
         pdfi_promote_cache_entry(ctx, compressed_entry->cache);
@@ -762,104 +1167,39 @@ static int pdfi_deref_compressed(pdf_context *ctx, uint64_t obj, uint64_t gen, p
     if (ctx->loop_detection != NULL)
         (void)pdfi_loop_detector_cleartomark(ctx);
 
-    code = pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, compressed_object), SEEK_SET);
+    code = pdfi_get_objstm(ctx, compressed_object, Length, First, num_entries, &objstm);
     if (code < 0)
         goto exit;
 
-    code = pdfi_apply_SubFileDecode_filter(ctx, Length, NULL, ctx->main_stream, &SubFile_stream, false);
-    if (code < 0)
-        goto exit;
-
-    code = pdfi_filter(ctx, compressed_object, SubFile_stream, &compressed_stream, false);
-    if (code < 0)
-        goto exit;
-
-    for (i=0;i < num_entries;i++)
-    {
-        int new_offset;
-        code = pdfi_read_bare_int(ctx, compressed_stream, &found_object);
-        if (code < 0)
-            goto exit;
-        if (code == 0) {
-            code = gs_note_error(gs_error_syntaxerror);
-            goto exit;
-        }
-        code = pdfi_read_bare_int(ctx, compressed_stream, &new_offset);
-        if (code < 0)
-            goto exit;
-        if (code == 0) {
-            code = gs_note_error(gs_error_syntaxerror);
+    i = entry->u.compressed.object_index;
+    if (i < objstm->num_entries) {
+        if (objstm->index[i * 2] != obj) {
+            code = gs_note_error(gs_error_undefined);
             goto exit;
         }
-        if (i == entry->u.compressed.object_index) {
-            if (found_object != obj) {
-                code = gs_note_error(gs_error_undefined);
-                goto exit;
-            }
-            offset = new_offset;
-        }
-        if (i == entry->u.compressed.object_index + 1)
-            object_length = new_offset - offset;
+        offset = objstm->index[i * 2 + 1];
+        if (i + 1 < objstm->num_entries)
+            object_length = objstm->index[i * 2 + 3] - offset;
     }
 
     /* Bug #705259 - The first object need not lie immediately after the initial
      * table of object numbers and offsets. The start of the first object is given
-     * by the value of First. We don't know how many bytes we consumed getting to
-     * the end of the table, unfortunately, so we close the stream, rewind the main
-     * stream back to the beginning of the ObjStm, and then read and discard 'First'
-     * bytes in order to get to the start of the first object. Then we read the
-     * number of bytes required to get from there to the start of the object we
-     * actually want.
-     * If this ever looks like it's causing performance problems we could read the
-     * initial table above manually instead of using the existing code, and track
-     * how many bytes we'd read, which would avoid us having to tear down and
-     * rebuild the stream.
+     * by the value of First.
      */
-    if (compressed_stream) {
-        pdfi_close_file(ctx, compressed_stream);
-        compressed_stream = NULL;
-    }
-    if (SubFile_stream) {
-        pdfi_close_file(ctx, SubFile_stream);
-        SubFile_stream = NULL;
-    }
-
-    code = pdfi_seek(ctx, ctx->main_stream, pdfi_stream_offset(ctx, compressed_object), SEEK_SET);
-    if (code < 0)
+    if (First < 0)
+        First = 0;
+    if (offset < 0)
+        offset = 0;
+    if (First + offset > objstm->length) {
+        code = gs_note_error(gs_error_ioerror);
         goto exit;
-
-    /* We already dereferenced this above, so we don't need the loop detection checking here */
-    code = pdfi_dict_get_int(ctx, compressed_sdict, "Length", &Length);
-    if (code < 0)
-        goto exit;
-
-    code = pdfi_apply_SubFileDecode_filter(ctx, Length, NULL, ctx->main_stream, &SubFile_stream, false);
-    if (code < 0)
-        goto exit;
-
-    code = pdfi_filter(ctx, compressed_object, SubFile_stream, &compressed_stream, false);
+    }
+    code = pdfi_open_memory_stream_from_memory(ctx, objstm->length - (First + offset),
+                                               objstm->data + First + offset,
+                                               &compressed_stream, true);
     if (code < 0)
         goto exit;
 
-    for (i=0;i < First;i++)
-    {
-        int c = pdfi_read_byte(ctx, compressed_stream);
-        if (c < 0) {
-            code = gs_note_error(gs_error_ioerror);
-            goto exit;
-        }
-    }
-
-    /* Skip to the offset of the object we want to read */
-    for (i=0;i < offset;i++)
-    {
-        int c = pdfi_read_byte(ctx, compressed_stream);
-        if (c < 0) {
-            code = gs_note_error(gs_error_ioerror);
-            goto exit;
-        }
-    }
-
     /* If object_length is not 0, then we want to apply a SubFileDecode filter to limit
      * the number of bytes we read to the declared size of the object (difference between
      * the offsets of the object we want to read, and the next object). If it is 0 then
@@ -921,13 +1261,12 @@ static int pdfi_deref_compressed(pdf_context *ctx, uint64_t obj, uint64_t gen, p
     }
 
  exit:
-    if (Object_stream)
+    if (Object_stream && Object_stream != compressed_stream)
         pdfi_close_file(ctx, Object_stream);
-    if (Object_stream != compressed_stream)
-        if (compressed_stream)
-            pdfi_close_file(ctx, compressed_stream);
-    if (SubFile_stream)
-        pdfi_close_file(ctx, SubFile_stream);
+    if (compressed_stream)
+        pdfi_close_memory_stream(ctx, NULL, compressed_stream);
+    if (objstm != NULL && !objstm->cached)
+        pdfi_free_objstm(ctx, objstm);
     pdfi_countdown(compressed_object);
     pdfi_countdown(Type);
     return code;
@@ -1003,9 +1342,7 @@ static int pdfi_dereference_main(pdf_context *ctx, uint64_t obj, uint64_t gen, p
     if (entry->cache != NULL){
         pdf_obj_cache_entry *cache_entry = entry->cache;
 
-#if CACHE_STATISTICS
         ctx->hits++;
-#endif
         *object = cache_entry->o;
         pdfi_countup(*object);
 
@@ -1021,9 +1358,7 @@ static int pdfi_dereference_main(pdf_context *ctx, uint64_t obj, uint64_t gen, p
             if (code < 0 || *object == NULL)
                 goto error;
         } else {
-#if CACHE_STATISTICS
             ctx->misses++;
-#endif
             ctx->encryption.decrypt_strings = true;
 
             code = pdfi_seek(ctx, ctx->main_stream, entry->u.uncompressed.offset, SEEK_SET);
@@ -18,6 +18,8 @@
 
 int pdfi_cache_object(pdf_context *ctx, pdf_obj *o);
 int replace_cache_entry(pdf_context *ctx, pdf_obj *o);
+void pdfi_cache_mark_resource(pdf_context *ctx, pdf_obj *o);
+void pdfi_merge_obj_cache_pools(pdf_context *ctx);
 int is_compressed_object(pdf_context *ctx, uint32_t obj, uint32_t gen);
 int pdfi_dereference(pdf_context *ctx, uint64_t obj, uint64_t gen, pdf_obj **object);
 int pdfi_dereference_nocache(pdf_context *ctx, uint64_t obj, uint64_t gen, pdf_obj **object);
@@ -26,4 +28,5 @@ int pdfi_deref_loop_detect_nocache(pdf_context *ctx, uint64_t obj, uint64_t gen,
 int pdfi_read_bare_object(pdf_context *ctx, pdf_c_stream *s, gs_offset_t stream_offset, uint32_t objnum, uint32_t gen);
 int pdfi_resolve_indirect(pdf_context *ctx, pdf_obj *value, bool recurse);
 int pdfi_resolve_indirect_loop_detect(pdf_context *ctx, pdf_obj *parent, pdf_obj *value, bool recurse);
+void pdfi_free_objstm_cache(pdf_context *ctx);
 #endif
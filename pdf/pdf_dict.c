@@ -24,8 +24,10 @@
 #include "pdf_loop_detect.h"
 #include "pdf_misc.h"
 
-static int pdfi_dict_find(pdf_context *ctx, pdf_dict *d, const char *Key, bool sort);
-static int pdfi_dict_find_key(pdf_context *ctx, pdf_dict *d, const pdf_name *Key, bool sort);
+static int pdfi_dict_find(pdf_context *ctx, pdf_dict *d, const char *Key, bool build_hash);
+static int pdfi_dict_find_key(pdf_context *ctx, pdf_dict *d, const pdf_name *Key, bool build_hash);
+static void pdfi_dict_free_hash(pdf_dict *d);
+static void pdfi_dict_hash_added(pdf_dict *d, uint64_t index);
 
 void pdfi_free_dict(pdf_obj *o)
 {
@@ -45,6 +47,7 @@ void pdfi_free_dict(pdf_obj *o)
             pdfi_countdown(d->list[i].key);
     }
     gs_free_object(OBJ_MEMORY(d), d->list, "pdf interpreter free dictionary key/values");
+    pdfi_dict_free_hash(d);
     gs_free_object(OBJ_MEMORY(d), d, "pdf interpreter free dictionary");
 }
 
@@ -72,7 +75,8 @@ static int pdfi_dict_delete_inner(pdf_context *ctx, pdf_dict *d, pdf_name *n, co
         memmove(&d->list[i], &d->list[i+1], (d->entries - i) * sizeof(d->list[0]));
     d->list[d->entries].key = NULL;
     d->list[d->entries].value = NULL;
-    d->is_sorted = false;
+    /* The remaining entries have moved, so the hash index is no use */
+    pdfi_dict_free_hash(d);
     return 0;
 }
 
@@ -211,61 +215,89 @@ pdfi_dict_get2(pdf_context *ctx, pdf_dict *d, const char *Key1,
     return code;
 }
 
-static int pdfi_dict_compare_entry(const void *a, const void *b)
-{
-    pdf_name *key_a = (pdf_name *)((pdf_dict_entry *)a)->key, *key_b = (pdf_name *)((pdf_dict_entry *)b)->key;
+/* Dictionaries with more than this many entries get a hash index (built the
+ * first time we look something up) rather than being searched linearly.
+ */
+#define PDFI_DICT_HASH_THRESHOLD 32
 
-    if (key_a == NULL) {
-        if (key_b == NULL)
-            return 0;
-        else
-            return 1;
+static void pdfi_dict_free_hash(pdf_dict *d)
+{
+    if (d->hash != NULL) {
+        gs_free_object(OBJ_MEMORY(d), d->hash, "pdfi_dict_free_hash");
+        d->hash = NULL;
+        d->hash_size = 0;
     }
+}
 
-    if (key_b == NULL)
-        return -1;
+/* Add the key at list[index] to the hash index. Open addressing with linear probing,
+ * a slot holds the list index + 1, or 0 if it is empty.
+ */
+static void pdfi_dict_hash_insert(pdf_dict *d, uint64_t index)
+{
+    pdf_name *key = (pdf_name *)d->list[index].key;
+    uint32_t slot;
 
-    if (key_a->length != key_b->length)
-        return key_a->length - key_b->length;
+    if (key == NULL || pdfi_type_of(key) != PDF_NAME)
+        return;
 
-    return strncmp((const char *)key_a->data, (const char *)key_b->data, key_a->length);
+    slot = pdfi_name_hash(key->data, key->length) & (d->hash_size - 1);
+    while (d->hash[slot] != 0)
+        slot = (slot + 1) & (d->hash_size - 1);
+    d->hash[slot] = (uint32_t)index + 1;
 }
 
-static int pdfi_dict_find_sorted(pdf_context *ctx, pdf_dict *d, const char *Key)
+/* Build the hash index, the table is kept at most half full. If we can't
+ * allocate it we just carry on searching linearly.
+ */
+static void pdfi_dict_build_hash(pdf_context *ctx, pdf_dict *d)
 {
-    int start = 0, end = d->size - 1, middle = 0, keylen = strlen(Key);
-    pdf_name *test_key;
-
-    while (start <= end) {
-        middle = start + (end - start) / 2;
-        test_key = (pdf_name *)d->list[middle].key;
+    uint32_t size = PDFI_DICT_HASH_THRESHOLD * 2;
+    uint64_t i;
+
+    if (d->size >= max_uint / 4)
+        return;
+    while (size < d->size * 2)
+        size <<= 1;
+
+    d->hash = (uint32_t *)gs_alloc_bytes(OBJ_MEMORY(d), (size_t)size * sizeof(uint32_t), "pdfi_dict_build_hash");
+    if (d->hash == NULL)
+        return;
+    memset(d->hash, 0x00, (size_t)size * sizeof(uint32_t));
+    d->hash_size = size;
+
+    for (i = 0; i < d->size; i++)
+        pdfi_dict_hash_insert(d, i);
+}
 
-        /* Sorting pushes unused key/values (NULL) to the end of the dictionary */
-        if (test_key == NULL) {
-            end = middle - 1;
-            continue;
-        }
+/* Called after a new key has been stored at list[index] */
+static void pdfi_dict_hash_added(pdf_dict *d, uint64_t index)
+{
+    if (d->hash == NULL)
+        return;
+    /* If the table is getting full throw it away, we'll build a bigger one
+     * the next time we need it.
+     */
+    if (d->size * 2 > d->hash_size)
+        pdfi_dict_free_hash(d);
+    else
+        pdfi_dict_hash_insert(d, index);
+}
 
-        if (test_key->length == keylen) {
-            int result = strncmp((const char *)test_key->data, Key, keylen);
+static int pdfi_dict_find_hashed(pdf_context *ctx, pdf_dict *d, const byte *Key, uint32_t keylen)
+{
+    uint32_t slot = pdfi_name_hash(Key, keylen) & (d->hash_size - 1), i;
+    pdf_name *t;
 
-            if (result == 0)
-                return middle;
-            if (result < 0)
-                start = middle + 1;
-            else
-                end = middle - 1;
-        } else {
-            if (test_key->length < keylen)
-                start = middle + 1;
-            else
-                end = middle -1;
-        }
+    while ((i = d->hash[slot]) != 0) {
+        t = (pdf_name *)d->list[i - 1].key;
+        if (t->length == keylen && memcmp(t->data, Key, keylen) == 0)
+            return i - 1;
+        slot = (slot + 1) & (d->hash_size - 1);
     }
-    return gs_note_error(gs_error_undefined);
+    return_error(gs_error_undefined);
 }
 
-static int pdfi_dict_find_unsorted(pdf_context *ctx, pdf_dict *d, const char *Key)
+static int pdfi_dict_find_linear(pdf_context *ctx, pdf_dict *d, const byte *Key, uint32_t keylen)
 {
     int i;
     pdf_name *t;
@@ -274,7 +306,7 @@ static int pdfi_dict_find_unsorted(pdf_context *ctx, pdf_dict *d, const char *Ke
         t = (pdf_name *)d->list[i].key;
 
         if (t && pdfi_type_of(t) == PDF_NAME) {
-            if (pdfi_name_is((pdf_name *)t, Key)) {
+            if (t->length == keylen && memcmp(t->data, Key, keylen) == 0) {
                 return i;
             }
         }
@@ -282,35 +314,26 @@ static int pdfi_dict_find_unsorted(pdf_context *ctx, pdf_dict *d, const char *Ke
     return_error(gs_error_undefined);
 }
 
-static int pdfi_dict_find(pdf_context *ctx, pdf_dict *d, const char *Key, bool sort)
+/* 'build_hash' is true if it is worth building a hash index for a large dictionary */
+static int pdfi_dict_find_bytes(pdf_context *ctx, pdf_dict *d, const byte *Key, uint32_t keylen, bool build_hash)
 {
-    if (!d->is_sorted) {
-        if (d->entries > 32 && sort) {
-            qsort(d->list, d->size, sizeof(pdf_dict_entry), pdfi_dict_compare_entry);
-            d->is_sorted = true;
-            return pdfi_dict_find_sorted(ctx, d, Key);
-        } else
-            return pdfi_dict_find_unsorted(ctx, d, Key);
-    } else
-        return pdfi_dict_find_sorted(ctx, d, Key);
+    if (d->hash == NULL && build_hash && d->entries > PDFI_DICT_HASH_THRESHOLD)
+        pdfi_dict_build_hash(ctx, d);
+
+    if (d->hash != NULL)
+        return pdfi_dict_find_hashed(ctx, d, Key, keylen);
+    else
+        return pdfi_dict_find_linear(ctx, d, Key, keylen);
 }
 
-static int pdfi_dict_find_key(pdf_context *ctx, pdf_dict *d, const pdf_name *Key, bool sort)
+static int pdfi_dict_find(pdf_context *ctx, pdf_dict *d, const char *Key, bool build_hash)
 {
-    char *Test = NULL;
-    int index = 0;
-
-    Test = (char *)gs_alloc_bytes(ctx->memory, (size_t)Key->length + 1, "pdfi_dict_find_key");
-    if (Test == NULL)
-        return_error(gs_error_VMerror);
-
-    memcpy(Test, Key->data, Key->length);
-    Test[Key->length] = 0x00;
-
-    index = pdfi_dict_find(ctx, d, Test, sort);
+    return pdfi_dict_find_bytes(ctx, d, (const byte *)Key, strlen(Key), build_hash);
+}
 
-    gs_free_object(ctx->memory, Test, "pdfi_dict_find_key");
-    return index;
+static int pdfi_dict_find_key(pdf_context *ctx, pdf_dict *d, const pdf_name *Key, bool build_hash)
+{
+    return pdfi_dict_find_bytes(ctx, d, Key->data, Key->length, build_hash);
 }
 
 /* The object returned by pdfi_dict_get has its reference count incremented by 1 to
@@ -902,7 +925,7 @@ int pdfi_dict_put_obj(pdf_context *ctx, pdf_dict *d, pdf_obj *Key, pdf_obj *valu
         return_error(gs_error_typecheck);
 
     /* First, do we have a Key/value pair already ? */
-    i = pdfi_dict_find_key(ctx, d, (pdf_name *)Key, false);
+    i = pdfi_dict_find_key(ctx, d, (pdf_name *)Key, true);
     if (i >= 0) {
         if (d->list[i].value == value || replace == false)
             /* We already have this value stored with this key.... */
@@ -913,8 +936,6 @@ int pdfi_dict_put_obj(pdf_context *ctx, pdf_dict *d, pdf_obj *Key, pdf_obj *valu
         return 0;
     }
 
-    d->is_sorted = false;
-
     /* Nope, its a new Key */
     if (d->size > d->entries) {
         /* We have a hole, find and use it */
@@ -925,6 +946,7 @@ int pdfi_dict_put_obj(pdf_context *ctx, pdf_dict *d, pdf_obj *Key, pdf_obj *valu
                 d->list[i].value = value;
                 pdfi_countup(value);
                 d->entries++;
+                pdfi_dict_hash_added(d, i);
                 return 0;
             }
         }
@@ -947,6 +969,7 @@ int pdfi_dict_put_obj(pdf_context *ctx, pdf_dict *d, pdf_obj *Key, pdf_obj *valu
     d->entries++;
     pdfi_countup(Key);
     pdfi_countup(value);
+    pdfi_dict_hash_added(d, d->size - 1);
 
     return 0;
 }
@@ -982,6 +1005,7 @@ int pdfi_dict_put_unchecked(pdf_context *ctx, pdf_dict *d, const char *Key, pdf_
                     d->list[i].value = value;
                     pdfi_countup(value);
                     d->entries++;
+                    pdfi_dict_hash_added(d, i);
                     return 0;
                 }
             }
@@ -1008,6 +1032,7 @@ int pdfi_dict_put_unchecked(pdf_context *ctx, pdf_dict *d, const char *Key, pdf_
     d->size++;
     d->entries++;
     pdfi_countup(value);
+    pdfi_dict_hash_added(d, d->size - 1);
 
     return 0;
 }
@@ -1071,7 +1096,6 @@ int pdfi_dict_copy(pdf_context *ctx, pdf_dict *target, pdf_dict *source)
         code = pdfi_dict_put_obj(ctx, target, source->list[i].key, source->list[i].value, true);
         if (code < 0)
             return code;
-        target->is_sorted = source->is_sorted;
     }
     return 0;
 }
@@ -1410,7 +1434,6 @@ int pdfi_merge_dicts(pdf_context *ctx, pdf_dict *target, pdf_dict *source)
                 return code;
         }
     }
-    target->is_sorted = false;
     return 0;
 }
 
@@ -797,6 +797,132 @@ static int pdfi_check_inherited_key(pdf_context *ctx, pdf_dict *d, const char *k
     return code;
 }
 
+/* The page index. As we walk the Pages tree looking for a page we record the object
+ * number of every page we pass, along with the dictionary of keys it inherits from its
+ * ancestors, in ctx->page_array and ctx->page_inherited. Subsequent requests for any of
+ * those pages can then go straight to the page dictionary without walking the tree
+ * again. Page dictionaries which are not indirect objects aren't indexed.
+ */
+static void pdfi_page_index_add(pdf_context *ctx, uint64_t page_num, uint32_t object_num, pdf_dict *inherited)
+{
+    if (ctx->page_inherited == NULL || page_num >= ctx->num_pages || object_num == 0)
+        return;
+    if (ctx->page_inherited[page_num] != NULL)
+        return;
+
+    ctx->page_array[page_num] = object_num;
+    ctx->page_inherited[page_num] = inherited;
+    pdfi_countup(inherited);
+}
+
+static void pdfi_page_index_set_resume(pdf_context *ctx, pdf_array *Kids, int index,
+                                       uint64_t page_num, pdf_dict *inherited)
+{
+    pdfi_countdown(ctx->page_resume_Kids);
+    pdfi_countdown(ctx->page_resume_inherited);
+    ctx->page_resume_Kids = Kids;
+    ctx->page_resume_inherited = inherited;
+    pdfi_countup(Kids);
+    pdfi_countup(inherited);
+    ctx->page_resume_index = index;
+    ctx->page_resume_page = page_num;
+}
+
+/* A walk of the Pages tree stops as soon as it finds the page it is looking for, so
+ * only the pages up to that one are in the index. When a later page is wanted, carry
+ * on through the Page leaves following the last page found in its Kids array, adding
+ * them to the index, rather than walking the tree from the root again. Asking for the
+ * pages of a flat tree in order then costs one step per page. Anything other than a
+ * Page leaf ends this, and we return > 0 so that the caller walks the tree.
+ */
+static int pdfi_page_index_resume(pdf_context *ctx, uint64_t page_num, pdf_dict **target)
+{
+    pdf_array *Kids = ctx->page_resume_Kids;
+    pdf_dict *inherited = ctx->page_resume_inherited;
+    pdf_dict *child = NULL;
+    pdf_name *Type = NULL;
+    uint64_t page = ctx->page_resume_page;
+    int i = ctx->page_resume_index;
+    int code = 1;
+
+    if (Kids == NULL || page_num < page)
+        return 1;
+
+    pdfi_countup(Kids);
+    pdfi_countup(inherited);
+    pdfi_page_index_set_resume(ctx, NULL, 0, 0, NULL);
+
+    for (; i < pdfi_array_size(Kids) && page <= page_num; i++, page++) {
+        pdfi_countdown(child);
+        child = NULL;
+        pdfi_countdown(Type);
+        Type = NULL;
+
+        code = pdfi_get_child(ctx, Kids, i, &child);
+        if (code < 0)
+            break;
+        code = pdfi_dict_get_type(ctx, child, "Type", PDF_NAME, (pdf_obj **)&Type);
+        if (code < 0 || !pdfi_name_is(Type, "Page"))
+            break;
+        pdfi_page_index_add(ctx, page, child->object_num, inherited);
+        if (page == page_num) {
+            code = pdfi_merge_dicts(ctx, child, inherited);
+            if (code < 0)
+                break;
+            *target = child;
+            pdfi_countup(*target);
+            pdfi_page_index_set_resume(ctx, Kids, i + 1, page + 1, inherited);
+            goto exit;
+        }
+    }
+    /* Not found, leave it to the tree walk (which reports any errors) */
+    code = 1;
+
+ exit:
+    pdfi_countdown(Kids);
+    pdfi_countdown(inherited);
+    pdfi_countdown(child);
+    pdfi_countdown(Type);
+    return code;
+}
+
+/* Returns 0 and the page dictionary if the page is in the index, > 0 if it is not
+ * (or the index entry is unusable), in which case the caller should walk the tree.
+ */
+int pdfi_page_index_get(pdf_context *ctx, uint64_t page_num, pdf_dict **target)
+{
+    pdf_dict *page_dict = NULL;
+    xref_entry *entry;
+    uint32_t object_num, gen = 0;
+    int code;
+
+    if (ctx->page_inherited == NULL || page_num >= ctx->num_pages)
+        return 1;
+    if (ctx->page_inherited[page_num] == NULL)
+        return pdfi_page_index_resume(ctx, page_num, target);
+
+    object_num = ctx->page_array[page_num];
+    if (object_num >= ctx->xref_table->xref_size)
+        return 1;
+    entry = &ctx->xref_table->xref[object_num];
+    if (!entry->compressed)
+        gen = entry->u.uncompressed.generation_num;
+
+    code = pdfi_dereference(ctx, object_num, gen, (pdf_obj **)&page_dict);
+    if (code < 0 || pdfi_type_of(page_dict) != PDF_DICT) {
+        pdfi_countdown(page_dict);
+        return 1;
+    }
+
+    code = pdfi_merge_dicts(ctx, page_dict, ctx->page_inherited[page_num]);
+    if (code < 0) {
+        pdfi_countdown(page_dict);
+        return code;
+    }
+    *target = page_dict;
+    return 0;
+}
+
 int pdfi_get_page_dict(pdf_context *ctx, pdf_dict *d, uint64_t page_num, uint64_t *page_offset,
                    pdf_dict **target, pdf_dict *inherited)
 {
@@ -917,6 +1043,12 @@ int pdfi_get_page_dict(pdf_context *ctx, pdf_dict *d, uint64_t page_num, uint64_
                 }
             } else {
                 if (pdfi_name_is(Type, "PageRef")) {
+                    pdf_indirect_ref *ref = NULL;
+
+                    if (pdfi_dict_get_ref(ctx, child, "PageRef", &ref) >= 0) {
+                        pdfi_page_index_add(ctx, *page_offset, ref->ref_object_num, inheritable);
+                        pdfi_countdown(ref);
+                    }
                     if ((*page_offset) == page_num) {
                         pdf_dict *page_dict = NULL;
 
@@ -940,10 +1072,13 @@ int pdfi_get_page_dict(pdf_context *ctx, pdf_dict *d, uint64_t page_num, uint64_
                         if ((code = pdfi_set_error_stop(ctx, gs_note_error(gs_error_typecheck), NULL, E_PDF_BADPAGETYPE, "pdfi_get_page_dict", NULL)) < 0)
                             goto exit;
                     }
+                    pdfi_page_index_add(ctx, *page_offset, child->object_num, inheritable);
                     if ((*page_offset) == page_num) {
                         code = pdfi_merge_dicts(ctx, child, inheritable);
                         *target = child;
                         pdfi_countup(*target);
+                        if (ctx->page_inherited != NULL)
+                            pdfi_page_index_set_resume(ctx, Kids, i + 1, page_num + 1, inheritable);
                         goto exit;
                     } else {
                         *page_offset += 1;
@@ -976,11 +1111,154 @@ int pdfi_doc_page_array_init(pdf_context *ctx)
         return_error(gs_error_VMerror);
 
     memset(ctx->page_array, 0, size);
+
+    /* If we can't allocate the page index we can manage without it */
+    size = ctx->num_pages*sizeof(pdf_dict *);
+    ctx->page_inherited = (pdf_dict **)gs_alloc_bytes(ctx->memory, size,
+                                                      "pdfi_doc_page_array_init(page_inherited)");
+    if (ctx->page_inherited != NULL)
+        memset(ctx->page_inherited, 0, size);
     return 0;
 }
 
+/* True if the first page section of a linearized file has the object, so we can
+ * read it without provoking an attempt to repair the file.
+ */
+static bool pdfi_first_page_has_object(pdf_context *ctx, uint64_t object_num)
+{
+    return object_num > 0 && object_num < ctx->xref_table->xref_size &&
+        ctx->xref_table->xref[object_num].object_num != 0 &&
+        !ctx->xref_table->xref[object_num].free;
+}
+
+/* Used when rendering the first page of a linearized file before the Pages tree has
+ * arrived. The linearization dictionary gives the number of pages and the object number
+ * of the first page, so we can put the first page straight into the page index for
+ * pdfi_page_get_dict() to find, along with the keys it inherits from whichever of the
+ * Pages nodes above it are in the first page section. A linearized file isn't supposed
+ * to leave the first page inheriting anything from nodes outside that section, but in
+ * case it does we insist on having found the MediaBox and Resources. Returns an error if
+ * we can't put the page in the index, in which case it must wait for the whole file.
+ */
+int pdfi_doc_page_array_init_first_page(pdf_context *ctx, uint64_t num_pages, uint32_t object_num)
+{
+    static const char *inheritable_keys[] = {"Resources", "MediaBox", "CropBox", "Rotate"};
+    pdf_dict *inherited = NULL, *page_dict = NULL, *node = NULL, *Parent = NULL;
+    pdf_indirect_ref *ref = NULL;
+    xref_entry *entry;
+    uint32_t gen = 0;
+    bool known;
+    int i, code;
+
+    if (num_pages == 0 || !pdfi_first_page_has_object(ctx, object_num))
+        return_error(gs_error_rangecheck);
+
+    ctx->num_pages = num_pages;
+    code = pdfi_doc_page_array_init(ctx);
+    if (code < 0)
+        return code;
+    if (ctx->page_inherited == NULL)
+        return_error(gs_error_VMerror);
+
+    code = pdfi_dict_alloc(ctx, 4, &inherited);
+    if (code < 0)
+        return code;
+    pdfi_countup(inherited);
+
+    entry = &ctx->xref_table->xref[object_num];
+    if (!entry->compressed)
+        gen = entry->u.uncompressed.generation_num;
+    code = pdfi_dereference(ctx, object_num, gen, (pdf_obj **)&page_dict);
+    if (code < 0)
+        goto exit;
+    if (pdfi_type_of(page_dict) != PDF_DICT) {
+        code = gs_note_error(gs_error_typecheck);
+        goto exit;
+    }
+
+    code = pdfi_loop_detector_mark(ctx);
+    if (code < 0)
+        goto exit;
+    /* Walk up the Pages tree; a key found nearer the page overrides the same key further
+     * up. Don't store the Parent in the dictionaries, or we'd create circular references.
+     */
+    node = page_dict;
+    pdfi_countup(node);
+    do {
+        code = pdfi_loop_detector_add_object(ctx, node->object_num);
+        if (code < 0)
+            break;
+        code = pdfi_dict_known(ctx, node, "Parent", &known);
+        if (code < 0 || !known)
+            break;
+        code = pdfi_dict_get_ref(ctx, node, "Parent", &ref);
+        if (code < 0)
+            break;
+        if (!pdfi_first_page_has_object(ctx, ref->ref_object_num))
+            break;
+        if (pdfi_loop_detector_check_object(ctx, ref->ref_object_num)) {
+            code = gs_note_error(gs_error_circular_reference);
+            break;
+        }
+        code = pdfi_dereference(ctx, ref->ref_object_num, ref->ref_generation_num, (pdf_obj **)&Parent);
+        pdfi_countdown(ref);
+        ref = NULL;
+        if (code < 0)
+            break;
+        if (pdfi_type_of(Parent) != PDF_DICT) {
+            code = gs_note_error(gs_error_typecheck);
+            break;
+        }
+        for (i = 0; i < sizeof(inheritable_keys) / sizeof(inheritable_keys[0]); i++) {
+            code = pdfi_dict_known(ctx, inherited, inheritable_keys[i], &known);
+            if (code >= 0 && !known)
+                code = pdfi_check_inherited_key(ctx, Parent, inheritable_keys[i], inherited);
+            if (code < 0)
+                break;
+        }
+        pdfi_countdown(node);
+        node = Parent;
+        Parent = NULL;
+    } while (code >= 0);
+    (void)pdfi_loop_detector_cleartomark(ctx);
+    if (code < 0)
+        goto exit;
+
+    /* We can't draw the page without these */
+    for (i = 0; i < 2; i++) {
+        code = pdfi_dict_known(ctx, page_dict, inheritable_keys[i], &known);
+        if (code >= 0 && !known)
+            code = pdfi_dict_known(ctx, inherited, inheritable_keys[i], &known);
+        if (code < 0)
+            goto exit;
+        if (!known) {
+            code = gs_note_error(gs_error_undefined);
+            goto exit;
+        }
+    }
+
+    pdfi_page_index_add(ctx, 0, object_num, inherited);
+
+exit:
+    pdfi_countdown(ref);
+    pdfi_countdown(Parent);
+    pdfi_countdown(node);
+    pdfi_countdown(page_dict);
+    pdfi_countdown(inherited);
+    return code;
+}
+
 void pdfi_doc_page_array_free(pdf_context *ctx)
 {
+    uint64_t i;
+
+    pdfi_page_index_set_resume(ctx, NULL, 0, 0, NULL);
+    if (ctx->page_inherited) {
+        for (i = 0; i < ctx->num_pages; i++)
+            pdfi_countdown(ctx->page_inherited[i]);
+        gs_free_object(ctx->memory, ctx->page_inherited, "pdfi_doc_page_array_free(page_inherited)");
+        ctx->page_inherited = NULL;
+    }
     if (!ctx->page_array)
         return;
     gs_free_object(ctx->memory, ctx->page_array, "pdfi_doc_page_array_free(page_array)");
@@ -1172,6 +1450,9 @@ int pdfi_find_resource(pdf_context *ctx, unsigned char *Type, pdf_name *name,
     code = gs_error_undefined;
 
 exit:
+    /* Named resources tend to be reused across pages, keep them in the resource pool of the cache */
+    if (code >= 0 && *o != NULL)
+        pdfi_cache_mark_resource(ctx, *o);
     pdfi_countdown(typedict);
     pdfi_countdown(Parent);
     return code;
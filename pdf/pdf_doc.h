@@ -24,9 +24,11 @@ void pdfi_free_OptionalRoot(pdf_context *ctx);
 
 int pdfi_read_Pages(pdf_context *ctx);
 int pdfi_get_page_dict(pdf_context *ctx, pdf_dict *d, uint64_t page_num, uint64_t *page_offset, pdf_dict **target, pdf_dict *inherited);
+int pdfi_page_index_get(pdf_context *ctx, uint64_t page_num, pdf_dict **target);
 int pdfi_find_resource(pdf_context *ctx, unsigned char *Type, pdf_name *name, pdf_dict *dict,
                        pdf_dict *page_dict, pdf_obj **o);
 int pdfi_doc_page_array_init(pdf_context *ctx);
+int pdfi_doc_page_array_init_first_page(pdf_context *ctx, uint64_t num_pages, uint32_t object_num);
 void pdfi_doc_page_array_free(pdf_context *ctx);
 int pdfi_doc_trailer(pdf_context *ctx);
 
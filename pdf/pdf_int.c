@@ -52,20 +52,56 @@
 
 /***********************************************************************************/
 /* Some simple functions to find white space, delimiters and hex bytes             */
-static bool iswhite(char c)
+
+/* Character classes, indexed by byte value. These are consulted for every byte
+ * of every content stream, so use a table rather than a chain of comparisons.
+ */
+#define CC_WHITE 1
+#define CC_DELIM 2
+#define CC_NUM   4      /* Can start a number; digits, sign or decimal point */
+
+#define W CC_WHITE
+#define D CC_DELIM
+#define N CC_NUM
+static const byte pdfi_char_class[256] = {
+    W, 0, 0, 0, 0, 0, 0, 0, 0, W, W, 0, W, W, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    W, 0, 0, 0, 0, D, 0, 0, D, D, 0, N, 0, N, N, D,
+    N, N, N, N, N, N, N, N, N, N, 0, 0, D, 0, D, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, D, 0, D, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, D, 0, D, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+#undef W
+#undef D
+#undef N
+
+static inline bool iswhite(char c)
 {
-    if (c == 0x00 || c == 0x09 || c == 0x0a || c == 0x0c || c == 0x0d || c == 0x20)
-        return true;
-    else
-        return false;
+    return (pdfi_char_class[(byte)c] & CC_WHITE) != 0;
 }
 
-static bool isdelimiter(char c)
+static inline bool isdelimiter(char c)
 {
-    if (c == '/' || c == '(' || c == ')' || c == '[' || c == ']' || c == '<' || c == '>' || c == '{' || c == '}' || c == '%')
-        return true;
-    else
-        return false;
+    return (pdfi_char_class[(byte)c] & CC_DELIM) != 0;
+}
+
+/* The fast paths below work directly on the bytes in the stream's buffer. That's
+ * only possible when there is nothing in the unread buffer (which is returned
+ * first) and we haven't already hit EOF.
+ */
+static inline bool pdfi_can_scan_buffer(pdf_c_stream *s)
+{
+    return s->unread_size == 0 && !s->eof;
 }
 
 /* The 'read' functions all return the newly created object on the context's stack
@@ -77,6 +113,16 @@ int pdfi_skip_white(pdf_context *ctx, pdf_c_stream *s)
 {
     int c;
 
+    if (pdfi_can_scan_buffer(s)) {
+        const byte *p = sbufptr(s->s), *limit = p + sbufavailable(s->s);
+
+        while (p < limit && iswhite(*p))
+            p++;
+        (void)sbufskip(s->s, p - sbufptr(s->s));
+        if (p < limit)
+            return 0;
+    }
+
     do {
         c = pdfi_read_byte(ctx, s);
         if (c < 0)
@@ -107,7 +153,7 @@ int pdfi_skip_eol(pdf_context *ctx, pdf_c_stream *s)
 
 /* Fast(ish) but inaccurate strtof, with Adobe overflow handling,
  * lifted from MuPDF. */
-static float acrobat_compatible_atof(char *s)
+static float acrobat_compatible_atof(const char *s)
 {
     int neg = 0;
     int i = 0;
@@ -891,29 +937,12 @@ static pdf_key lookup_keyword(const byte *Buffer)
  * instead return a PDF_KEYWORD object. In the even that we parse
  * an 'R', we will return a PDF_INDIRECT object.
  */
-static int pdfi_read_keyword(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, uint32_t indirect_gen)
+static int pdfi_push_keyword(pdf_context *ctx, pdf_c_stream *s, byte *Buffer, unsigned short index, uint32_t indirect_num, uint32_t indirect_gen)
 {
-    byte Buffer[256];
-    unsigned short index = 0;
-    int c, code;
+    int code;
     pdf_keyword *keyword;
     pdf_key key;
 
-    pdfi_skip_white(ctx, s);
-
-    do {
-        c = pdfi_read_byte(ctx, s);
-        if (c < 0)
-            break;
-
-        if (iswhite(c) || isdelimiter(c)) {
-            pdfi_unread_byte(ctx, s, (byte)c);
-            break;
-        }
-        Buffer[index] = (byte)c;
-        index++;
-    } while (index < 255);
-
     if (index >= 255 || index == 0) {
         if ((code = pdfi_set_error_stop(ctx, gs_note_error(gs_error_syntaxerror), NULL, 0, "pdfi_read_keyword", NULL)) < 0) {
             return code;
@@ -1003,6 +1032,169 @@ static int pdfi_read_keyword(pdf_context *ctx, pdf_c_stream *s, uint32_t indirec
     return code;
 }
 
+static int pdfi_read_keyword(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, uint32_t indirect_gen)
+{
+    byte Buffer[256];
+    unsigned short index = 0;
+    int c;
+
+    pdfi_skip_white(ctx, s);
+
+    do {
+        c = pdfi_read_byte(ctx, s);
+        if (c < 0)
+            break;
+
+        if (iswhite(c) || isdelimiter(c)) {
+            pdfi_unread_byte(ctx, s, (byte)c);
+            break;
+        }
+        Buffer[index] = (byte)c;
+        index++;
+    } while (index < 255);
+
+    return pdfi_push_keyword(ctx, s, Buffer, index, indirect_num, indirect_gen);
+}
+
+/* Fast paths for the commonest tokens in content streams; numbers, simple names
+ * and operators. These work directly on the stream buffer and deal only with
+ * tokens which are entirely present in the buffer, including the character which
+ * terminates them, and which are well formed. Anything else returns 0 having
+ * consumed nothing, and the caller falls back to the byte at a time code, which
+ * deals with all the odd cases and error recovery. The results must be identical.
+ */
+static int pdfi_read_num_fast(pdf_context *ctx, pdf_c_stream *s, const byte *p, const byte *limit, uint32_t indirect_num, uint32_t indirect_gen)
+{
+    const byte *q = p;
+    unsigned int int_val = 0;
+    int digits = 0;
+    bool negative = false, real = false;
+    pdf_num *num;
+    int code;
+
+    if (*q == '-' || *q == '+') {
+        negative = (*q == '-');
+        q++;
+    }
+    /* Limit the integer part so we can't overflow, pdfi_read_num deals with that */
+    while (q < limit && *q >= '0' && *q <= '9' && digits < 9) {
+        int_val = int_val * 10 + (*q++ - '0');
+        digits++;
+    }
+    if (q < limit && *q == '.') {
+        real = true;
+        q++;
+        while (q < limit && *q >= '0' && *q <= '9' && q - p < 128) {
+            q++;
+            digits++;
+        }
+    }
+    if (digits == 0 || q >= limit || !(pdfi_char_class[*q] & (CC_WHITE | CC_DELIM)))
+        return 0;
+
+    code = pdfi_object_alloc(ctx, real ? PDF_REAL : PDF_INT, 0, (pdf_obj **)&num);
+    if (code < 0)
+        return code;
+
+    if (real)
+        num->value.d = acrobat_compatible_atof((const char *)p);
+    else
+        num->value.i = negative ? (int64_t)int_val * -1 : (int64_t)int_val;
+    num->indirect_num = indirect_num;
+    num->indirect_gen = indirect_gen;
+
+    /* White space terminating a number is consumed, a delimiter is not */
+    if (iswhite(*q))
+        q++;
+    (void)sbufskip(s->s, q - p);
+
+    code = pdfi_push(ctx, (pdf_obj *)num);
+    if (code < 0) {
+        pdfi_free_object((pdf_obj *)num);
+        return code;
+    }
+    return 1;
+}
+
+static int pdfi_read_name_fast(pdf_context *ctx, pdf_c_stream *s, const byte *p, const byte *limit, uint32_t indirect_num, uint32_t indirect_gen)
+{
+    const byte *q = p + 1;
+    pdf_name *name = NULL;
+    int code;
+
+    while (q < limit && !(pdfi_char_class[*q] & (CC_WHITE | CC_DELIM))) {
+        if (*q == '#')
+            return 0;
+        q++;
+    }
+    if (q >= limit)
+        return 0;
+
+    code = pdfi_object_alloc(ctx, PDF_NAME, q - p - 1, (pdf_obj **)&name);
+    if (code < 0)
+        return code;
+    memcpy(name->data, p + 1, q - p - 1);
+    name->indirect_num = indirect_num;
+    name->indirect_gen = indirect_gen;
+
+    if (iswhite(*q))
+        q++;
+    (void)sbufskip(s->s, q - p);
+
+    code = pdfi_push(ctx, (pdf_obj *)name);
+    if (code < 0) {
+        pdfi_free_object((pdf_obj *)name);
+        return code;
+    }
+    return 1;
+}
+
+static int pdfi_read_keyword_fast(pdf_context *ctx, pdf_c_stream *s, const byte *p, const byte *limit, uint32_t indirect_num, uint32_t indirect_gen)
+{
+    byte Buffer[256];
+    const byte *q = p;
+    int code;
+
+    while (q < limit && !(pdfi_char_class[*q] & (CC_WHITE | CC_DELIM)) && q - p < 255)
+        q++;
+    if (q >= limit || q - p >= 255)
+        return 0;
+    /* The inline image code reads the image data straight from the underlying
+     * stream, relying on the byte at a time code having put the single white space
+     * character following 'ID' into the unread buffer, where it gets ignored.
+     */
+    if (q - p == 2 && p[0] == 'I' && p[1] == 'D')
+        return 0;
+
+    memcpy(Buffer, p, q - p);
+    (void)sbufskip(s->s, q - p);
+    code = pdfi_push_keyword(ctx, s, Buffer, q - p, indirect_num, indirect_gen);
+    if (code < 0)
+        return code;
+    return 1;
+}
+
+static int pdfi_read_token_fast(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, uint32_t indirect_gen)
+{
+    const byte *p, *limit;
+
+    if (!pdfi_can_scan_buffer(s) || ctx->args.pdfdebug)
+        return 0;
+
+    p = sbufptr(s->s);
+    limit = p + sbufavailable(s->s);
+    if (p >= limit)
+        return 0;
+
+    if (pdfi_char_class[*p] & CC_NUM)
+        return pdfi_read_num_fast(ctx, s, p, limit, indirect_num, indirect_gen);
+    if (*p == '/')
+        return pdfi_read_name_fast(ctx, s, p, limit, indirect_num, indirect_gen);
+    if (!(pdfi_char_class[*p] & (CC_WHITE | CC_DELIM)))
+        return pdfi_read_keyword_fast(ctx, s, p, limit, indirect_num, indirect_gen);
+    return 0;
+}
+
 /* This function reads from the given stream, at the current offset in the stream,
  * a single PDF 'token' and returns it on the stack.
  */
@@ -1013,6 +1205,10 @@ int pdfi_read_token(pdf_context *ctx, pdf_c_stream *s, uint32_t indirect_num, ui
 rescan:
     pdfi_skip_white(ctx, s);
 
+    code = pdfi_read_token_fast(ctx, s, indirect_num, indirect_gen);
+    if (code != 0)
+        return code;
+
     c = pdfi_read_byte(ctx, s);
     if (c == EOFC)
         return 0;
@@ -120,6 +120,20 @@ pdfi_name_cmp(const pdf_name *n1, const pdf_name *n2)
     return memcmp(n1->data, n2->data, n1->length);
 }
 
+/* Hash the bytes of a name (32-bit FNV-1a), for the name table and dictionary indexes */
+uint32_t
+pdfi_name_hash(const byte *data, uint32_t len)
+{
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 int
 pdfi_string_cmp(const pdf_string *n1, const pdf_string *n2)
 {
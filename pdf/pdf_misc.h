@@ -21,6 +21,7 @@ int pdfi_name_strcmp(const pdf_name *n, const char *s);
 bool pdfi_string_is(const pdf_string *n, const char *s);
 bool pdfi_name_is(const pdf_name *n, const char *s);
 int pdfi_name_cmp(const pdf_name *n1, const pdf_name *n2);
+uint32_t pdfi_name_hash(const byte *data, uint32_t len);
 int pdfi_string_cmp(const pdf_string *n1, const pdf_string *n2);
 int pdfi_string_from_name(pdf_context *ctx, pdf_name *n, char **str, int *len);
 int pdfi_free_string_from_name(pdf_context *ctx, char *str);
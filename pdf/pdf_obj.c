@@ -34,6 +34,13 @@
 /* Objects do not get their data assigned, that's up to the caller, but we do      */
 /* set the length or size fields for composite objects.                             */
 
+/* Numbers are by far the commonest objects in content streams, and nearly all of
+ * them are freed again as soon as the operator which uses them has executed. So
+ * rather than return them to the memory manager we keep a (bounded) free list
+ * of them in the context, see pdfi_free_num().
+ */
+#define PDFI_NUM_POOL_MAX 256
+
 int pdfi_object_alloc(pdf_context *ctx, pdf_obj_type type, unsigned int size, pdf_obj **obj)
 {
     int bytes = 0;
@@ -83,10 +90,17 @@ int pdfi_object_alloc(pdf_context *ctx, pdf_obj_type type, unsigned int size, pd
             code = gs_note_error(gs_error_typecheck);
             goto error_out;
     }
-    *obj = (pdf_obj *)gs_alloc_bytes(ctx->memory, bytes, "pdfi_object_alloc");
-    if (*obj == NULL) {
-        code = gs_note_error(gs_error_VMerror);
-        goto error_out;
+    if ((type == PDF_INT || type == PDF_REAL) && ctx->num_free_list != NULL) {
+        /* While on the free list, the ctx member links to the next entry */
+        *obj = (pdf_obj *)ctx->num_free_list;
+        ctx->num_free_list = (pdf_num *)ctx->num_free_list->ctx;
+        ctx->num_free_count--;
+    } else {
+        *obj = (pdf_obj *)gs_alloc_bytes(ctx->memory, bytes, "pdfi_object_alloc");
+        if (*obj == NULL) {
+            code = gs_note_error(gs_error_VMerror);
+            goto error_out;
+        }
     }
 
     memset(*obj, 0x00, bytes);
@@ -217,6 +231,30 @@ int pdfi_num_alloc(pdf_context *ctx, double d, pdf_num **num)
 /* When an object's reference count is decremented to 0, pdfi_countdown calls      */
 /* pdfi_free_object() to free it.                                                  */
 
+static void pdfi_free_num(pdf_obj *o)
+{
+    pdf_context *ctx = OBJ_CTX(o);
+
+    if (ctx->num_free_count < PDFI_NUM_POOL_MAX) {
+        o->ctx = ctx->num_free_list;
+        ctx->num_free_list = (pdf_num *)o;
+        ctx->num_free_count++;
+    } else
+        gs_free_object(ctx->memory, o, "pdf interpreter object refcount to 0");
+}
+
+/* Actually free the number objects kept for reuse by pdfi_free_num() */
+void pdfi_free_num_pool(pdf_context *ctx)
+{
+    while (ctx->num_free_list != NULL) {
+        pdf_num *next = (pdf_num *)ctx->num_free_list->ctx;
+
+        gs_free_object(ctx->memory, ctx->num_free_list, "pdfi_free_num_pool");
+        ctx->num_free_list = next;
+    }
+    ctx->num_free_count = 0;
+}
+
 static void pdfi_free_namestring(pdf_obj *o)
 {
     /* Currently names and strings are the same, so a single cast is OK */
@@ -266,11 +304,13 @@ void pdfi_free_object(pdf_obj *o)
         case PDF_ARRAY_MARK:
         case PDF_DICT_MARK:
         case PDF_PROC_MARK:
-        case PDF_INT:
-        case PDF_REAL:
         case PDF_INDIRECT:
             gs_free_object(OBJ_MEMORY(o), o, "pdf interpreter object refcount to 0");
             break;
+        case PDF_INT:
+        case PDF_REAL:
+            pdfi_free_num(o);
+            break;
         case PDF_STRING:
         case PDF_NAME:
             pdfi_free_namestring(o);
@@ -18,6 +18,7 @@
 
 int pdfi_object_alloc(pdf_context *ctx, pdf_obj_type type, unsigned int size, pdf_obj **obj);
 void pdfi_free_object(pdf_obj *o);
+void pdfi_free_num_pool(pdf_context *ctx);
 int pdfi_obj_to_string(pdf_context *ctx, pdf_obj *obj, byte **data, int *len);
 int pdfi_obj_dict_to_stream(pdf_context *ctx, pdf_dict *dict, pdf_stream **stream, bool do_convert);
 int pdfi_get_stream_dict(pdf_context *ctx, pdf_stream *stream, pdf_dict **dict);
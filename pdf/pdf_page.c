@@ -756,6 +756,11 @@ int pdfi_page_get_dict(pdf_context *ctx, uint64_t page_num, pdf_dict **dict)
     if (code < 0)
         return code;
 
+    /* If we've seen this page before we don't need to walk the Pages tree */
+    code = pdfi_page_index_get(ctx, page_num, dict);
+    if (code <= 0)
+        goto exit;
+
     if (ctx->PagesTree == NULL) {
         pdf_obj *o = NULL;
         pdf_name *n = NULL;
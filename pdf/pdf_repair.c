@@ -59,18 +59,28 @@ static int pdfi_repair_add_object(pdf_context *ctx, int64_t obj, int64_t gen, gs
     } else {
         if (ctx->xref_table->xref_size < (obj + 1)) {
             xref_entry *new_xrefs;
-
-            new_xrefs = (xref_entry *)gs_alloc_bytes(ctx->memory, (size_t)(obj + 1) * sizeof(xref_entry), "read_xref_stream allocate xref table entries");
+            uint64_t new_size = ctx->xref_table->xref_size * 2;
+
+            /* Objects are usually found in ascending order, so growing the table one
+             * object at a time makes the repair scan quadratic. Grow it geometrically
+             * instead, pdfi_repair_trim_xref() cuts it back down once the scan is done.
+             */
+            if (new_size < obj + 1)
+                new_size = obj + 1;
+            if (new_size > 0x7ffffff / sizeof(xref_entry))
+                new_size = 0x7ffffff / sizeof(xref_entry);
+
+            new_xrefs = (xref_entry *)gs_alloc_bytes(ctx->memory, (size_t)new_size * sizeof(xref_entry), "read_xref_stream allocate xref table entries");
             if (new_xrefs == NULL){
                 pdfi_countdown(ctx->xref_table);
                 ctx->xref_table = NULL;
                 return_error(gs_error_VMerror);
             }
-            memset(new_xrefs, 0x00, (obj + 1) * sizeof(xref_entry));
+            memset(new_xrefs, 0x00, new_size * sizeof(xref_entry));
             memcpy(new_xrefs, ctx->xref_table->xref, ctx->xref_table->xref_size * sizeof(xref_entry));
             gs_free_object(ctx->memory, ctx->xref_table->xref, "reallocated xref entries");
             ctx->xref_table->xref = new_xrefs;
-            ctx->xref_table->xref_size = obj + 1;
+            ctx->xref_table->xref_size = new_size;
         }
     }
     ctx->xref_table->xref[obj].compressed = false;
@@ -81,6 +91,66 @@ static int pdfi_repair_add_object(pdf_context *ctx, int64_t obj, int64_t gen, gs
     return 0;
 }
 
+/* Drop the unused slack left at the end of the xref by the geometric growth in
+ * pdfi_repair_add_object(), but never shrink below the size the table had before the repair.
+ */
+static void pdfi_repair_trim_xref(pdf_context *ctx, uint64_t min_size)
+{
+    uint64_t size;
+
+    if (ctx->xref_table == NULL)
+        return;
+
+    size = ctx->xref_table->xref_size;
+    while (size > min_size && ctx->xref_table->xref[size - 1].object_num == 0)
+        size--;
+    ctx->xref_table->xref_size = size;
+}
+
+/* Consume the stream data up to and including the next 'endstream'. Stream data is
+ * normally most of a file, so whenever possible search the stream buffer directly
+ * rather than reading it a byte at a time. Returns 0 if 'endstream' was found,
+ * EOFC if we ran out of file, or a negative error.
+ */
+static int pdfi_repair_skip_to_endstream(pdf_context *ctx, pdf_c_stream *s)
+{
+    static const char test[] = "endstream";
+    int index = 0;
+
+    do {
+        int c;
+
+        if (index == 0 && s->unread_size == 0 && sbufavailable(s->s) >= 9) {
+            const byte *start = sbufptr(s->s);
+            const byte *limit = start + sbufavailable(s->s) - 8;
+            const byte *p = start;
+
+            while ((p = memchr(p, test[0], limit - p)) != NULL) {
+                if (memcmp(p, test, 9) == 0) {
+                    (void)sbufskip(s->s, p + 9 - start);
+                    return 0;
+                }
+                p++;
+            }
+            /* The last 8 bytes might be the start of a match which crosses the end
+             * of the buffer, leave them for the byte at a time code below.
+             */
+            (void)sbufskip(s->s, limit - start);
+        }
+
+        c = pdfi_read_byte(ctx, s);
+        if (c < 0)
+            return c;
+        if (c == test[index])
+            index++;
+        else if (c == test[0]) /* Pesky 'e' appears twice */
+            index = 1;
+        else
+            index = 0;
+    } while (index < 9);
+    return 0;
+}
+
 int pdfi_repair_file(pdf_context *ctx)
 {
     int code = 0;
@@ -88,12 +158,17 @@ int pdfi_repair_file(pdf_context *ctx)
     int64_t object_num = 0, generation_num = 0;
     int i;
     gs_offset_t outer_saved_offset[3];
+    uint64_t xref_size = 0;
 
     if (ctx->repaired) {
         pdfi_set_error(ctx, 0, NULL, E_PDF_UNREPAIRABLE, "pdfi_repair_file", (char *)"%% Trying to repair file for second time -- unrepairable");
         return_error(gs_error_undefined);
     }
 
+    /* We only have the first part of a linearized file, there's nothing to repair yet */
+    if (ctx->first_page_only)
+        return_error(gs_error_undefined);
+
     saved_offset = pdfi_unread_tell(ctx);
 
     ctx->repaired = true;
@@ -101,6 +176,8 @@ int pdfi_repair_file(pdf_context *ctx)
         return code;
 
     ctx->repairing = true;
+    if (ctx->xref_table != NULL)
+        xref_size = ctx->xref_table->xref_size;
 
     pdfi_clearstack(ctx);
 
@@ -231,22 +308,9 @@ int pdfi_repair_file(pdf_context *ctx)
                                     break;
                                 } else {
                                     if (k == PDF_TOKEN_AS_OBJ(TOKEN_STREAM)) {
-                                        static const char test[] = "endstream";
-                                        int index = 0;
-
-                                        do {
-                                            int c = pdfi_read_byte(ctx, ctx->main_stream);
-                                            if (c == EOFC)
-                                                break;
-                                            if (c < 0)
-                                                goto exit;
-                                            if (c == test[index])
-                                                index++;
-                                            else if (c == test[0]) /* Pesky 'e' appears twice */
-                                                index = 1;
-                                            else
-                                                index = 0;
-                                        } while (index < 9);
+                                        int c = pdfi_repair_skip_to_endstream(ctx, ctx->main_stream);
+                                        if (c < 0 && c != EOFC)
+                                            goto exit;
                                         do {
                                             code = pdfi_read_bare_keyword(ctx, ctx->main_stream);
                                             if (code == gs_error_VMerror || code == gs_error_ioerror)
@@ -323,6 +387,7 @@ int pdfi_repair_file(pdf_context *ctx)
 
     pdfi_seek(ctx, ctx->main_stream, 0, SEEK_SET);
     ctx->main_stream->eof = false;
+    pdfi_repair_trim_xref(ctx, xref_size);
 
     /* Second pass, examine every object we have located to see if its an ObjStm */
     if (ctx->xref_table == NULL || ctx->xref_table->xref_size < 1) {
@@ -479,6 +544,7 @@ int pdfi_repair_file(pdf_context *ctx)
 exit:
     if (code > 0)
         code = 0;
+    pdfi_repair_trim_xref(ctx, xref_size);
     pdfi_seek(ctx, ctx->main_stream, saved_offset, SEEK_SET);
     ctx->main_stream->eof = false;
     ctx->repairing = false;
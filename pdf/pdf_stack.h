@@ -87,6 +87,16 @@ static inline void pdfi_countdown_impl(pdf_obj *o)
             entry = next;
         }
     }
+    if (ctx != NULL && ctx->res_cache_entries != 0) {
+        pdf_obj_cache_entry *entry = ctx->res_cache_LRU, *next;
+
+        while(entry) {
+            next = entry->next;
+            if (entry->o->object_num != 0 && entry->o->object_num == o->object_num)
+                outprintf(ctx->memory, "Freeing object %d, UID %lu, but there is still a cache entry!\n", o->object_num, o->UID);
+            entry = next;
+        }
+    }
     outprintf(ctx->memory, "Freeing object %d, UID %lu\n", o->object_num, o->UID);
 #endif
 #ifdef DEBUG
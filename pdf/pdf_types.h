@@ -216,7 +216,8 @@ typedef struct pdf_dict_s {
     uint64_t entries;
     pdf_dict_entry *list;
     bool dict_written;  /* Has dict been written (for pdfwrite) */
-    bool is_sorted;     /* true if the dictionary has been sorted by Key, for faster searching */
+    uint32_t *hash;     /* Hash index of the keys for large dictionaries, or NULL, see pdf_dict.c */
+    uint32_t hash_size;
 } pdf_dict;
 
 typedef struct pdf_stream_s {
@@ -250,8 +251,16 @@ typedef struct pdf_obj_cache_entry_s {
     void *next;
     void *previous;
     pdf_obj *o;
+    uint32_t size;      /* Estimated size in bytes, for PDFCACHEBYTES */
+    bool resource;      /* true if the entry is in the resource pool */
 }pdf_obj_cache_entry;
 
+/* A decoded ObjStm, see pdf_deref.c */
+typedef struct pdfi_objstm_s pdfi_objstm;
+
+/* The remembered result of checking a Resources dictionary, see pdf_check.c */
+typedef struct pdfi_check_memo_s pdfi_check_memo;
+
 /* The compressed and uncompressed xref entries are identical, they only differ
  * in the names used for the variables. Its simply less confusing not to overload
  * the names.
@@ -16,6 +16,7 @@
 /* xref parsing */
 
 #include "pdf_int.h"
+#include "stream.h"
 #include "pdf_stack.h"
 #include "pdf_xref.h"
 #include "pdf_file.h"
@@ -397,6 +398,10 @@ static int pdfi_process_xref_stream(pdf_context *ctx, pdf_stream *stream_obj, pd
 
     pdfi_close_file(ctx, XRefStrm);
 
+    /* The rest of a linearized file may not have arrived yet, see ghostpdf.h */
+    if (ctx->first_page_only)
+        return 0;
+
     code = pdfi_dict_get_int(ctx, sdict, "Prev", &num);
     if (code == gs_error_undefined)
         return 0;
@@ -719,6 +724,39 @@ static int write_offset(byte *B, gs_offset_t o, unsigned int g, unsigned char fr
     return 0;
 }
 
+/* Parse a well formed 20 byte xref entry in place: 10 digits of offset, 5 digits of
+ * generation, 'n' or 'f' and a two byte EOL. Anything else returns false and is left
+ * for the (much slower) general code in read_xref_section to deal with.
+ */
+static bool read_xref_entry_fast(const byte *B, gs_offset_t *offset, unsigned int *generation_num, unsigned char *free)
+{
+    gs_offset_t o = 0;
+    unsigned int g = 0;
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        if (B[i] < '0' || B[i] > '9')
+            return false;
+        o = o * 10 + (B[i] - '0');
+    }
+    if (B[10] != 0x20)
+        return false;
+    for (i = 11; i < 16; i++) {
+        if (B[i] < '0' || B[i] > '9')
+            return false;
+        g = g * 10 + (B[i] - '0');
+    }
+    if (B[16] != 0x20 || (B[17] != 'n' && B[17] != 'f'))
+        return false;
+    if ((B[19] != 0x0a && B[19] != 0x0d) || (B[18] != 0x0d && B[18] != 0x0a && B[18] != 0x20))
+        return false;
+
+    *offset = o;
+    *generation_num = g;
+    *free = B[17];
+    return true;
+}
+
 static int read_xref_section(pdf_context *ctx, pdf_c_stream *s, uint64_t *section_start, uint64_t *section_size)
 {
     int code = 0, i, j;
@@ -806,42 +844,54 @@ static int read_xref_section(pdf_context *ctx, pdf_c_stream *s, uint64_t *sectio
         gs_offset_t off;
         unsigned int gen;
 
-        bytes = pdfi_read_bytes(ctx, (byte *)Buffer, 1, 20, s);
-        if (bytes < 20)
-            return_error(gs_error_ioerror);
-        j = 19;
-        if ((Buffer[19] != 0x0a && Buffer[19] != 0x0d) || (Buffer[18] != 0x0d && Buffer[18] != 0x0a && Buffer[18] != 0x20))
-            pdfi_set_warning(ctx, 0, NULL, W_PDF_BAD_XREF_ENTRY_SIZE, "read_xref_section", NULL);
-        while (Buffer[j] != 0x0D && Buffer[j] != 0x0A) {
-            pdfi_unread_byte(ctx, s, (byte)Buffer[j]);
-            if (--j < 0) {
-                pdfi_set_warning(ctx, 0, NULL, W_PDF_BAD_XREF_ENTRY_NO_EOL, "read_xref_section", NULL);
-                outprintf(ctx->memory, "Invalid xref entry, line terminator missing.\n");
+        /* Most xref tables are entirely regular, so when the whole entry is sitting
+         * in the stream buffer, parse it there rather than copying it out and using sscanf.
+         */
+        if (s->unread_size == 0 && sbufavailable(s->s) >= 20 &&
+            read_xref_entry_fast(sbufptr(s->s), &off, &gen, &free)) {
+            (void)sbufskip(s->s, 20);
+            if (entry->object_num != 0)
+                continue;
+            entry->u.uncompressed.offset = off;
+            entry->u.uncompressed.generation_num = gen;
+        } else {
+            bytes = pdfi_read_bytes(ctx, (byte *)Buffer, 1, 20, s);
+            if (bytes < 20)
+                return_error(gs_error_ioerror);
+            j = 19;
+            if ((Buffer[19] != 0x0a && Buffer[19] != 0x0d) || (Buffer[18] != 0x0d && Buffer[18] != 0x0a && Buffer[18] != 0x20))
+                pdfi_set_warning(ctx, 0, NULL, W_PDF_BAD_XREF_ENTRY_SIZE, "read_xref_section", NULL);
+            while (Buffer[j] != 0x0D && Buffer[j] != 0x0A) {
+                pdfi_unread_byte(ctx, s, (byte)Buffer[j]);
+                if (--j < 0) {
+                    pdfi_set_warning(ctx, 0, NULL, W_PDF_BAD_XREF_ENTRY_NO_EOL, "read_xref_section", NULL);
+                    outprintf(ctx->memory, "Invalid xref entry, line terminator missing.\n");
+                    code = read_xref_entry_slow(ctx, s, &off, &gen, &free);
+                    if (code < 0)
+                        return code;
+                    code = write_offset((byte *)Buffer, off, gen, free);
+                    if (code < 0)
+                        return code;
+                    j = 19;
+                    break;
+                }
+            }
+            Buffer[j] = 0x00;
+            if (entry->object_num != 0)
+                continue;
+
+            if (sscanf(Buffer, "%"PRIdOFFSET" %d %c", &entry->u.uncompressed.offset, &entry->u.uncompressed.generation_num, &free) != 3) {
+                pdfi_set_warning(ctx, 0, NULL, W_PDF_BAD_XREF_ENTRY_FORMAT, "read_xref_section", NULL);
+                outprintf(ctx->memory, "Invalid xref entry, incorrect format.\n");
+                pdfi_unread(ctx, s, (byte *)Buffer, 20);
                 code = read_xref_entry_slow(ctx, s, &off, &gen, &free);
                 if (code < 0)
                     return code;
                 code = write_offset((byte *)Buffer, off, gen, free);
                 if (code < 0)
                     return code;
-                j = 19;
-                break;
             }
         }
-        Buffer[j] = 0x00;
-        if (entry->object_num != 0)
-            continue;
-
-        if (sscanf(Buffer, "%"PRIdOFFSET" %d %c", &entry->u.uncompressed.offset, &entry->u.uncompressed.generation_num, &free) != 3) {
-            pdfi_set_warning(ctx, 0, NULL, W_PDF_BAD_XREF_ENTRY_FORMAT, "read_xref_section", NULL);
-            outprintf(ctx->memory, "Invalid xref entry, incorrect format.\n");
-            pdfi_unread(ctx, s, (byte *)Buffer, 20);
-            code = read_xref_entry_slow(ctx, s, &off, &gen, &free);
-            if (code < 0)
-                return code;
-            code = write_offset((byte *)Buffer, off, gen, free);
-            if (code < 0)
-                return code;
-        }
 
         entry->compressed = false;
         entry->object_num = i + start;
@@ -937,7 +987,7 @@ static int read_xref(pdf_context *ctx, pdf_c_stream *s)
      * previous xref entries.
      */
     code = pdfi_dict_known(ctx, d, "Prev", &known);
-    if (known) {
+    if (known && !ctx->first_page_only) {
         code = pdfi_dict_get_int(ctx, d, "Prev", &num);
         if (code < 0)
             goto error;
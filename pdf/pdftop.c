@@ -38,6 +38,9 @@ extern const char gp_file_name_list_separator;
 static int pdfi_install_halftone(pdf_context *ctx, gx_device *pdevice);
 static int pdf_impl_add_path(pl_interp_implementation_t *impl, const char *path);
 
+/* A linearization dictionary must be within the first 1024 bytes of the file */
+#define PDF_LINEAR_HEAD_SIZE 1024
+
 /*
  * The PDF interpreter instance is derived from pl_interp_implementation_t.
  */
@@ -49,8 +52,19 @@ typedef struct pdf_interp_instance_s
     pdf_context *ctx;
     gp_file *scratch_file;
     char scratch_name[gp_file_name_sizeof];
+
+    /* For -dPDFProgressive, see pdf_impl_progressive() */
+    gs_offset_t scratch_length;
+    byte linear_head[PDF_LINEAR_HEAD_SIZE];
+    int linear_head_len;
+    pdfi_linearized_t linear;
+    bool linear_checked;
+    bool is_linear;
+    bool first_page_done;
 }pdf_interp_instance_t;
 
+static void pdf_impl_reset_progressive(pdf_interp_instance_t *instance);
+
 extern const char gp_file_name_list_separator;
 
 #define GS_LIB_DEFAULT_STRING GS_STRINGIZE(GS_LIB_DEFAULT)
@@ -133,6 +147,7 @@ pdf_impl_allocate_interp_instance(pl_interp_implementation_t *impl,
     instance->ctx = ctx;
     instance->scratch_file = NULL;
     instance->scratch_name[0] = 0;
+    pdf_impl_reset_progressive(instance);
     instance->memory = pmem;
 
     impl->interp_client_data = instance;
@@ -282,6 +297,61 @@ pdf_impl_process_begin(pl_interp_implementation_t * impl)
     return 0;
 }
 
+/* With -dPDFProgressive, if the input is a linearized file, we draw the first page as
+ * soon as the first page section of the file has been written to the scratch file, rather
+ * than waiting until we have the whole file. The rest of the pages are drawn once the whole
+ * file has arrived, see pdf_impl_process_eof().
+ */
+static int
+pdf_impl_progressive(pdf_interp_instance_t *instance, const byte *data, int len)
+{
+    pdf_context *ctx = instance->ctx;
+    int code;
+
+    instance->scratch_length += len;
+
+    if (!instance->linear_checked) {
+        int n = min(len, PDF_LINEAR_HEAD_SIZE - instance->linear_head_len);
+
+        memcpy(instance->linear_head + instance->linear_head_len, data, n);
+        instance->linear_head_len += n;
+        if (instance->linear_head_len < PDF_LINEAR_HEAD_SIZE)
+            return 0;
+
+        instance->linear_checked = true;
+        instance->is_linear = pdfi_read_linearized_header(ctx, instance->linear_head,
+                                  instance->linear_head_len, &instance->linear) > 0;
+        /* If we aren't going to draw the first page anyway, there's nothing to gain */
+        if (ctx->args.pdfinfo || ctx->args.PageList != NULL || ctx->args.first_page > 1)
+            instance->is_linear = false;
+    }
+
+    if (!instance->is_linear || instance->first_page_done ||
+        instance->scratch_length < instance->linear.first_page_end)
+        return 0;
+
+    /* Whatever happens, we only try this once */
+    instance->is_linear = false;
+    gp_fflush(instance->scratch_file);
+    if (gp_ferror(instance->scratch_file))
+        return 0;
+
+    code = pdfi_process_linearized_first_page(ctx, instance->scratch_name, &instance->linear);
+    if (code > 0)
+        instance->first_page_done = true;
+    return code < 0 ? code : 0;
+}
+
+static void
+pdf_impl_reset_progressive(pdf_interp_instance_t *instance)
+{
+    instance->scratch_length = 0;
+    instance->linear_head_len = 0;
+    instance->linear_checked = false;
+    instance->is_linear = false;
+    instance->first_page_done = false;
+}
+
 /* Parse a cursor-full of data */
 static int
 pdf_impl_process(pl_interp_implementation_t *impl, stream_cursor_read *cursor)
@@ -309,6 +379,16 @@ pdf_impl_process(pl_interp_implementation_t *impl, stream_cursor_read *cursor)
         gs_catch(gs_error_invalidfileaccess, "cannot write to scratch file");
         return e_ExitLanguage;
     }
+
+    if (ctx->args.PDFProgressive)
+    {
+        int code = pdf_impl_progressive(instance, cursor->ptr + 1, avail);
+        if (code < 0)
+        {
+            gs_catch(code, "cannot process PDF file");
+            return e_ExitLanguage;
+        }
+    }
     cursor->ptr = cursor->limit;
 
     return 0;
@@ -344,7 +424,24 @@ pdf_impl_process_eof(pl_interp_implementation_t *impl)
         if_debug0m('|', ctx->memory, "pdf: executing scratch file\n");
         gp_fclose(instance->scratch_file);
         instance->scratch_file = NULL;
-        code = pdfi_process_pdf_file(ctx, instance->scratch_name);
+        if (instance->first_page_done)
+        {
+            /* We've already drawn the first page, see pdf_impl_progressive() */
+            int first_page = ctx->args.first_page;
+
+            if (instance->scratch_length != instance->linear.length)
+                errprintf(ctx->memory, "\n   **** Warning: linearized file has been updated, first page may be out of date.\n");
+            code = 0;
+            if (ctx->args.last_page != 1)
+            {
+                ctx->args.first_page = 2;
+                code = pdfi_process_pdf_file(ctx, instance->scratch_name);
+                ctx->args.first_page = first_page;
+            }
+        }
+        else
+            code = pdfi_process_pdf_file(ctx, instance->scratch_name);
+        pdf_impl_reset_progressive(instance);
         gp_unlink(ctx->memory, instance->scratch_name);
         if (code < 0)
         {
@@ -535,6 +632,21 @@ pdf_impl_set_param(pl_interp_implementation_t *impl,
             if (code < 0)
                 return code;
         }
+        if (argis(param, "PDFCACHEBYTES")) {
+            code = plist_value_get_int(&pvalue, &ctx->args.PDFCacheBytes);
+            if (code < 0)
+                return code;
+        }
+        if (argis(param, "PDFCACHESTATS")) {
+            code = plist_value_get_bool(&pvalue, &ctx->args.PDFCacheStats);
+            if (code < 0)
+                return code;
+        }
+        if (argis(param, "PDFProgressive")) {
+            code = plist_value_get_bool(&pvalue, &ctx->args.PDFProgressive);
+            if (code < 0)
+                return code;
+        }
         if (argis(param, "PDFDEBUG")) {
             code = plist_value_get_bool(&pvalue, &ctx->args.pdfdebug);
             if (code < 0)
@@ -532,6 +532,54 @@ zgetscanconverter(i_ctx_t *i_ctx_p)
     make_int(op, gs_getscanconverter(imemory));
     return 0;
 }
+
+/* <int> .setfillthreads - */
+static int
+zsetfillthreads(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    check_op(1);
+    check_type(*op, t_integer);
+    gs_setfillthreads(imemory, op->value.intval);
+    pop(1);
+    return 0;
+}
+
+/* - .getfillthreads <int> */
+static int
+zgetfillthreads(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    push(1);
+    make_int(op, gs_getfillthreads(imemory));
+    return 0;
+}
+
+/* <bool> .setadaptiveflattening - */
+static int
+zsetadaptiveflattening(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    check_op(1);
+    check_type(*op, t_boolean);
+    gs_setadaptiveflattening(imemory, op->value.boolval);
+    pop(1);
+    return 0;
+}
+
+/* - .getadaptiveflattening <bool> */
+static int
+zgetadaptiveflattening(i_ctx_t *i_ctx_p)
+{
+    os_ptr op = osp;
+
+    push(1);
+    make_bool(op, gs_getadaptiveflattening(imemory));
+    return 0;
+}
 /* ------ Initialization procedure ------ */
 
 const op_def zmisc_a_op_defs[] =
@@ -558,5 +606,9 @@ const op_def zmisc_b_op_defs[] =
     {"0.getCPSImode", zgetCPSImode},
     {"1.setscanconverter", zsetscanconverter},
     {"0.getscanconverter", zgetscanconverter},
+    {"1.setfillthreads", zsetfillthreads},
+    {"0.getfillthreads", zgetfillthreads},
+    {"1.setadaptiveflattening", zsetadaptiveflattening},
+    {"0.getadaptiveflattening", zgetadaptiveflattening},
     op_def_end(0)
 };
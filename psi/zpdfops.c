@@ -709,6 +709,36 @@ error:
     return code;
 }
 
+static int zpdfi_put_int(i_ctx_t *i_ctx_p, ref *dict, const char *key, ps_int value)
+{
+    ref nameref, intref;
+    int code;
+
+    code = names_ref(imemory->gs_lib_ctx->gs_name_table, (const byte *)key, strlen(key), &nameref, 1);
+    if (code < 0)
+        return code;
+    make_int(&intref, value);
+    return dict_put(dict, &nameref, &intref, &i_ctx_p->dict_stack);
+}
+
+/* Add the object cache counters (see -dPDFCACHESTATS) to the .PDFInfo dictionary */
+static int zpdfi_put_cache_stats(i_ctx_t *i_ctx_p, pdf_context *ctx, ref *dict)
+{
+    int code;
+
+    if ((code = zpdfi_put_int(i_ctx_p, dict, "ObjectCacheHits", (ps_int)ctx->hits)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "ObjectCacheMisses", (ps_int)ctx->misses)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "CompressedObjectCacheHits", (ps_int)ctx->compressed_hits)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "CompressedObjectCacheMisses", (ps_int)ctx->compressed_misses)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "ObjectCacheEntries", (ps_int)ctx->cache_entries)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "ObjectCacheBytes", (ps_int)ctx->cache_bytes)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "ObjectCacheEvictions", (ps_int)ctx->cache_evictions)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "ResourceCacheEntries", (ps_int)ctx->res_cache_entries)) < 0 ||
+        (code = zpdfi_put_int(i_ctx_p, dict, "ResourceCacheBytes", (ps_int)ctx->res_cache_bytes)) < 0)
+        return code;
+    return zpdfi_put_int(i_ctx_p, dict, "ResourceCacheEvictions", (ps_int)ctx->res_cache_evictions);
+}
+
 static int zPDFinfo(i_ctx_t *i_ctx_p)
 {
     os_ptr op = osp;
@@ -832,6 +862,8 @@ static int zPDFinfo(i_ctx_t *i_ctx_p)
     else {
         return_error(gs_error_ioerror);
     }
+    if (code >= 0)
+        code = zpdfi_put_cache_stats(i_ctx_p, pdfctx->ctx, op);
     return code;
 
 error:
@@ -1066,6 +1098,18 @@ static int apply_interpreter_params(i_ctx_t *i_ctx_p, pdfctx_t *pdfctx, ref *pdi
         pdfctx->ctx->args.PDFCacheSize = pvalueref->value.intval;
     }
 
+    if (dict_find_string(pdictref, "PDFCACHEBYTES", &pvalueref) > 0) {
+        if (!r_has_type(pvalueref, t_integer))
+            goto error;
+        pdfctx->ctx->args.PDFCacheBytes = pvalueref->value.intval;
+    }
+
+    if (dict_find_string(pdictref, "PDFCACHESTATS", &pvalueref) > 0) {
+        if (!r_has_type(pvalueref, t_boolean))
+            goto error;
+        pdfctx->ctx->args.PDFCacheStats = pvalueref->value.boolval;
+    }
+
     if (dict_find_string(pdictref, "PDFDEBUG", &pvalueref) > 0) {
         if (!r_has_type(pvalueref, t_boolean))
             goto error;